@@ -0,0 +1,140 @@
+"""
+Shared utilities for the SAL benchmark scripts.
+
+Results are written as JSON documents so they may be compared between
+releases. Each document records the environment the benchmark was run in
+alongside the measurements.
+"""
+
+import os
+import sys
+import json
+import time
+import platform
+import tracemalloc
+import statistics
+
+# allow the benchmarks to run from a source checkout
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..')))
+
+import numpy as np
+
+from sal.core.version import VERSION
+
+
+def measure(function, repeat=5, min_time=0.2):
+    """
+    Times a function.
+
+    The function is called repeatedly until min_time seconds have elapsed to
+    form a sample, repeat samples are taken. The time per call of each sample
+    is reported.
+
+    :param function: A callable taking no arguments.
+    :param repeat: The number of samples (default=5).
+    :param min_time: The minimum duration of each sample in seconds (default=0.2).
+    :return: A dictionary of timing statistics in seconds per call.
+    """
+
+    # calibrate the number of calls per sample
+    calls = 1
+    while True:
+        start = time.perf_counter()
+        for _ in range(calls):
+            function()
+        elapsed = time.perf_counter() - start
+        if elapsed >= min_time or calls >= 1 << 20:
+            break
+        calls *= 2 if elapsed <= 0 else max(2, min(10, int(min_time / elapsed) + 1))
+
+    samples = [elapsed / calls]
+    for _ in range(repeat - 1):
+        start = time.perf_counter()
+        for _ in range(calls):
+            function()
+        samples.append((time.perf_counter() - start) / calls)
+
+    return {
+        'calls': calls,
+        'best': min(samples),
+        'median': statistics.median(samples),
+        'mean': statistics.mean(samples),
+        'stdev': statistics.stdev(samples) if len(samples) > 1 else 0.0
+    }
+
+
+def peak_memory(function):
+    """
+    Returns the peak memory allocated by a single call of a function.
+
+    Numpy allocations are traced, so the peak includes array buffers.
+
+    :param function: A callable taking no arguments.
+    :return: The peak allocation in bytes.
+    """
+
+    tracemalloc.start()
+    try:
+        tracemalloc.reset_peak()
+        baseline, _ = tracemalloc.get_traced_memory()
+        function()
+        _, peak = tracemalloc.get_traced_memory()
+    finally:
+        tracemalloc.stop()
+    return max(0, peak - baseline)
+
+
+def percentiles(samples, points=(50, 90, 99)):
+    """
+    Returns the percentiles of a list of samples.
+
+    :param samples: A list of numbers.
+    :param points: The percentiles to report (default=(50, 90, 99)).
+    :return: A dictionary of 'p<point>' to value.
+    """
+
+    if not samples:
+        return {'p{}'.format(point): None for point in points}
+    values = np.percentile(np.array(samples), points)
+    return {'p{}'.format(point): float(value) for point, value in zip(points, values)}
+
+
+def environment():
+    """
+    Returns a description of the benchmark environment.
+    """
+
+    return {
+        'sal': VERSION,
+        'python': platform.python_version(),
+        'implementation': platform.python_implementation(),
+        'numpy': np.__version__,
+        'platform': platform.platform(),
+        'processor': platform.processor() or platform.machine(),
+        'cpus': os.cpu_count(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime())
+    }
+
+
+def write_results(name, results, path=None):
+    """
+    Writes the benchmark results as a JSON document.
+
+    :param name: The benchmark name.
+    :param results: A JSON serialisable list of results.
+    :param path: The output file path, '-' or None writes to stdout (default=None).
+    """
+
+    document = {
+        'benchmark': name,
+        'environment': environment(),
+        'results': results
+    }
+
+    text = json.dumps(document, indent=2)
+    if not path or path == '-':
+        print(text)
+        return
+
+    with open(path, 'w') as f:
+        f.write(text + '\n')
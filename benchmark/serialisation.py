@@ -0,0 +1,174 @@
+"""
+Serialisation benchmark.
+
+Measures the encode and decode throughput and peak memory of the SAL
+serialiser for Array, Signal and Dictionary objects across a range of sizes
+and data types. Each object is measured with the JSON and binary transports:
+
+  - serialise: object to JSON document (arrays base64 encoded)
+  - deserialise: JSON document to object
+  - encode_binary: object to binary envelope
+  - decode_binary: binary envelope to object
+  - build: object dictionary to object (data class construction only)
+
+Usage::
+
+    python benchmark/serialisation.py [--quick] [--output results.json]
+"""
+
+import argparse
+import itertools
+
+import numpy as np
+
+from common import measure, peak_memory, write_results
+
+from sal.core.object import build
+from sal.core.serialise import serialise, deserialise, encode_binary, decode_binary
+from sal.dataclass import *
+
+# array element counts
+SIZES = (1000, 100000, 10000000)
+QUICK_SIZES = (1000, 100000)
+
+# array data types
+DTYPES = ('int16', 'int32', 'float32', 'float64')
+
+# dictionary item counts
+ITEMS = (10, 100, 1000)
+
+# signal error and mask variants
+ERRORS = ('none', 'constant', 'symmetric', 'asymmetric')
+MASKS = ('none', 'scalar', 'array')
+
+
+def make_array(size, dtype):
+    data = np.arange(size, dtype=dtype)
+    return Array(shape=data.shape, data=data, dtype=dtype)
+
+
+def make_signal(size, dtype, error, mask):
+
+    data = np.sin(np.linspace(0, 100, size)).astype(dtype)
+    time = CalculatedDimension(length=size, start=0.0, step=1e-6, units='s', temporal=True)
+
+    if error == 'constant':
+        error = ConstantError(lower=0.1, upper=0.1)
+    elif error == 'symmetric':
+        error = SymmetricArrayError(np.full(size, 0.1, dtype=dtype), dtype=dtype)
+    elif error == 'asymmetric':
+        error = AsymmetricArrayError(np.full(size, 0.1, dtype=dtype), np.full(size, 0.2, dtype=dtype), dtype=dtype)
+    else:
+        error = None
+
+    if mask == 'scalar':
+        mask = ScalarStatus(0, ['ok', 'invalid'])
+    elif mask == 'array':
+        mask = ArrayStatus(np.arange(size, dtype=np.uint8) % 2, ['ok', 'invalid'])
+    else:
+        mask = None
+
+    return Signal([time], data=data, dtype=dtype, error=error, mask=mask, units='V')
+
+
+def make_dictionary(items):
+    d = Dictionary()
+    for index in range(items):
+        d['item_{}'.format(index)] = float(index) if index % 2 else 'value_{}'.format(index)
+    return d
+
+
+def payload(obj):
+    """
+    Returns the number of array data bytes held by an object.
+    """
+
+    def count(d):
+        total = 0
+        for value in d.values():
+            if isinstance(value, dict):
+                total += count(value)
+            elif isinstance(value, np.ndarray):
+                total += value.nbytes
+        return total
+
+    return count(obj.to_dict())
+
+
+def operations(obj):
+    """
+    Returns the benchmarked operations for an object as (name, callable) pairs.
+    """
+
+    document = serialise(obj)
+    buffers = []
+    envelope = encode_binary(serialise(obj, buffers), buffers)
+    d = obj.to_dict()
+
+    def to_binary():
+        b = []
+        return encode_binary(serialise(obj, b), b)
+
+    def from_binary():
+        return deserialise(*decode_binary(bytearray(envelope)))
+
+    return (
+        ('serialise', lambda: serialise(obj)),
+        ('deserialise', lambda: deserialise(document)),
+        ('encode_binary', to_binary),
+        ('decode_binary', from_binary),
+        ('build', lambda: build(d)),
+    )
+
+
+def cases(quick=False):
+    """
+    Generates the benchmark cases as (description, object) pairs.
+    """
+
+    sizes = QUICK_SIZES if quick else SIZES
+    dtypes = DTYPES[-1:] if quick else DTYPES
+
+    for size, dtype in itertools.product(sizes, dtypes):
+        yield {'class': 'array', 'size': size, 'dtype': dtype}, make_array(size, dtype)
+
+    for size, dtype, error, mask in itertools.product(sizes, dtypes, ERRORS, MASKS):
+        yield {'class': 'signal', 'size': size, 'dtype': dtype, 'error': error, 'mask': mask}, make_signal(size, dtype, error, mask)
+
+    for items in ITEMS:
+        yield {'class': 'dictionary', 'items': items}, make_dictionary(items)
+
+
+def run(quick=False, repeat=5, min_time=0.2):
+
+    results = []
+    for description, obj in cases(quick):
+        nbytes = payload(obj)
+        for name, function in operations(obj):
+            timing = measure(function, repeat, min_time)
+            result = dict(description)
+            result.update({
+                'operation': name,
+                'bytes': nbytes,
+                'time': timing,
+                'throughput': nbytes / timing['best'] if nbytes and timing['best'] > 0 else None,
+                'peak_memory': peak_memory(function)
+            })
+            results.append(result)
+    return results
+
+
+def main():
+
+    parser = argparse.ArgumentParser(description='Benchmarks the SAL serialiser.')
+    parser.add_argument('--quick', action='store_true', help='run a reduced set of cases')
+    parser.add_argument('--repeat', type=int, default=5, help='number of samples per measurement')
+    parser.add_argument('--min-time', type=float, default=0.2, help='minimum duration of each sample in seconds')
+    parser.add_argument('--output', default=None, help='output JSON file (default: stdout)')
+    args = parser.parse_args()
+
+    write_results('serialisation', run(args.quick, args.repeat, args.min_time), args.output)
+
+
+if __name__ == '__main__':
+    main()
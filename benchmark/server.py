@@ -0,0 +1,225 @@
+"""
+End-to-end server benchmark.
+
+Runs a SAL server in-process and measures
+the throughput and latency of list, get and put operations made by a
+number of concurrent clients. The memory provider, the filesystem provider
+and the filesystem provider behind a memory cache are measured, filesystem
+trees are held in a temporary directory (on /dev/shm where available).
+Each client uses its own SALClient and
+thread. The server is hosted by the threaded werkzeug development server,
+so the results are relative measures for tracking changes between releases
+rather than an estimate of production capacity.
+
+To measure a deployment, e.g. gunicorn workers behind a proxy, pass the
+server URL with --host. The workload is then run against that server, the
+benchmark tree is written under /benchmark. Production capacity and the
+scaling with worker count are measured by comparing runs against
+deployments with different numbers of workers.
+
+Usage::
+
+    python benchmark/server.py [--quick] [--host URL] [--output results.json]
+"""
+
+import os
+import shutil
+import tempfile
+import argparse
+import itertools
+import threading
+import time
+
+import numpy as np
+from werkzeug.serving import make_server
+
+from common import percentiles, write_results
+
+from sal.client import SALClient
+from sal.server import SALServer
+from sal.server.providers import FilesystemPersistence, MemoryPersistence, CachedPersistence
+from sal.core.object import Branch
+from sal.dataclass import *
+
+# numbers of concurrent clients
+CLIENTS = (1, 4, 16)
+QUICK_CLIENTS = (1, 4)
+
+# number of leaf nodes in the benchmark tree
+NODES = 64
+
+# persistence provider factories, each is called with a temporary directory path
+PROVIDERS = (
+    lambda path: MemoryPersistence(),
+    lambda path: FilesystemPersistence(path),
+    lambda path: CachedPersistence(FilesystemPersistence(path)),
+)
+
+# signal lengths
+SIZES = (1000, 1000000)
+QUICK_SIZES = (1000,)
+
+
+def make_signal(size):
+    time_dimension = CalculatedDimension(length=size, start=0.0, step=1e-6, units='s', temporal=True)
+    return Signal([time_dimension], data=np.sin(np.linspace(0, 100, size)), units='V')
+
+
+class Server:
+    """
+    Runs a SAL server on a local port in a background thread.
+    """
+
+    def __init__(self, factory):
+        self.path = tempfile.mkdtemp(prefix='sal-benchmark-', dir='/dev/shm' if os.path.isdir('/dev/shm') else None)
+        self.provider = factory(self.path)
+        self.server = make_server('127.0.0.1', 0, SALServer(self.provider), threaded=True)
+        self.host = 'http://127.0.0.1:{}'.format(self.server.server_port)
+        self.thread = threading.Thread(target=self.server.serve_forever, daemon=True)
+
+    def __enter__(self):
+        self.thread.start()
+        return self
+
+    def __exit__(self, *exc):
+        self.server.shutdown()
+        self.thread.join()
+        shutil.rmtree(self.path, ignore_errors=True)
+
+
+def populate(host, size):
+    client = SALClient(host)
+    client.put('/benchmark', Branch('Benchmark data.'))
+    for index in range(NODES):
+        client.put('/benchmark/signal_{}'.format(index), make_signal(size))
+    client.close()
+
+
+def workload(operation, size):
+    """
+    Returns a function performing one operation with a client.
+    """
+
+    signal = make_signal(size)
+
+    def perform(client, index):
+        path = '/benchmark/signal_{}'.format(index % NODES)
+        if operation == 'list':
+            client.list(path)
+        elif operation == 'get':
+            client.get(path)
+        elif operation == 'get_summary':
+            client.get(path, summary=True)
+        elif operation == 'put':
+            client.put('/benchmark/put_{}'.format(index % NODES), signal)
+
+    return perform
+
+
+def run_clients(host, perform, clients, duration, binary):
+    """
+    Runs the workload with concurrent clients for a fixed duration.
+
+    :return: A tuple of (completed operations, failed operations, latency samples, elapsed time).
+    """
+
+    latencies = []
+    failures = [0]
+    lock = threading.Lock()
+    barrier = threading.Barrier(clients + 1)
+    stop = threading.Event()
+
+    def worker(number):
+        client = SALClient(host, binary_transport=binary)
+        samples = []
+        failed = 0
+        index = number
+        barrier.wait()
+        while not stop.is_set():
+            start = time.perf_counter()
+            try:
+                perform(client, index)
+            except Exception:
+                failed += 1
+            else:
+                samples.append(time.perf_counter() - start)
+            index += clients
+        client.close()
+        with lock:
+            latencies.extend(samples)
+            failures[0] += failed
+
+    threads = [threading.Thread(target=worker, args=(number,)) for number in range(clients)]
+    for thread in threads:
+        thread.start()
+
+    barrier.wait()
+    start = time.perf_counter()
+    time.sleep(duration)
+    stop.set()
+    for thread in threads:
+        thread.join()
+    elapsed = time.perf_counter() - start
+
+    return len(latencies), failures[0], latencies, elapsed
+
+
+def measure(host, provider, size, client_counts, duration):
+    """
+    Runs each workload against a populated server.
+
+    :return: A list of result dictionaries.
+    """
+
+    results = []
+    for operation in ('list', 'get', 'get_summary', 'put'):
+        for binary in (False, True):
+            for clients in client_counts:
+                completed, failed, latencies, elapsed = run_clients(host, workload(operation, size), clients, duration, binary)
+                results.append({
+                    'provider': provider,
+                    'operation': operation,
+                    'size': size,
+                    'transport': 'binary' if binary else 'json',
+                    'clients': clients,
+                    'operations': completed,
+                    'failures': failed,
+                    'throughput': completed / elapsed,
+                    'latency': percentiles(latencies)
+                })
+    return results
+
+
+def run(quick=False, duration=5.0, host=None):
+
+    results = []
+    sizes = QUICK_SIZES if quick else SIZES
+    client_counts = QUICK_CLIENTS if quick else CLIENTS
+
+    if host:
+        for size in sizes:
+            populate(host, size)
+            results.extend(measure(host, host, size, client_counts, duration))
+        return results
+
+    for size, factory in itertools.product(sizes, PROVIDERS):
+        with Server(factory) as server:
+            populate(server.host, size)
+            results.extend(measure(server.host, server.provider.NAME, size, client_counts, duration))
+    return results
+
+
+def main():
+
+    parser = argparse.ArgumentParser(description='Benchmarks SAL server operations end-to-end.')
+    parser.add_argument('--quick', action='store_true', help='run a reduced set of cases')
+    parser.add_argument('--duration', type=float, default=5.0, help='duration of each measurement in seconds')
+    parser.add_argument('--host', default=None, help='URL of a running server to measure instead of in-process servers')
+    parser.add_argument('--output', default=None, help='output JSON file (default: stdout)')
+    args = parser.parse_args()
+
+    write_results('server', run(args.quick, args.duration, args.host), args.output)
+
+
+if __name__ == '__main__':
+    main()
@@ -1 +1,2 @@
-from .main import SALClient
\ No newline at end of file
+from .main import SALClient
+from .cache import ObjectCache
@@ -0,0 +1,260 @@
+"""
+Local content cache for the SAL Python client.
+
+Revisioned nodes are immutable once written, so the objects returned for an
+explicit revision may be cached indefinitely. Objects are held as binary
+envelopes (see sal.core.serialise) in a memory LRU and, optionally, in an
+on-disk store that persists between sessions.
+"""
+
+import os
+import hashlib
+import tempfile
+import threading
+from collections import OrderedDict
+
+# The path to the default on-disk cache directory.
+_DEFAULT_CACHE_PATH = '.sal/cache'
+
+# Default cache size limits in bytes.
+_DEFAULT_MEMORY_SIZE = 256 * 1024 * 1024
+_DEFAULT_DISK_SIZE = 4 * 1024 * 1024 * 1024
+
+# Extension of the envelope files held by the disk store.
+_CACHE_FILE_EXTENSION = '.salb'
+
+# Number of writes after which the disk store is rescanned, accounting for files written by other clients.
+_DISK_SCAN_INTERVAL = 256
+
+
+class ObjectCache:
+    """
+    A two level cache of serialised data objects.
+
+    Items are stored as bytes under a string key. Recently used items are
+    held in memory, the least recently used items are evicted once the
+    memory_size limit is reached. If the disk store is enabled, items are
+    also written to the cache directory and remain available to later
+    sessions. The least recently written files are removed once the
+    disk_size limit is exceeded.
+
+    By default the disk store is located in $HOME/.sal/cache, an alternate
+    path may be supplied. The disk store may be disabled by setting disk to
+    False.
+
+    The cache may be shared between threads and clients.
+
+    :param memory_size: The maximum size of the memory cache in bytes (default=256MB).
+    :param disk: Enable the disk store (default=True).
+    :param path: The disk store directory (default=$HOME/.sal/cache).
+    :param disk_size: The maximum size of the disk store in bytes (default=4GB).
+    """
+
+    def __init__(self, memory_size=_DEFAULT_MEMORY_SIZE, disk=True, path=None, disk_size=_DEFAULT_DISK_SIZE):
+
+        memory_size = int(memory_size)
+        disk_size = int(disk_size)
+        if memory_size < 0 or disk_size < 0:
+            raise ValueError('Cache sizes cannot be negative.')
+
+        self.memory_size = memory_size
+        self.disk_size = disk_size
+        self.path = (path or os.path.join(os.path.expanduser('~'), _DEFAULT_CACHE_PATH)) if disk else None
+
+        self._items = OrderedDict()
+        self._size = 0
+        self._lock = threading.Lock()
+        self._disk_lock = threading.Lock()
+
+        # the disk store size is tracked between scans, None until the store is first scanned
+        self._disk_used = None
+        self._disk_writes = 0
+
+        self.hits = 0
+        self.misses = 0
+
+    def get(self, key):
+        """
+        Returns the item stored under the key.
+
+        Items found in the disk store are promoted to the memory cache.
+
+        :param key: The item key string.
+        :return: The item bytes or None if the item is not cached.
+        """
+
+        with self._lock:
+            data = self._items.get(key)
+            if data is not None:
+                self._items.move_to_end(key)
+                self.hits += 1
+                return data
+
+        data = self._read_disk(key)
+        with self._lock:
+            if data is None:
+                self.misses += 1
+                return None
+            self.hits += 1
+        self._store_memory(key, data)
+        return data
+
+    def put(self, key, data):
+        """
+        Stores an item under the key.
+
+        :param key: The item key string.
+        :param data: The item bytes.
+        """
+
+        data = bytes(data)
+        self._store_memory(key, data)
+        self._write_disk(key, data)
+
+    def clear(self, disk=True):
+        """
+        Removes all items from the cache.
+
+        :param disk: Also clear the disk store (default=True).
+        """
+
+        with self._lock:
+            self._items.clear()
+            self._size = 0
+
+        if disk and self.path:
+            with self._disk_lock:
+                for name, _, _ in self._disk_files():
+                    try:
+                        os.remove(os.path.join(self.path, name))
+                    except OSError:
+                        pass
+                self._disk_used = None
+
+    def _store_memory(self, key, data):
+        """
+        Adds an item to the memory cache, evicting the least recently used items as required.
+        """
+
+        if len(data) > self.memory_size:
+            return
+
+        with self._lock:
+            previous = self._items.pop(key, None)
+            if previous is not None:
+                self._size -= len(previous)
+
+            self._items[key] = data
+            self._size += len(data)
+
+            while self._size > self.memory_size:
+                _, evicted = self._items.popitem(last=False)
+                self._size -= len(evicted)
+
+    def _read_disk(self, key):
+        """
+        Reads an item from the disk store.
+        """
+
+        if not self.path:
+            return None
+
+        try:
+            with open(self._filename(key), 'rb') as f:
+                return f.read()
+        except OSError:
+            return None
+
+    def _write_disk(self, key, data):
+        """
+        Writes an item to the disk store.
+
+        The file is written to a temporary file and moved into place so
+        readers never observe a partially written item.
+
+        The size of the store is tracked as items are written, the store is
+        only scanned when the size limit is exceeded or every
+        _DISK_SCAN_INTERVAL writes.
+        """
+
+        if not self.path or len(data) > self.disk_size:
+            return
+
+        filename = self._filename(key)
+        try:
+            os.makedirs(self.path, exist_ok=True)
+            try:
+                replaced = os.stat(filename).st_size
+            except OSError:
+                replaced = 0
+
+            handle, temporary = tempfile.mkstemp(dir=self.path, suffix='.tmp')
+            try:
+                with os.fdopen(handle, 'wb') as f:
+                    f.write(data)
+                os.replace(temporary, filename)
+            except OSError:
+                os.remove(temporary)
+                raise
+        except OSError:
+            # the disk store is an optimisation, failing to write is not an error
+            return
+
+        with self._disk_lock:
+            self._disk_writes += 1
+            if self._disk_used is not None and self._disk_writes < _DISK_SCAN_INTERVAL:
+                self._disk_used += len(data) - replaced
+                if self._disk_used <= self.disk_size:
+                    return
+            self._prune_disk()
+
+    def _prune_disk(self):
+        """
+        Scans the disk store and removes the oldest files until it is within the size limit.
+
+        The disk lock must be held by the caller.
+        """
+
+        files = sorted(self._disk_files(), key=lambda item: item[2])
+        size = sum(item[1] for item in files)
+        for name, length, _ in files:
+            if size <= self.disk_size:
+                break
+            try:
+                os.remove(os.path.join(self.path, name))
+                size -= length
+            except OSError:
+                pass
+
+        self._disk_used = size
+        self._disk_writes = 0
+
+    def _disk_files(self):
+        """
+        Returns a list of (name, size, modification time) tuples for the files in the disk store.
+        """
+
+        files = []
+        try:
+            entries = os.scandir(self.path)
+        except OSError:
+            return files
+
+        with entries:
+            for entry in entries:
+                if not entry.name.endswith(_CACHE_FILE_EXTENSION):
+                    continue
+                try:
+                    stat = entry.stat()
+                except OSError:
+                    continue
+                files.append((entry.name, stat.st_size, stat.st_mtime))
+        return files
+
+    def _filename(self, key):
+        """
+        Returns the disk store filename for a key.
+        """
+
+        digest = hashlib.sha256(key.encode('utf-8')).hexdigest()
+        return os.path.join(self.path, digest + _CACHE_FILE_EXTENSION)
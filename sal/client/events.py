@@ -0,0 +1,200 @@
+"""
+Change event subscriptions for the SAL Python client.
+
+The server streams the writes made to the tree as server-sent events (see
+the /events resource of the server). A Subscription reads the stream and
+reconnects if the connection is lost, resuming from the last event received.
+"""
+
+import json
+import time
+
+from sal.core.time import decode_timestamp
+
+# Seconds to wait before reconnecting if the server does not specify a delay.
+_DEFAULT_RECONNECT_DELAY = 3.0
+
+
+class Event:
+    """
+    A change to the tree reported by the server.
+
+    The operation is one of:
+
+        * 'put': the node at path was created or updated.
+        * 'copy': a node was copied to path, the subtree at path was replaced.
+        * 'delete': the node at path and its descendants were deleted.
+        * 'revision': the tree was modified by another server process, the
+          modified paths are not known.
+        * 'reset': events may have been missed, the subscriber should
+          re-read the nodes it is interested in.
+
+    The path is None for 'revision' and 'reset' events.
+
+    :param id: The event id string.
+    :param operation: The operation name.
+    :param path: The node path or None.
+    :param revision: The head revision of the tree following the operation.
+    :param timestamp: The datetime the event was published.
+    """
+
+    def __init__(self, id, operation, path, revision, timestamp):
+
+        self.id = id
+        self.operation = operation
+        self.path = path
+        self.revision = revision
+        self.timestamp = timestamp
+
+    def __repr__(self):
+        return '<Event {} {} {} revision={}>'.format(self.id, self.operation, self.path, self.revision)
+
+
+class Subscription:
+    """
+    An iterator over the change events of a server event stream.
+
+    Iteration blocks until the next event arrives. If the connection is lost
+    the subscription reconnects and resumes from the last event received,
+    a 'reset' event is returned if events have been missed. Iteration stops
+    once the subscription is closed.
+
+    Subscriptions are created by SALClient.subscribe(), the connection is
+    opened when the subscription is created.
+
+    :param connect: A callable accepting the last event id (or None) and returning a streamed requests Response.
+    :param last_event: The id of the last event received or None (default=None).
+    """
+
+    def __init__(self, connect, last_event=None):
+
+        self.last_event = last_event
+
+        self._connect = connect
+        self._response = None
+        self._lines = None
+        self._delay = _DEFAULT_RECONNECT_DELAY
+        self._closed = False
+
+        # connect immediately so request errors are raised on creation
+        self._open()
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+
+        while not self._closed:
+
+            if self._lines is None:
+                try:
+                    self._open()
+                except ConnectionError:
+                    if self._closed:
+                        break
+                    time.sleep(self._delay)
+                    continue
+
+            try:
+                event = self._read()
+            except Exception:
+                if self._closed:
+                    break
+                event = None
+
+            if event is not None:
+                return event
+
+            # the stream ended, reconnect
+            self._disconnect()
+            if not self._closed:
+                time.sleep(self._delay)
+
+        raise StopIteration
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def close(self):
+        """
+        Closes the subscription and the connection to the server.
+
+        May be called from another thread to stop an iterating thread.
+        """
+
+        self._closed = True
+        self._disconnect()
+
+    @property
+    def closed(self):
+        return self._closed
+
+    def _open(self):
+
+        self._response = self._connect(self.last_event)
+        self._lines = self._response.iter_lines(decode_unicode=True)
+
+    def _disconnect(self):
+
+        response = self._response
+        self._response = None
+        self._lines = None
+        if response is not None:
+            response.close()
+
+    def _read(self):
+        """
+        Reads the next event from the stream.
+
+        :return: An Event or None if the stream ended.
+        """
+
+        name = None
+        event_id = None
+        data = []
+
+        for line in self._lines:
+
+            # a blank line dispatches the event
+            if not line:
+                if data and name is not None:
+                    if event_id is not None:
+                        self.last_event = event_id
+                    return self._decode(json.loads('\n'.join(data)))
+                name = None
+                event_id = None
+                data = []
+                continue
+
+            # comments are used as keep-alives
+            if line.startswith(':'):
+                continue
+
+            field, _, value = line.partition(':')
+            if value.startswith(' '):
+                value = value[1:]
+
+            if field == 'event':
+                name = value
+            elif field == 'data':
+                data.append(value)
+            elif field == 'id':
+                event_id = value
+            elif field == 'retry' and value.isdigit():
+                self._delay = int(value) / 1000
+
+        return None
+
+    @staticmethod
+    def _decode(content):
+
+        return Event(
+            content['id'],
+            content['operation'],
+            content['path'],
+            content['revision'],
+            decode_timestamp(content['timestamp'])
+        )
@@ -0,0 +1,141 @@
+"""
+Lazily loaded data objects for the SAL Python client.
+
+A lazy object is built from a skeleton document (see sal.core.serialise),
+the large arrays omitted from the skeleton are requested from the server
+when first accessed. The object is an instance of a dynamically generated
+subclass of the data class, the omitted array attributes are replaced by
+properties that load the array on first access. Once loaded, an array is
+held by the object like any other attribute.
+"""
+
+import threading
+
+import numpy as np
+
+from sal.core.object import DataClass
+
+# generated lazy classes keyed by (class, attribute names)
+_LAZY_CLASSES = {}
+_LAZY_CLASSES_LOCK = threading.Lock()
+
+
+def defer(obj, placeholders, loader):
+    """
+    Replaces the placeholder arrays of an object with lazily loaded arrays.
+
+    The placeholders are the arrays returned by deserialise() for the
+    arrays omitted from a skeleton document. Each placeholder attribute is
+    replaced by a property that calls the loader with the component key of
+    the array on first access.
+
+    If a placeholder cannot be located, for instance because the data class
+    converted the array, False is returned and the object should be
+    discarded.
+
+    :param obj: A data object built from a skeleton document.
+    :param placeholders: A dictionary of component keys to placeholder arrays.
+    :param loader: A callable returning the array for a component key.
+    :return: True if all the placeholders were replaced, False otherwise.
+    """
+
+    keys = {id(array): key for key, array in placeholders.items()}
+    found = _patch(obj, keys, loader, set())
+    return found == set(placeholders)
+
+
+def is_loaded(obj, name):
+    """
+    Returns True if the named array attribute of an object is loaded.
+
+    Attributes of objects that are not lazy are always loaded.
+
+    :param obj: A data object.
+    :param name: The attribute name.
+    :return: True if the attribute is loaded.
+    """
+
+    deferred = obj.__dict__.get('_deferred', {})
+    return name not in deferred or name in obj.__dict__
+
+
+def is_lazy(obj):
+    """
+    Returns True if an object is a lazy object.
+
+    :param obj: A data object.
+    :return: True if the object was built from a skeleton document.
+    """
+
+    return isinstance(obj, DataClass) and '_deferred' in vars(obj)
+
+
+def _patch(obj, keys, loader, found):
+    """
+    Recursively replaces placeholder attributes, returns the set of component keys replaced.
+    """
+
+    deferred = {}
+    for name, value in list(vars(obj).items()):
+
+        if isinstance(value, np.ndarray) and id(value) in keys:
+            deferred[name] = keys[id(value)]
+
+        elif isinstance(value, DataClass):
+            _patch(value, keys, loader, found)
+
+        elif isinstance(value, (list, tuple)):
+            for item in value:
+                if isinstance(item, DataClass):
+                    _patch(item, keys, loader, found)
+
+    if deferred:
+
+        # drop the placeholders, the properties take over the attribute names
+        for name in deferred:
+            del obj.__dict__[name]
+
+        obj.__dict__['_deferred'] = deferred
+        obj.__dict__['_loader'] = loader
+        obj.__dict__['_load_lock'] = threading.Lock()
+        obj.__class__ = _lazy_class(obj.__class__, tuple(sorted(deferred)))
+        found.update(deferred.values())
+
+    return found
+
+
+def _lazy_class(cls, names):
+    """
+    Returns the lazy subclass of a class with properties for the named attributes.
+    """
+
+    with _LAZY_CLASSES_LOCK:
+        lazy = _LAZY_CLASSES.get((cls, names))
+        if lazy is None:
+            attributes = {name: _lazy_property(name) for name in names}
+            attributes.update({'__module__': cls.__module__, '__qualname__': cls.__qualname__, '__doc__': cls.__doc__})
+            lazy = type(cls.__name__, (cls,), attributes)
+            _LAZY_CLASSES[(cls, names)] = lazy
+        return lazy
+
+
+def _lazy_property(name):
+    """
+    Generates a property that loads an attribute on first access.
+    """
+
+    def getter(self):
+        try:
+            return self.__dict__[name]
+        except KeyError:
+            pass
+
+        with self.__dict__['_load_lock']:
+            if name not in self.__dict__:
+                self.__dict__[name] = self._loader(self._deferred[name])
+            return self.__dict__[name]
+
+    def setter(self, value):
+        self.__dict__[name] = value
+
+    return property(getter, setter)
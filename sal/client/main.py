@@ -2,22 +2,34 @@
 Simple Access Layer (SAL) Python Client
 """
 
+import io
 import os
 import sys
 import warnings
 import getpass
 import configparser
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
 import requests
-from urllib.parse import urlparse
+from requests.adapters import HTTPAdapter
+from urllib.parse import urlparse, urlencode
 
-from sal.core.serialise import serialise, deserialise
+from sal.core.serialise import serialise, deserialise, iter_binary, encode_binary, decode_binary, buffer_targets, EnvelopeReader
+from sal.core.serialise import BINARY_MIME_TYPE, BINARY_CHUNK_SIZE, DEFER_THRESHOLD, ENCODINGS, ENCODING_HEADER
 from sal.core.path import decompose
+from sal.core.selection import Selection
+from sal.core import compression as _compression
 from sal.core.object import Branch, DataObject
 from sal.core import exception
 from sal.core.version import VERSION
+from sal.core.time import encode_timestamp
 from sal.dataclass import *
+from sal.client.cache import ObjectCache
+from sal.client import lazy as _lazy
+from sal.client.events import Event, Subscription
 
-__all__ = ['SALClient']
+__all__ = ['SALClient', 'Selection', 'ObjectCache', 'Event', 'Subscription']
 
 # Supported API version.
 _API_VERSION = 2
@@ -27,13 +39,31 @@ _AUTH_URL = '{host}/auth'
 
 # Operation URLS.
 _LIST_URL = '{host}/data/{path}?revision={revision}'
+_LIST_TREE_URL = '{host}/data/{path}?revision={revision}&depth={depth}'
 _GET_URL = '{host}/data/{path}?object={object}&revision={revision}'
 _PUT_URL = '{host}/data/{path}'
 _DELETE_URL = '{host}/data/{path}'
 _COPY_URL = '{host}/data/{path}?source={source_path}&source_revision={source_revision}'
+_BATCH_URL = '{host}/batch'
+_SEARCH_URL = '{host}/search'
+_EVENTS_URL = '{host}/events'
 
-# Content type recognised by SAL.
+# response header reporting the revision of a returned object
+_REVISION_HEADER = 'X-SAL-Revision'
+
+# Content types recognised by SAL.
 _MIME_JSON = 'application/json'
+_MIME_BINARY = BINARY_MIME_TYPE
+_MIME_EVENTS = 'text/event-stream'
+
+# Accept header used to request the binary transport, JSON is permitted as a fallback.
+_ACCEPT_BINARY = '{}, {};q=0.5'.format(_MIME_BINARY, _MIME_JSON)
+
+# Event stream (connect, read) timeouts in seconds, the server sends keep-alives every 15 seconds.
+_EVENTS_TIMEOUT = (10, 60)
+
+# Default maximum number of pooled connections per host.
+_DEFAULT_POOL_SIZE = 10
 
 # Error to exception mapping table.
 _EXCEPTION_MAP = {
@@ -53,6 +83,24 @@ _AUTH_DEFAULT_CREDENTIALS_PATH = '.sal/credentials'
 _AUTH_TOKEN_CACHE = '.sal/tokens'
 
 
+class _EnvelopeBody:
+    """
+    A re-iterable binary envelope request body.
+
+    Passing an iterable body to requests sends the envelope using chunked
+    transfer encoding, the envelope is generated as it is sent. A new
+    generator is created each time the body is iterated so the request may
+    be repeated e.g. after re-authentication.
+    """
+
+    def __init__(self, document, buffers):
+        self.document = document
+        self.buffers = buffers
+
+    def __iter__(self):
+        return iter_binary(self.document, self.buffers, BINARY_CHUNK_SIZE)
+
+
 class SALClient:
     """
     The Simple Access Layer (SAL) python client.
@@ -120,23 +168,90 @@ class SALClient:
     For developers, when instancing the client it is possible to disable SSL
     certificate checks by setting the verify_https_cert argument to False .
 
+    If the server supports it, data objects are transferred using the binary
+    transport. Arrays are sent as raw buffers rather than BASE64 encoded JSON
+    strings, reducing the transfer size and the decoding cost. The JSON
+    transport can be forced by setting the binary_transport attribute or
+    argument to False.
+
+    Large numerical arrays may be compressed for transfer. By default
+    (compression='auto') the fastest compression scheme supported by both
+    the client and server is used, zstd or lz4 with a byte-shuffle filter.
+    These require the optional zstandard or lz4 packages. A specific scheme
+    may be requested by name (see sal.core.compression.available()) and
+    compression may be disabled by setting the compression attribute or
+    argument to None.
+
+    Dictionaries holding many scalar values are transferred as typed columns,
+    one packed array per value type, if the server supports the columnar
+    encoding. Older servers receive the standard per-value encoding.
+
+    Requests are made through a persistent HTTP session. Connections to the
+    server are kept alive and reused between requests, avoiding a new TCP
+    connection and TLS handshake per request. Up to pool_size connections
+    are pooled per host, one connection is required for each thread making
+    concurrent requests. The client may be shared between threads. Setting
+    keep_alive to False closes the connection after each request. The
+    connection statistics may be inspected via the statistics attribute.
+    The connections are released by calling close().
+
+    Objects obtained with get() may be cached locally by supplying an
+    :class:`~sal.client.cache.ObjectCache` via the cache argument or
+    attribute, or by setting cache to True to use a cache with the default
+    settings (a memory cache backed by a disk store in $HOME/.sal/cache).
+    As revisions are immutable, objects requested for an explicit revision
+    are served from the cache without contacting the server. Requests for
+    the head revision are revalidated with a conditional request carrying
+    the entity tag (ETag) of the cached object, the server only returns the
+    object if the node has been modified. Caching is disabled by default.
+
     :param host: The SAL server URL.
     :param verify_https_cert: Perform SSL certificate validation (default=True).
+    :param binary_transport: Use the binary transport if available (default=True).
+    :param compression: The array compression scheme, 'auto' or None (default='auto').
+    :param pool_size: The maximum number of pooled connections per host (default=10).
+    :param keep_alive: Reuse connections between requests (default=True).
+    :param cache: An ObjectCache, True for a default cache or None to disable caching (default=None).
     :raises ConnectionError: If the client fails to connect to a SAL server.
     """
 
     #: The client version string.
     version = VERSION
 
-    def __init__(self, host, verify_https_cert=True):
+    def __init__(self, host, verify_https_cert=True, binary_transport=True, compression='auto', pool_size=_DEFAULT_POOL_SIZE, keep_alive=True, cache=None):
 
-        # authentication attributes
+        # authentication attributes, the lock serialises token renewal between threads
+        self._auth_lock = threading.RLock()
         self.auth_required = False
         self.auth_token = None
         self.credentials_file = None
         self.prompt_for_password = True
         self.verify_https_cert = verify_https_cert
 
+        # transport attributes
+        self.binary_transport = binary_transport
+        self.content_types = [_MIME_JSON]
+        self.resources = ['data']
+        self.compression = compression
+        self.server_compression = []
+        self.server_encodings = []
+
+        # connection attributes
+        pool_size = int(pool_size)
+        if pool_size < 1:
+            raise ValueError("The connection pool size must be at least 1.")
+        self.pool_size = pool_size
+        self.keep_alive = keep_alive
+        self._session = None
+        self._session_lock = threading.Lock()
+
+        # connection statistics
+        self._statistics_lock = threading.Lock()
+        self.reset_statistics()
+
+        # content cache
+        self.cache = cache
+
         # set and inspect host
         self.host = host
 
@@ -161,6 +276,132 @@ class SALClient:
         self.auth_token = None
         self.credentials_file = None
 
+    @property
+    def cache(self):
+        """
+        The local content cache or None if caching is disabled.
+        """
+        return self._cache
+
+    @cache.setter
+    def cache(self, cache):
+        if cache is True:
+            cache = ObjectCache()
+        elif not cache:
+            cache = None
+        elif not isinstance(cache, ObjectCache):
+            raise TypeError("The cache must be an ObjectCache instance, True or None.")
+        self._cache = cache
+
+    @property
+    def session(self):
+        """
+        The HTTP session used to make requests to the server.
+
+        The session is created on first use and is shared by all threads
+        using the client.
+        """
+
+        # double checked so the lock is only taken while creating the session
+        if self._session is None:
+            with self._session_lock:
+                if self._session is None:
+                    self._session = self._new_session()
+        return self._session
+
+    def _new_session(self):
+        """
+        Creates a HTTP session with a connection pool.
+
+        :return: A requests Session object.
+        """
+
+        session = requests.Session()
+        adapter = HTTPAdapter(pool_connections=self.pool_size, pool_maxsize=self.pool_size)
+        session.mount('http://', adapter)
+        session.mount('https://', adapter)
+        if not self.keep_alive:
+            session.headers['Connection'] = 'close'
+        return session
+
+    def close(self):
+        """
+        Closes the HTTP session, releasing all pooled connections.
+
+        The client may continue to be used, a new session is created on the
+        next request.
+        """
+
+        with self._session_lock:
+            if self._session is not None:
+                connections = self._count_connections(self._session)
+                self._session.close()
+                self._session = None
+                with self._statistics_lock:
+                    self._connections_closed += connections
+
+    @property
+    def statistics(self):
+        """
+        Connection statistics for the HTTP session.
+
+        A dictionary containing the number of requests made, the number of
+        connections opened, the number of requests that reused an existing
+        connection and the total and mean request latency in seconds.
+        Statistics accumulate until reset_statistics() is called.
+        """
+
+        with self._statistics_lock:
+            requests_made = self._requests
+            latency = self._latency
+            connections = self._connections_closed
+
+        # add connections opened by the current session's connection pools
+        session = self._session
+        if session is not None:
+            connections += self._count_connections(session)
+        connections -= self._connections_offset
+
+        return {
+            'requests': requests_made,
+            'connections': connections,
+            'reused': max(0, requests_made - connections),
+            'latency': {
+                'total': latency,
+                'mean': latency / requests_made if requests_made else 0.0
+            }
+        }
+
+    def reset_statistics(self):
+        """
+        Resets the connection statistics.
+        """
+
+        with self._statistics_lock:
+            self._requests = 0
+            self._latency = 0.0
+            self._connections_closed = 0
+            session = self._session
+            self._connections_offset = self._count_connections(session) if session is not None else 0
+
+    @staticmethod
+    def _count_connections(session):
+        """
+        Returns the number of connections opened by a session's connection pools.
+
+        :param session: A requests Session object.
+        :return: Connection count.
+        """
+
+        count = 0
+        for adapter in set(session.adapters.values()):
+            pools = adapter.poolmanager.pools
+            for key in pools.keys():
+                pool = pools.get(key)
+                if pool is not None:
+                    count += pool.num_connections
+        return count
+
     def _check_host(self, url):
         """
         Inspects the specified server to identify if it is a SAL server.
@@ -188,6 +429,10 @@ class SALClient:
             raise ConnectionError('The server is using a newer API than the client recognises, please update your client.')
 
         self.auth_required = content['api']['requires_auth']
+        self.content_types = content['api'].get('content_types', [_MIME_JSON])
+        self.resources = content['api'].get('resources', ['data'])
+        self.server_compression = content['api'].get('compression', [])
+        self.server_encodings = content['api'].get('encodings', [])
 
     def authenticate(self, user=None, password=None, credentials=None):
         """
@@ -343,7 +588,7 @@ class SALClient:
         :param password: Password string.
         """
 
-        response = self._get_response(requests.get,
+        response = self._get_response('GET',
                                       _AUTH_URL.format(host=self.host),
                                       auth=(user, password))
 
@@ -354,7 +599,7 @@ class SALClient:
         except KeyError:
             raise exception.InvalidResponse('The server did not return an authentication token.')
 
-    def list(self, path):
+    def list(self, path, depth=None):
         """
         Returns node meta data for the specific path.
 
@@ -362,8 +607,19 @@ class SALClient:
         If the path identifies a branch node, a BranchReport object is returned.
         For leaf nodes, a LeafReport object is returned.
 
+        If a depth is supplied, a branch node returns a TreeReport describing
+        the subtree in a single request. The depth is the number of branch
+        levels to describe or 'full' for the whole subtree. For example, to
+        obtain the structure of a pulse::
+
+            tree = client.list('/pulse/4000', depth='full')
+            for path, report in tree.walk():
+                print(path, [name for name, _ in report.leaves])
+
         :param path: A valid node path.
-        :return: A :class:`~sal.core.object.BranchReport` or :class:`~sal.core.object.LeafReport` object.
+        :param depth: The number of branch levels to describe, 'full' or None (default=None).
+        :return: A :class:`~sal.core.object.BranchReport`, :class:`~sal.core.object.TreeReport`
+                 or :class:`~sal.core.object.LeafReport` object.
         :raises InvalidPath: If the supplied path is invalid.
         :raises NodeNotFound: If the path does not point ot a node.
         :raises PermissionDenied: If the group does not have permission to access the node.
@@ -374,15 +630,22 @@ class SALClient:
         if not is_absolute:
             raise ValueError("The supplied path must be an absolute path.")
 
+        if depth is not None and depth != 'full':
+            if int(depth) != depth or depth < 1:
+                raise ValueError("The depth must be 'full' or an integer >= 1.")
+
         # make request
-        url = _LIST_URL.format(host=self.host, path='/'.join(segments), revision=revision)
+        if depth is None:
+            url = _LIST_URL.format(host=self.host, path='/'.join(segments), revision=revision)
+        else:
+            url = _LIST_TREE_URL.format(host=self.host, path='/'.join(segments), revision=revision, depth=depth)
         response = self._make_get_request(url)
 
         # de-serialise content
         content = response.json()
         return deserialise(content)
 
-    def get(self, path, summary=False):
+    def get(self, path, summary=False, selection=None, lazy=False):
         """
         Returns node data for the specific path.
 
@@ -396,8 +659,35 @@ class SALClient:
         returned, if true a data summary is returned. The summary argument has
         no effect for branch nodes.
 
+        A subset of a full data object may be requested by supplying a
+        :class:`~sal.core.selection.Selection` describing the index slices
+        or coordinate ranges required. The selection is performed by the
+        server, only the selected data is transferred. For example, to obtain
+        the data between 0.1 and 0.2 seconds of a signal::
+
+            client.get('/pulse/4000/adc/main/current', selection=Selection(ranges=[(0.1, 0.2)]))
+
+        Signals may also be decimated by the server to a fixed number of bins,
+        for example an overview of the signal maximum::
+
+            client.get('/pulse/4000/adc/main/current', selection=Selection(bins=[1000], reduce='max'))
+
+        If lazy is True, the server omits the large arrays of the object. The
+        arrays are requested individually when first accessed, so only the
+        parts of the object used are transferred. For example, reading the
+        units and timebase of a signal does not transfer the signal data::
+
+            signal = client.get('/pulse/4000/adc/main/current', lazy=True)
+            print(signal.units, signal.dimensions[0].data)
+
+        The arrays are requested from the same revision of the node as the
+        rest of the object, any selection is applied to each array request.
+        The lazy object is an instance of a subclass of the data class.
+
         :param path: A valid node path.
         :param summary: Return a summary object (default: False).
+        :param selection: A Selection object (default: None).
+        :param lazy: Request large arrays on first access (default: False).
         :return: A :class:`~sal.core.object.Branch`, :class:`~sal.core.object.DataObject`
                  or :class:`~sal.core.object.DataSummary` object.
         :raises InvalidPath: If the supplied path is invalid.
@@ -410,14 +700,447 @@ class SALClient:
         if not is_absolute:
             raise ValueError("The supplied path must be an absolute path.")
 
-        # make request
-        obj_type = 'summary' if summary else 'full'
+        if selection is not None:
+            if not isinstance(selection, Selection):
+                raise TypeError("The selection must be a Selection instance.")
+            if summary:
+                raise ValueError("A selection cannot be applied to a summary object.")
+
+        if lazy and summary:
+            raise ValueError("A summary object cannot be lazily loaded.")
+
+        if summary:
+            obj_type = 'summary'
+        elif lazy:
+            obj_type = 'skeleton'
+        else:
+            obj_type = 'full'
+        query = urlencode(selection.to_query()) if selection is not None else ''
+
         url = _GET_URL.format(host=self.host, path='/'.join(segments), object=obj_type, revision=revision)
-        response = self._make_get_request(url)
+        if query:
+            url += '&' + query
+
+        headers = self._transfer_headers()
+        placeholders = {} if lazy else None
+
+        # explicit revisions are immutable and served directly from the cache
+        # head requests are revalidated with the entity tag of the cached object
+        cache = self.cache
+        etag = None
+        if cache is not None:
+            key = self._cache_key(segments, revision, obj_type, query)
+            data = cache.get(key)
+            if revision and data is not None:
+                return self._lazy_object(self._decode_envelope(data, placeholders), placeholders, path, selection, segments, revision)
+            if not revision and data is not None:
+                etag = data.decode('utf-8')
+                headers['If-None-Match'] = etag
+
+        # make request
+        response = self._make_get_request(url, valid_code=(200, 304), headers=headers)
+        if response.status_code == 304:
+            data = cache.get(self._etag_key(etag)) if etag else None
+            if data is not None:
+                obj = self._decode_envelope(data, placeholders)
+                return self._lazy_object(obj, placeholders, path, selection, segments, self._response_revision(response, revision))
+
+            # the cached object has been evicted, repeat the request unconditionally
+            del headers['If-None-Match']
+            response = self._make_get_request(url, headers=headers)
+
+        # de-serialise content
+        obj = self._decode_response(response, placeholders)
+        if cache is not None:
+            envelope = self._cache_envelope(response, obj, lazy)
+            if revision:
+                cache.put(key, envelope)
+            else:
+                etag = response.headers.get('ETag')
+                if etag:
+                    cache.put(self._etag_key(etag), envelope)
+                    cache.put(key, etag.encode('utf-8'))
+        return self._lazy_object(obj, placeholders, path, selection, segments, self._response_revision(response, revision))
+
+    def get_into(self, path, target, selection=None):
+        """
+        Reads the data object at the specific path into an existing object.
+
+        The array data is decoded directly into the arrays of the target
+        object, no new arrays are allocated. The remaining attributes of the
+        target are replaced by those of the node's object. This avoids the
+        allocation of new arrays when repeatedly reading objects of the
+        same shape, for example a signal from a series of pulses::
+
+            signal = client.get('/pulse/4000/adc/main/current')
+            for pulse in range(4001, 5000):
+                client.get_into('/pulse/{}/adc/main/current'.format(pulse), signal)
+                process(signal)
+
+        The node must hold an object of the same class as the target. The
+        target arrays are only reused if each array has the dtype and shape
+        of the corresponding array of the node's object, any other arrays are
+        replaced by new arrays. Arrays shared with other objects, such as
+        views of the target's arrays, are overwritten.
+
+        Arrays are only decoded in place with the binary transport, the
+        arrays are not compressed for transfer. If the server does not
+        support the binary transport the object is obtained with get() and
+        the target's attributes replaced.
+
+        :param path: A valid node path.
+        :param target: A DataObject instance, not a lazy object.
+        :param selection: A Selection object (default: None).
+        :return: The target object.
+        :raises TypeError: If the node does not hold an object of the target's class.
+        :raises InvalidPath: If the supplied path is invalid.
+        :raises NodeNotFound: If the path does not point ot a node.
+        :raises PermissionDenied: If the group does not have permission to access the node.
+        """
+
+        if not isinstance(target, DataObject) or _lazy.is_lazy(target):
+            raise TypeError("The target must be a DataObject instance that is not lazily loaded.")
+
+        # check path is valid and dismantle
+        segments, revision, is_absolute = decompose(path)
+        if not is_absolute:
+            raise ValueError("The supplied path must be an absolute path.")
+
+        if selection is not None and not isinstance(selection, Selection):
+            raise TypeError("The selection must be a Selection instance.")
+
+        if not self._use_binary():
+            return self._replace(target, self.get(path, selection=selection))
+
+        query = urlencode(selection.to_query()) if selection is not None else ''
+        url = _GET_URL.format(host=self.host, path='/'.join(segments), object='full', revision=revision)
+        if query:
+            url += '&' + query
+
+        # explicit revisions are immutable and served directly from the cache
+        cache = self.cache if revision else None
+        key = self._cache_key(segments, revision, 'full', query) if cache is not None else None
+        data = cache.get(key) if cache is not None else None
+
+        if data is None:
+
+            # uncompressed buffers are read from the response stream straight into the target arrays
+            response = self._make_get_request(url, headers={'Accept': _MIME_BINARY}, stream=True)
+            try:
+                if _MIME_BINARY not in response.headers['Content-Type'].lower():
+                    return self._replace(target, self._decode_response(response))
+
+                # the raw stream is only usable if the response has no transfer content encoding
+                if cache is None and not response.headers.get('Content-Encoding'):
+                    return self._replace(target, self._read_into(response.raw, target))
+
+                data = response.content
+                if cache is not None:
+                    cache.put(key, data)
+            finally:
+                response.close()
+
+        return self._replace(target, self._read_into(io.BytesIO(data), target))
+
+    @staticmethod
+    def _read_into(stream, target):
+        """
+        Reads a binary envelope into the arrays of a target object.
+
+        :param stream: A binary stream positioned at the start of an envelope.
+        :param target: A DataObject instance.
+        :return: The de-serialised object, adopting the target arrays that could be reused.
+        """
+
+        reader = EnvelopeReader(stream)
+        buffers = reader.read_buffers(buffer_targets(reader.document, reader.lengths, target))
+        return deserialise(reader.document, buffers, adopt=True)
+
+    @staticmethod
+    def _replace(target, obj):
+        """
+        Replaces the attributes of a target object with those of an object of the same class.
+
+        :param target: The target DataObject.
+        :param obj: The DataObject read from the server.
+        :return: The target object.
+        """
+
+        if type(obj) is not type(target):
+            raise TypeError("The node holds a '{}' object, it cannot be read into a '{}' object.".format(obj.CLASS, target.CLASS))
+
+        vars(target).clear()
+        vars(target).update(vars(obj))
+        return target
+
+    def _lazy_object(self, obj, placeholders, path, selection, segments, revision):
+        """
+        Converts an object built from a skeleton document into a lazy object.
+
+        Objects that are not built from a skeleton are returned unchanged.
+
+        :param obj: The de-serialised object.
+        :param placeholders: The placeholder arrays returned by deserialise() or None.
+        :param path: The requested node path.
+        :param selection: The requested Selection or None.
+        :param segments: The node path segments.
+        :param revision: The revision of the object.
+        :return: The object.
+        """
+
+        if not placeholders:
+            return obj
+
+        query = urlencode(selection.to_query()) if selection is not None else ''
+
+        def loader(component):
+            url = _GET_URL.format(host=self.host, path='/'.join(segments), object='full', revision=revision)
+            url += '&' + urlencode({'component': component})
+            if query:
+                url += '&' + query
+            response = self._make_get_request(url, headers=self._transfer_headers())
+            return self._decode_response(response).data
+
+        if _lazy.defer(obj, placeholders, loader):
+            return obj
+
+        # the data class did not adopt the placeholders, the object must be requested in full
+        return self.get(path, selection=selection)
+
+    @staticmethod
+    def _response_revision(response, revision):
+        """
+        Returns the revision of the object in a response.
+
+        :param response: A Response object.
+        :param revision: The requested revision, used if the server does not report the revision.
+        :return: The revision number.
+        """
+
+        try:
+            return int(response.headers[_REVISION_HEADER])
+        except (KeyError, ValueError):
+            return revision
+
+    def get_many(self, paths, summary=False):
+        """
+        Returns node data for a list of paths.
+
+        All the objects are requested from the server in a single request,
+        avoiding a round trip per node. Each path may include a revision. The
+        objects are returned in the same order as the paths.
+
+        The request for each path succeeds or fails independently. If the
+        server reports an error for a path, the corresponding exception
+        instance (e.g. NodeNotFound) is returned in place of the object.
+        The exceptions are not raised.
+
+        If the server does not support batch requests, the objects are
+        requested individually.
+
+        :param paths: A list of valid node paths.
+        :param summary: Return summary objects (default: False).
+        :return: A list of :class:`~sal.core.object.Branch`, :class:`~sal.core.object.DataObject`,
+                 :class:`~sal.core.object.DataSummary` or exception objects.
+        :raises InvalidPath: If a supplied path is invalid.
+        """
+
+        # check paths are valid before making any requests
+        normalised = []
+        for path in paths:
+            segments, revision, is_absolute = decompose(path)
+            if not is_absolute:
+                raise ValueError("The supplied paths must be absolute paths.")
+            normalised.append('/{}:{}'.format('/'.join(segments), revision))
+
+        if not normalised:
+            return []
+
+        # fall back to individual requests for servers without batch support
+        if 'batch' not in self.resources:
+            results = []
+            for path in normalised:
+                try:
+                    results.append(self.get(path, summary))
+                except exception.SALException as e:
+                    results.append(e)
+            return results
+
+        # make request
+        payload = {'operation': 'get', 'summary': bool(summary), 'paths': normalised}
+        url = _BATCH_URL.format(host=self.host)
+        response = self._make_post_request(url, payload=payload, valid_code=200, headers=self._transfer_headers())
 
         # de-serialise content
+        if _MIME_BINARY in response.headers['Content-Type'].lower():
+            content, buffers = decode_binary(bytearray(response.content))
+        else:
+            content, buffers = response.json(), None
+
+        results = []
+        for result in content['results']:
+            if 'error' in result:
+                error = result['error']
+                exception_class = _EXCEPTION_MAP.get(error.get('exception'), exception.InternalError)
+                results.append(exception_class(message=error.get('message')))
+            else:
+                results.append(deserialise(result['object'], buffers, adopt=True))
+        return results
+
+    def get_many_async(self, paths, summary=False, concurrency=None):
+        """
+        Requests node data for a list of paths concurrently.
+
+        Each path is requested with get() on a pool of worker threads,
+        allowing many requests to be in flight at once. The method returns
+        immediately with a list of futures (see concurrent.futures), one per
+        path in the same order as the paths. The result of each future is
+        the object returned by get(), any exception raised by the request is
+        raised when the result is obtained. For example::
+
+            futures = client.get_many_async(paths, concurrency=8)
+            signals = [future.result() for future in futures]
+
+        The number of concurrent requests is limited by concurrency, which
+        defaults to the connection pool size. If authentication is required
+        and the token expires, the token is renewed once and shared by all
+        the requests.
+
+        :param paths: A list of valid node paths.
+        :param summary: Return summary objects (default: False).
+        :param concurrency: The maximum number of concurrent requests (default: pool_size).
+        :return: A list of Future objects.
+        """
+
+        concurrency = self.pool_size if concurrency is None else int(concurrency)
+        if concurrency < 1:
+            raise ValueError("The concurrency must be at least 1.")
+
+        paths = list(paths)
+        if not paths:
+            return []
+
+        # the executor threads exit once all the requests have completed
+        executor = ThreadPoolExecutor(max_workers=min(concurrency, len(paths)), thread_name_prefix='sal-client')
+        try:
+            return [executor.submit(self.get, path, summary) for path in paths]
+        finally:
+            executor.shutdown(wait=False)
+
+    def search(self, path='/', cls=None, group=None, version=None, metadata=None, modified_after=None, modified_before=None, limit=None):
+        """
+        Finds the leaf nodes under a path that match all the supplied criteria.
+
+        The search is performed by the server using an index of the leaf
+        node metadata, the tree is not traversed. Only the head revision of
+        the tree is searched.
+
+        Metadata criteria are a dictionary of summary object keys and the
+        values they must equal. Nested keys are separated by '/', a key
+        segment of '*' matches any key. For example, to find the signals of
+        a pulse measured in volts with a temporal dimension::
+
+            results = client.search('/pulse/4000', cls='signal', metadata={'units': 'V', 'dimensions/*/temporal': True})
+            for path, report in results:
+                print(path, report.description)
+
+        The number of results is limited by the server, a warning is issued
+        if results are omitted.
+
+        :param path: An absolute path without a revision (default='/').
+        :param cls: The data object class (default: None).
+        :param group: The data object group (default: None).
+        :param version: The data object version (default: None).
+        :param metadata: A dictionary of metadata keys and values (default: None).
+        :param modified_after: A datetime, matches nodes modified at or after this time (default: None).
+        :param modified_before: A datetime, matches nodes modified before this time (default: None).
+        :param limit: The maximum number of results (default: server limit).
+        :return: A list of (path, :class:`~sal.core.object.LeafReport`) tuples in path order.
+        :raises InvalidRequest: If the search criteria are invalid.
+        :raises UnsupportedOperation: If the server does not support searches.
+        """
+
+        segments, revision, is_absolute = decompose(path)
+        if not is_absolute:
+            raise ValueError("The supplied path must be an absolute path.")
+        if revision:
+            raise ValueError("Searches are performed on the head revision, a revision cannot be specified.")
+
+        if 'search' not in self.resources:
+            raise exception.UnsupportedOperation(message='The server does not support searches.')
+
+        criteria = {
+            'path': '/' + '/'.join(segments),
+            'class': cls,
+            'group': group,
+            'version': version,
+            'metadata': metadata,
+            'modified_after': encode_timestamp(modified_after) if modified_after is not None else None,
+            'modified_before': encode_timestamp(modified_before) if modified_before is not None else None,
+            'limit': limit
+        }
+        payload = {key: value for key, value in criteria.items() if value is not None}
+
+        # make request
+        url = _SEARCH_URL.format(host=self.host)
+        response = self._make_post_request(url, payload=payload, valid_code=200)
+
         content = response.json()
-        return deserialise(content)
+        if content.get('truncated'):
+            warnings.warn('The search results were truncated by the server, refine the search or increase the limit.')
+        return [(result['path'], deserialise(result['report'])) for result in content['results']]
+
+    def subscribe(self, paths='/', last_event=None):
+        """
+        Subscribes to the changes made to the tree.
+
+        Returns an iterator over the events for the writes made to the nodes
+        at or below the supplied paths. Iteration blocks until the next event
+        arrives, the subscription should be closed once it is no longer
+        required. For example, to follow the new data written to a pulse::
+
+            with client.subscribe('/pulse/4000') as events:
+                for event in events:
+                    if event.operation == 'reset':
+                        resynchronise()
+                    else:
+                        print(event.operation, event.path, event.revision)
+
+        Lost connections are re-established automatically, the stream
+        resumes from the last event received. A subscription may be resumed
+        later by passing the last_event attribute of an earlier subscription.
+        See :class:`~sal.client.events.Event` for the events reported.
+
+        :param paths: An absolute path or a list of absolute paths without revisions (default='/').
+        :param last_event: The id of the last event received, the stream resumes after it (default=None).
+        :return: A :class:`~sal.client.events.Subscription` iterator.
+        :raises UnsupportedOperation: If the server does not support event streams.
+        """
+
+        if isinstance(paths, str):
+            paths = [paths]
+
+        query = []
+        for path in paths:
+            segments, revision, is_absolute = decompose(path)
+            if not is_absolute:
+                raise ValueError("The supplied path must be an absolute path.")
+            if revision:
+                raise ValueError("Subscriptions follow the head revision, a revision cannot be specified.")
+            query.append(('path', '/' + '/'.join(segments)))
+
+        if 'events' not in self.resources:
+            raise exception.UnsupportedOperation(message='The server does not support event streams.')
+
+        url = '{}?{}'.format(_EVENTS_URL.format(host=self.host), urlencode(query))
+
+        def connect(last_id):
+            headers = {'Accept': _MIME_EVENTS}
+            if last_id is not None:
+                headers['Last-Event-ID'] = last_id
+            return self._make_get_request(url, headers=headers, stream=True, timeout=_EVENTS_TIMEOUT)
+
+        return Subscription(connect, last_event)
 
     def put(self, path, content):
         """
@@ -440,6 +1163,9 @@ class SALClient:
         These cannot be created automatically as the branch metadata, such as
         the description, can not be automatically populated.
 
+        If the binary transport is used, the content is streamed to the server
+        in chunks, avoiding an encoded copy of the data in memory.
+
         :param path: A valid node path.
         :param content: A :class:`~sal.core.object.Branch` or :class:`~sal.core.object.DataObject` instance.
         :raises InvalidPath: If the supplied path is invalid.
@@ -462,8 +1188,84 @@ class SALClient:
 
         # make request
         url = _PUT_URL.format(host=self.host, path='/'.join(segments))
-        payload = serialise(content)
-        self._make_post_request(url, payload=payload)
+        if self._use_binary():
+            buffers = []
+            payload = serialise(content, buffers, self._compression_scheme(), columnar=self._use_columnar())
+            self._make_post_request(url, data=_EnvelopeBody(payload, buffers), headers={'Content-Type': _MIME_BINARY})
+        else:
+            payload = serialise(content, compression=self._compression_scheme(), columnar=self._use_columnar())
+            self._make_post_request(url, payload=payload)
+
+    def put_many(self, items):
+        """
+        Creates/updates the nodes of a list of (path, content) items.
+
+        All the items are sent to the server in a single request. The items
+        are written in order, so a branch may be created by an item and
+        populated by the items that follow it. For example, to write a new
+        pulse::
+
+            client.put_many([
+                ('/pulse/4000', Branch('Pulse 4000.')),
+                ('/pulse/4000/adc', Branch('ADC signals.')),
+                ('/pulse/4000/adc/current', current),
+                ('/pulse/4000/adc/voltage', voltage)
+            ])
+
+        Where supported by the server's persistence provider, the items are
+        written as a single transaction creating a single revision: if any
+        item fails none of the items are written and readers never observe a
+        partially written batch.
+
+        If the server does not support batch requests, the items are written
+        individually with put().
+
+        :param items: A list of (path, content) tuples, the content is a :class:`~sal.core.object.Branch`
+                      or :class:`~sal.core.object.DataObject` instance.
+        :raises InvalidPath: If a supplied path is invalid.
+        :raises NodeNotFound: If the parent of a node does not exist.
+        :raises PermissionDenied: If the group does not have permission to access a node.
+        """
+
+        # check items are valid before making any requests
+        items = list(items)
+        normalised = []
+        for path, content in items:
+            segments, revision, is_absolute = decompose(path)
+            if not is_absolute:
+                raise ValueError("The supplied paths must be absolute paths.")
+            if revision > 0:
+                raise ValueError("Put operations may only be performed on the head revision.")
+            if not isinstance(content, (Branch, DataObject)):
+                raise TypeError("The put content must be a DataClass or Branch instance.")
+            normalised.append('/' + '/'.join(segments))
+
+        if not items:
+            return
+
+        # fall back to individual requests for servers without batch support
+        if 'batch' not in self.resources:
+            for path, (_, content) in zip(normalised, items):
+                self.put(path, content)
+            return
+
+        # make request, the objects share the envelope buffers
+        url = _BATCH_URL.format(host=self.host)
+        scheme = self._compression_scheme()
+        columnar = self._use_columnar()
+        if self._use_binary():
+            buffers = []
+            payload = {
+                'operation': 'put',
+                'items': [{'path': path, 'object': serialise(content, buffers, scheme, columnar=columnar)} for path, (_, content) in zip(normalised, items)]
+            }
+            self._make_post_request(url, data=_EnvelopeBody(payload, buffers), headers={'Content-Type': _MIME_BINARY})
+        else:
+            payload = {
+                'operation': 'put',
+                'items': [{'path': path, 'object': serialise(content, compression=scheme, columnar=columnar)} for path, (_, content) in zip(normalised, items)]
+            }
+            self._make_post_request(url, payload=payload)
 
     def delete(self, path):
         """
@@ -523,6 +1325,116 @@ class SALClient:
         )
         self._make_post_request(url)
 
+    def _cache_key(self, segments, revision, obj_type, query):
+        """
+        Returns the cache key for an object request.
+
+        :param segments: The path segments.
+        :param revision: The explicit revision number.
+        :param obj_type: The object type, 'full' or 'summary'.
+        :param query: The encoded selection query string.
+        :return: A key string.
+        """
+
+        return '{}/data/{}:{}?object={}&{}'.format(self.host, '/'.join(segments), revision, obj_type, query)
+
+    def _etag_key(self, etag):
+        """
+        Returns the cache key for an object identified by an entity tag.
+
+        :param etag: The entity tag header value.
+        :return: A key string.
+        """
+
+        return '{}/etag/{}'.format(self.host, etag)
+
+    @staticmethod
+    def _cache_envelope(response, obj, skeleton=False):
+        """
+        Returns the binary envelope to cache for a response.
+
+        Binary responses are cached as received, JSON responses are re-encoded.
+        The placeholder arrays of skeleton objects are re-encoded as deferred
+        arrays.
+
+        :param response: A Response object.
+        :param obj: The de-serialised object.
+        :param skeleton: The object was built from a skeleton document (default=False).
+        :return: A bytes object.
+        """
+
+        if _MIME_BINARY in response.headers['Content-Type'].lower():
+            return response.content
+
+        buffers = []
+        document = serialise(obj, buffers, defer=DEFER_THRESHOLD if skeleton else None)
+        return encode_binary(document, buffers)
+
+    def _compression_scheme(self):
+        """
+        Returns the array compression scheme negotiated with the server or None.
+        """
+
+        return _compression.negotiate(self.server_compression, self.compression)
+
+    def _transfer_headers(self):
+        """
+        Returns the request headers selecting the response content type, array compression and document encodings.
+        """
+
+        headers = {ENCODING_HEADER: ', '.join(ENCODINGS)}
+        if self._use_binary():
+            headers['Accept'] = _ACCEPT_BINARY
+
+        scheme = self._compression_scheme()
+        if scheme:
+            headers[_compression.HEADER] = scheme
+        return headers
+
+    def _use_columnar(self):
+        """
+        Returns True if large scalar dictionaries may be sent to the server as typed columns.
+        """
+
+        return 'columnar' in self.server_encodings
+
+    def _use_binary(self):
+        """
+        Returns True if the binary transport should be used.
+        """
+
+        return self.binary_transport and _MIME_BINARY in self.content_types
+
+    @classmethod
+    def _decode_response(cls, response, placeholders=None):
+        """
+        De-serialises the object contained in a response.
+
+        :param response: A Response object.
+        :param placeholders: A dictionary to receive placeholder arrays for skeleton objects (default=None).
+        :return: The de-serialised object.
+        """
+
+        if _MIME_BINARY in response.headers['Content-Type'].lower():
+            return cls._decode_envelope(response.content, placeholders)
+        return deserialise(response.json(), deferred=placeholders)
+
+    @staticmethod
+    def _decode_envelope(data, placeholders=None):
+        """
+        De-serialises the object contained in a binary envelope.
+
+        The envelope is copied once into writable memory, the data objects
+        adopt the decoded arrays without further copies.
+
+        :param data: A bytes-like object containing the envelope.
+        :param placeholders: A dictionary to receive placeholder arrays for skeleton objects (default=None).
+        :return: The de-serialised object.
+        """
+
+        document, buffers = decode_binary(bytearray(data))
+        return deserialise(document, buffers, placeholders, adopt=True)
+
     def _make_get_request(self, url, valid_code=200, **kwargs):
         """
         Makes a get request and handles errors.
@@ -532,7 +1444,7 @@ class SALClient:
         :return: A response object.
         """
 
-        return self._make_request(requests.get, url, valid_code=valid_code, **kwargs)
+        return self._make_request('GET', url, valid_code=valid_code, **kwargs)
 
     def _make_post_request(self, url, payload=None, valid_code=204, **kwargs):
         """
@@ -543,7 +1455,7 @@ class SALClient:
         :param valid_code: HTTP return code of a valid response (default=204).
         """
 
-        return self._make_request(requests.post, url, valid_code=valid_code, json=payload, **kwargs)
+        return self._make_request('POST', url, valid_code=valid_code, json=payload, **kwargs)
 
     def _make_delete_request(self, url, valid_code=204, **kwargs):
         """
@@ -553,22 +1465,24 @@ class SALClient:
         :param valid_code: HTTP return code of a valid response (default=204).
         """
 
-        return self._make_request(requests.delete, url, valid_code=valid_code, **kwargs)
+        return self._make_request('DELETE', url, valid_code=valid_code, **kwargs)
 
     def _make_request(self, method, url, *args, valid_code=200, **kwargs):
         """
-        Makes a request using the specified requests package method.
+        Makes a request using the specified HTTP method.
 
         This method performs authentication and error handling for all
         requests. Any additional arguments (args and kwargs) specified in
-        calling this method are passed to the request method.
+        calling this method are passed to the session request method.
 
-        :param: method: Requests package method (e.g. requests.get).
+        :param: method: HTTP method name (e.g. 'GET').
         :param url: Host URL.
         :param valid_code: HTTP return code of a valid response (default=200).
         :return: A response object.
         """
 
+        headers = kwargs.pop('headers', None) or {}
+
         if self.auth_required:
 
             # handle authentication
@@ -576,25 +1490,20 @@ class SALClient:
             while True:
 
                 # if we don't have a token we need to obtain one
-                if not self.auth_token:
-
-                    # is an auth token stored?
-                    if not self._read_auth_token():
-                        self.authenticate(credentials=self.credentials_file)
-                        self._write_auth_token()
-                        auth_attempted = True
+                token, authenticated = self._acquire_auth_token()
+                auth_attempted = auth_attempted or authenticated
 
                 # attempt request
-                headers = {'Authorization': 'Bearer {}'.format(self.auth_token)}
+                auth_headers = dict(headers)
+                auth_headers['Authorization'] = 'Bearer {}'.format(token)
                 response = self._get_response(method, url, *args,
-                                             headers=headers, **kwargs)
+                                             headers=auth_headers, **kwargs)
 
                 # did the request fail due to an expired token?
                 if response.status_code == 401:
 
                     # renew authentication token (may ask user for user/password)
-                    self.auth_token = None
-                    self._clear_auth_token()
+                    self._discard_auth_token(token)
                     if not auth_attempted:
                         # if self.prompt_for_password:
                         #     print('Authorisation token has expired, attempting to reacquire.')
@@ -606,21 +1515,69 @@ class SALClient:
         else:
 
             # no authentication handling
-            response = self._get_response(method, url, *args, **kwargs)
+            response = self._get_response(method, url, *args, headers=headers, **kwargs)
             self._validate_response(response, valid_code)
             return response
 
+    def _acquire_auth_token(self):
+        """
+        Returns the current authentication token, obtaining one if required.
+
+        Only one thread obtains a token at a time, threads waiting on the
+        lock use the token obtained by the first thread.
+
+        :return: A tuple containing the token and True if the user was authenticated by this call.
+        """
+
+        with self._auth_lock:
+
+            if self.auth_token:
+                return self.auth_token, False
+
+            # is an auth token stored?
+            if self._read_auth_token():
+                return self.auth_token, False
+
+            self.authenticate(credentials=self.credentials_file)
+            self._write_auth_token()
+            return self.auth_token, True
+
+    def _discard_auth_token(self, token):
+        """
+        Discards an expired authentication token.
+
+        The token is only discarded if it is still the current token, if
+        another thread has already renewed the token the new token is kept.
+        This prevents concurrent requests failing with the same expired token
+        from each triggering a re-authentication.
+
+        :param token: The expired token.
+        """
+
+        with self._auth_lock:
+            if self.auth_token == token:
+                self.auth_token = None
+                self._clear_auth_token()
+
     def _get_response(self, method, url, *args, **kwargs):
         # disable warnings unless enabled at python command line
         # added to prevent SSL cert warnings being output by requests when the user permits invalid SSL certificates
+        session = self.session
         with warnings.catch_warnings():
             warnings.simplefilter('ignore')
+            start = time.perf_counter()
             try:
-                response = method(url, *args, verify=self.verify_https_cert, **kwargs)
+                response = session.request(method, url, *args, verify=self.verify_https_cert, **kwargs)
             except requests.exceptions.SSLError:
                 raise ConnectionError('The host\'s HTTPS certificate is invalid, please contact the server admin.')
             except requests.exceptions.RequestException:
-                raise ConnectionError('The server did not respond ({}).'.format(self._host))
+                raise ConnectionError('The server did not respond ({}).'.format(url))
+            finally:
+                latency = time.perf_counter() - start
+
+        with self._statistics_lock:
+            self._requests += 1
+            self._latency += latency
         return response
 
     @staticmethod
@@ -645,15 +1602,22 @@ class SALClient:
         the reporting or errors to the user.
 
         :param response: A Response object.
-        :param valid_code: The http status code expected in the response.
+        :param valid_code: The http status code (or tuple of codes) expected in the response.
         """
 
-        # response must be json
-        if _MIME_JSON not in response.headers['Content-Type'].lower():
+        valid_codes = valid_code if isinstance(valid_code, tuple) else (valid_code, )
+
+        # a not modified response has no content
+        if response.status_code == 304 and 304 in valid_codes:
+            return
+
+        # response must be json, a binary envelope or an event stream
+        content_type = response.headers.get('Content-Type', '').lower()
+        if _MIME_JSON not in content_type and _MIME_BINARY not in content_type and _MIME_EVENTS not in content_type:
             raise exception.InvalidResponse('Server did not return valid data.')
 
         # handle errors
-        if response.status_code != valid_code:
+        if response.status_code not in valid_codes:
             self._handle_error(response)
 
     def _handle_error(self, response):
@@ -0,0 +1,79 @@
+import os
+import shutil
+import tempfile
+import unittest
+from sal.client.cache import ObjectCache
+
+
+class TestObjectCache(unittest.TestCase):
+
+    def setUp(self):
+        self.path = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.path)
+
+    def test_memory(self):
+
+        cache = ObjectCache(memory_size=10, disk=False)
+        self.assertIsNone(cache.get('a'))
+
+        cache.put('a', b'12345')
+        cache.put('b', b'1234')
+        self.assertEqual(cache.get('a'), b'12345')
+
+        # least recently used item is evicted
+        cache.put('c', b'123')
+        self.assertIsNone(cache.get('b'))
+        self.assertEqual(cache.get('a'), b'12345')
+        self.assertEqual(cache.get('c'), b'123')
+
+        # items larger than the cache are not stored
+        cache.put('d', bytes(11))
+        self.assertIsNone(cache.get('d'))
+
+        self.assertEqual(cache.hits, 3)
+        self.assertEqual(cache.misses, 3)
+
+    def test_disk(self):
+
+        cache = ObjectCache(path=self.path)
+        cache.put('/data/a:1?object=full&', b'content')
+
+        # a new cache instance finds the item on disk
+        cache = ObjectCache(path=self.path)
+        self.assertEqual(cache.get('/data/a:1?object=full&'), b'content')
+        self.assertIsNone(cache.get('/data/a:2?object=full&'))
+
+        cache.clear()
+        self.assertEqual(os.listdir(self.path), [])
+        self.assertIsNone(cache.get('/data/a:1?object=full&'))
+
+    def test_disk_prune(self):
+
+        cache = ObjectCache(path=self.path, disk_size=10)
+        cache.put('a', b'123456')
+        cache.put('b', b'123456')
+        self.assertEqual(len(os.listdir(self.path)), 1)
+
+    def test_disk_scan(self):
+
+        cache = ObjectCache(path=self.path, disk_size=20)
+        scans = []
+        disk_files = cache._disk_files
+
+        def counting():
+            scans.append(None)
+            return disk_files()
+
+        cache._disk_files = counting
+
+        # the store is scanned once, then only when the size limit is exceeded
+        cache.put('a', b'123456')
+        cache.put('b', b'123456')
+        cache.put('b', b'1234567')
+        self.assertEqual(len(scans), 1)
+
+        cache.put('c', b'123456789')
+        self.assertEqual(len(scans), 2)
+        self.assertLessEqual(sum(os.path.getsize(os.path.join(self.path, name)) for name in os.listdir(self.path)), 20)
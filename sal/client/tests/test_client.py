@@ -0,0 +1,403 @@
+import os
+import shutil
+import tempfile
+import threading
+import unittest
+from unittest import mock
+import numpy as np
+import requests
+from werkzeug.serving import make_server
+from sal.client import SALClient
+from sal.client.lazy import is_lazy, is_loaded
+from sal.core.exception import NodeNotFound
+from sal.core.object import Branch
+from sal.core.serialise import BINARY_MIME_TYPE
+from sal.dataclass import *
+from sal.server import SALServer
+from sal.server.interface import AuthenticationProvider
+from sal.server.providers import MemoryPersistence, CachedPersistence
+
+
+class LocalServer:
+    """
+    Runs a SAL server on a local port in a background thread, backed by a memory provider by default.
+    """
+
+    def __init__(self, provider=None, **kwargs):
+        self.provider = MemoryPersistence() if provider is None else provider
+        self.app = SALServer(self.provider, **kwargs)
+        self.server = make_server('127.0.0.1', 0, self.app, threaded=True)
+        self.host = 'http://127.0.0.1:{}'.format(self.server.server_port)
+        self.thread = threading.Thread(target=self.server.serve_forever, daemon=True)
+        self.thread.start()
+
+    def stop(self):
+        self.server.shutdown()
+        self.thread.join()
+        self.server.server_close()
+
+
+class TestSession(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.server = LocalServer()
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.stop()
+
+    def test_pool_size(self):
+
+        client = SALClient(self.server.host, pool_size=4)
+        for host in ['http://example.com', 'https://example.com']:
+            adapter = client.session.get_adapter(host)
+            self.assertEqual(adapter.poolmanager.connection_pool_kw['maxsize'], 4)
+        client.close()
+
+        with self.assertRaises(ValueError):
+            SALClient(self.server.host, pool_size=0)
+
+    def test_keep_alive(self):
+
+        # requests reuse the connection opened when the client inspected the host
+        client = SALClient(self.server.host)
+        client.reset_statistics()
+        for _ in range(5):
+            client.list('/')
+
+        statistics = client.statistics
+        self.assertEqual(statistics['requests'], 5)
+        self.assertEqual(statistics['connections'], 0)
+        self.assertEqual(statistics['reused'], 5)
+        client.close()
+
+        # a new connection is opened for each request if keep alive is disabled
+        client = SALClient(self.server.host, keep_alive=False)
+        client.reset_statistics()
+        for _ in range(5):
+            client.list('/')
+        self.assertEqual(client.statistics['connections'], 5)
+        client.close()
+
+
+class TestGetMany(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.server = LocalServer()
+        cls.server.provider.put('/pulse', Branch('A pulse.'))
+        cls.server.provider.put('/pulse/gain', Scalar(2.0))
+        cls.server.provider.put('/pulse/name', String('shot'))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.stop()
+
+    def test_partial_failure(self):
+
+        paths = ['/pulse/gain', '/pulse/missing', '/pulse', '/pulse/name:1']
+        for binary in [True, False]:
+
+            client = SALClient(self.server.host, binary_transport=binary)
+            for batch in [True, False]:
+
+                # without batch support the objects are requested individually
+                if not batch:
+                    client.resources = [resource for resource in client.resources if resource != 'batch']
+
+                gain, missing, branch, name = client.get_many(paths)
+                self.assertIsInstance(gain, Scalar)
+                self.assertEqual(gain.value, 2.0)
+                self.assertIsInstance(missing, NodeNotFound)
+                self.assertIsInstance(branch, Branch)
+                self.assertEqual(branch.description, 'A pulse.')
+
+                # the name did not exist at revision 1
+                self.assertIsInstance(name, NodeNotFound)
+
+            client.close()
+
+    def test_head_revision(self):
+
+        # head paths are read at the current head even if the cached provider is written elsewhere
+        backend = MemoryPersistence()
+        backend.put('/gain', Scalar(1.0))
+        server = LocalServer(CachedPersistence(backend))
+        try:
+            client = SALClient(server.host)
+            self.assertEqual(client.get_many(['/gain'])[0].value, 1.0)
+            backend.put('/gain', Scalar(2.0))
+            self.assertEqual(client.get_many(['/gain'])[0].value, 2.0)
+            self.assertEqual(client.get_many(['/gain:2'])[0].value, 1.0)
+            client.close()
+        finally:
+            server.stop()
+
+    def test_invalid_paths(self):
+
+        # invalid paths fail the whole call before any request is made
+        client = SALClient(self.server.host)
+        client.reset_statistics()
+        with self.assertRaises(ValueError):
+            client.get_many(['/pulse/gain', 'pulse/gain'])
+        self.assertEqual(client.statistics['requests'], 0)
+        self.assertEqual(client.get_many([]), [])
+        client.close()
+
+
+class TestEntityTag(unittest.TestCase):
+
+    def setUp(self):
+        self.server = LocalServer()
+        self.server.provider.put('/signal', self._signal(1.0))
+        self.server.provider.put('/other', Scalar(1.0))
+        self.session = requests.Session()
+
+    def tearDown(self):
+        self.session.close()
+        self.server.stop()
+
+    @staticmethod
+    def _signal(scale):
+        return Signal(
+            dimensions=[CalculatedDimension(length=100, start=0.0, step=0.1)],
+            data=scale * np.arange(100, dtype=np.float64)
+        )
+
+    def _get(self, query='object=full', **headers):
+        return self.session.get('{}/data/signal?{}'.format(self.server.host, query), headers=headers)
+
+    def test_not_modified(self):
+
+        response = self._get()
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response.headers['X-SAL-Revision'], '3')
+        etag = response.headers['ETag']
+
+        response = self._get(**{'If-None-Match': etag})
+        self.assertEqual(response.status_code, 304)
+        self.assertEqual(response.content, b'')
+        self.assertEqual(response.headers['ETag'], etag)
+        self.assertEqual(response.headers['X-SAL-Revision'], '3')
+
+        # writes to other nodes move the head revision but not the tag
+        self.server.provider.put('/other', Scalar(2.0))
+        response = self._get(**{'If-None-Match': etag})
+        self.assertEqual(response.status_code, 304)
+        self.assertEqual(response.headers['X-SAL-Revision'], '4')
+
+        # an explicit revision is reported as requested
+        response = self._get('object=full&revision=3')
+        self.assertEqual(response.headers['X-SAL-Revision'], '3')
+        self.assertEqual(response.headers['ETag'], etag)
+
+    def test_write(self):
+
+        etag = self._get().headers['ETag']
+        self.server.provider.put('/signal', self._signal(2.0))
+
+        response = self._get(**{'If-None-Match': etag})
+        self.assertEqual(response.status_code, 200)
+        self.assertNotEqual(response.headers['ETag'], etag)
+        self.assertEqual(response.headers['X-SAL-Revision'], '4')
+
+        # the earlier revision keeps its tag
+        self.assertEqual(self._get('object=full&revision=3').headers['ETag'], etag)
+
+    def test_variants(self):
+
+        # every representation of the node carries a distinct tag
+        variants = [
+            self._get(),
+            self._get('object=summary'),
+            self._get('object=full&slice=0:10'),
+            self._get('object=full&bins=10'),
+            self._get(Accept=BINARY_MIME_TYPE),
+            self._get(**{'X-SAL-Compression': 'zlib'}),
+            self._get(Accept=BINARY_MIME_TYPE, **{'X-SAL-Compression': 'zlib'})
+        ]
+
+        for response in variants:
+            self.assertEqual(response.status_code, 200)
+            self.assertEqual(response.headers['X-SAL-Revision'], '3')
+
+        etags = [response.headers['ETag'] for response in variants]
+        self.assertEqual(len(set(etags)), len(etags))
+
+        # a tag only matches its own representation
+        response = self._get(Accept=BINARY_MIME_TYPE, **{'If-None-Match': etags[0]})
+        self.assertEqual(response.status_code, 200)
+
+
+class CountingAuthentication(AuthenticationProvider):
+    """
+    Accepts a single user and counts the authentication attempts.
+    """
+
+    def __init__(self):
+        self.count = 0
+        self._lock = threading.Lock()
+
+    def authenticate(self, username, password):
+        with self._lock:
+            self.count += 1
+        return username == 'user' and password == 'secret'
+
+
+class TestAuthentication(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.authentication = CountingAuthentication()
+        cls.server = LocalServer(authentication_provider=cls.authentication, auth_token_secret='0' * 64, auth_token_lifetime=3600)
+        cls.server.provider.put('/gain', Scalar(2.0))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.stop()
+
+    def setUp(self):
+
+        # credentials and cached tokens are held in a temporary home directory
+        self.home = tempfile.mkdtemp()
+        self.environment = mock.patch.dict(os.environ, {'HOME': self.home})
+        self.environment.start()
+        self.authentication.count = 0
+
+    def tearDown(self):
+        self.environment.stop()
+        shutil.rmtree(self.home)
+
+    def test_concurrent_renewal(self):
+
+        client = SALClient(self.server.host, pool_size=8)
+        client.prompt_for_password = False
+        self.assertTrue(client.auth_required)
+
+        os.makedirs(os.path.join(self.home, '.sal'))
+        with open(os.path.join(self.home, '.sal', 'credentials'), 'w') as f:
+            f.write('[{}]\nuser=user\npassword=secret\n'.format(client.host))
+
+        # every concurrent request fails with the expired token, only one request renews it
+        client.auth_token = 'expired'
+        futures = client.get_many_async(['/gain'] * 32, concurrency=8)
+        for future in futures:
+            self.assertEqual(future.result().value, 2.0)
+
+        self.assertEqual(self.authentication.count, 1)
+        self.assertNotEqual(client.auth_token, 'expired')
+        client.close()
+
+
+class TestLazy(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.server = LocalServer()
+        cls.signal = Signal(
+            [ArrayDimension(data=np.linspace(0, 1, 20000), units='s', temporal=True)],
+            data=np.sin(np.linspace(0, 100, 20000)),
+            units='V'
+        )
+        cls.server.provider.put('/signal', cls.signal)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.stop()
+
+    def test_first_access(self):
+
+        for binary in [True, False]:
+
+            client = SALClient(self.server.host, binary_transport=binary)
+            client.reset_statistics()
+
+            signal = client.get('/signal', lazy=True)
+            self.assertIsInstance(signal, Signal)
+            self.assertTrue(is_lazy(signal))
+            self.assertFalse(is_loaded(signal, 'data'))
+            self.assertEqual(client.statistics['requests'], 1)
+
+            # metadata is available without loading the arrays
+            self.assertEqual(signal.units, 'V')
+            self.assertEqual(signal.dimensions[0].units, 's')
+            self.assertEqual(client.statistics['requests'], 1)
+
+            # each array is requested once, on first access
+            np.testing.assert_array_equal(signal.data, self.signal.data)
+            self.assertTrue(is_loaded(signal, 'data'))
+            self.assertEqual(client.statistics['requests'], 2)
+
+            np.testing.assert_array_equal(signal.data, self.signal.data)
+            self.assertEqual(client.statistics['requests'], 2)
+
+            np.testing.assert_array_equal(signal.dimensions[0].data, self.signal.dimensions[0].data)
+            self.assertEqual(client.statistics['requests'], 3)
+            client.close()
+
+    def test_small_objects(self):
+
+        # objects without large arrays are returned fully loaded
+        self.server.provider.put('/small', Array(shape=(4,), data=np.arange(4.0)))
+        client = SALClient(self.server.host)
+        array = client.get('/small', lazy=True)
+        self.assertFalse(is_lazy(array))
+        np.testing.assert_array_equal(array.data, np.arange(4.0))
+        client.close()
+
+
+class TestGetInto(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.server = LocalServer()
+        cls.server.provider.put('/a', Array(shape=(100,), data=np.arange(100.0)))
+        cls.server.provider.put('/b', Array(shape=(100,), data=np.arange(100.0) * 2))
+        cls.server.provider.put('/float32', Array(shape=(100,), data=np.arange(100, dtype=np.float32)))
+        cls.server.provider.put('/long', Array(shape=(200,), data=np.arange(200.0)))
+        cls.server.provider.put('/gain', Scalar(2.0))
+        cls.server.provider.put('/large', Array(shape=(20000,), data=np.arange(20000.0)))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.stop()
+
+    def setUp(self):
+        self.client = SALClient(self.server.host, compression=None)
+
+    def tearDown(self):
+        self.client.close()
+
+    def test_in_place(self):
+
+        # arrays of the same dtype and shape are decoded into the target arrays
+        target = self.client.get('/a')
+        data = target.data
+        self.assertIs(self.client.get_into('/b', target), target)
+        self.assertIs(target.data, data)
+        np.testing.assert_array_equal(data, np.arange(100.0) * 2)
+
+    def test_mismatch(self):
+
+        # arrays of a different dtype or shape are replaced, the target array is left untouched
+        for path, dtype, shape in [('/float32', np.float32, (100,)), ('/long', np.float64, (200,))]:
+            target = self.client.get('/a')
+            data = target.data
+            self.client.get_into(path, target)
+            self.assertIsNot(target.data, data)
+            self.assertEqual(target.data.dtype, dtype)
+            self.assertEqual(target.data.shape, shape)
+            np.testing.assert_array_equal(data, np.arange(100.0))
+
+        # the node must hold an object of the target's class
+        target = self.client.get('/a')
+        with self.assertRaises(TypeError):
+            self.client.get_into('/gain', target)
+        np.testing.assert_array_equal(target.data, np.arange(100.0))
+
+        # lazy objects and other values are not valid targets
+        with self.assertRaises(TypeError):
+            self.client.get_into('/large', self.client.get('/large', lazy=True))
+        with self.assertRaises(TypeError):
+            self.client.get_into('/a', np.zeros(100))
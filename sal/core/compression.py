@@ -0,0 +1,263 @@
+"""
+Array compression codecs used by the serialiser.
+
+Arrays are compressed block-wise, each block is compressed independently so
+large arrays may be compressed and decompressed by several threads. An
+optional byte-shuffle filter is applied before compression. The shuffle
+groups the n-th byte of every element together, slowly varying numerical
+data (e.g. digitiser data) then compresses substantially better.
+
+Compression schemes are named by codec with an optional '-shuffle' suffix
+e.g. 'zstd-shuffle'. The zstd and lz4 codecs depend on the optional
+zstandard and lz4 packages, the zlib codec is always available.
+"""
+
+import os
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+from sal.core.exception import InternalError
+
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+try:
+    import lz4.frame as lz4frame
+except ImportError:
+    lz4frame = None
+
+
+# arrays are compressed in independent blocks of this size (uncompressed bytes)
+BLOCK_SIZE = 4 * 1024 * 1024
+
+# arrays smaller than this are not compressed, the overhead outweighs the saving
+COMPRESSION_THRESHOLD = 64 * 1024
+
+# number of threads used to compress/decompress multi-block arrays
+THREADS = min(8, os.cpu_count() or 1)
+
+# suffix identifying schemes that apply the byte-shuffle filter
+_SHUFFLE_SUFFIX = '-shuffle'
+
+# request header used by clients to select the compression scheme applied to response arrays
+HEADER = 'X-SAL-Compression'
+
+# preferred schemes when negotiating, fastest first, zlib is only used if explicitly requested
+PREFERRED = ('zstd-shuffle', 'lz4-shuffle')
+
+
+def _zstd_compress(data):
+    return zstandard.ZstdCompressor(level=3).compress(data)
+
+
+# the decompressors never produce more than the expected block size, so a small block cannot expand without limit
+
+def _zstd_decompress(data, size):
+    if zstandard.frame_content_size(data) > size:
+        raise InternalError('Decompressed array block has an unexpected size.')
+    return zstandard.ZstdDecompressor().decompress(data, max_output_size=size)
+
+
+def _lz4_compress(data):
+    return lz4frame.compress(data)
+
+
+def _lz4_decompress(data, size):
+    decompressor = lz4frame.LZ4FrameDecompressor()
+    decoded = decompressor.decompress(data, max_length=size)
+    if not decompressor.eof:
+        raise InternalError('Decompressed array block has an unexpected size.')
+    return decoded
+
+
+def _zlib_compress(data):
+    return zlib.compress(data, 1)
+
+
+def _zlib_decompress(data, size):
+    decompressor = zlib.decompressobj()
+    decoded = decompressor.decompress(data, size)
+    if decompressor.unconsumed_tail or not decompressor.eof:
+        raise InternalError('Decompressed array block has an unexpected size.')
+    return decoded
+
+
+# codec table: name -> (available, compress, decompress)
+_CODECS = {
+    'zstd': (zstandard is not None, _zstd_compress, _zstd_decompress),
+    'lz4': (lz4frame is not None, _lz4_compress, _lz4_decompress),
+    'zlib': (True, _zlib_compress, _zlib_decompress),
+}
+
+
+def available():
+    """
+    Returns the names of the compression schemes supported by this installation.
+
+    :return: A list of scheme names.
+    """
+
+    schemes = []
+    for name, (present, _, _) in _CODECS.items():
+        if present:
+            schemes.extend([name + _SHUFFLE_SUFFIX, name])
+    return schemes
+
+
+def negotiate(supported, requested='auto'):
+    """
+    Selects the compression scheme to use with a remote peer.
+
+    If requested is 'auto', the first preferred scheme supported locally and
+    by the peer is selected. Otherwise, the requested scheme is used if it is
+    supported by both. None disables compression.
+
+    :param supported: The list of schemes supported by the peer.
+    :param requested: A scheme name, 'auto' or None (default='auto').
+    :return: The selected scheme name or None.
+    """
+
+    if not requested:
+        return None
+
+    local = available()
+    if requested == 'auto':
+        for scheme in PREFERRED:
+            if scheme in local and scheme in supported:
+                return scheme
+        return None
+
+    if requested not in local:
+        raise ValueError('The compression scheme \'{}\' is not available, install the required package.'.format(requested))
+    return requested if requested in supported else None
+
+
+def compress(array, scheme):
+    """
+    Compresses the data of a numerical array.
+
+    The array data is treated as c-ordered, little endian data.
+
+    :param array: A contiguous, little endian numpy array.
+    :param scheme: The compression scheme name.
+    :return: A tuple containing the compressed bytes and the list of compressed block sizes.
+    """
+
+    codec, shuffle = _parse(scheme)
+    _, encoder, _ = codec
+
+    data = memoryview(array.reshape(-1).view(np.uint8))
+    if shuffle:
+        data = memoryview(_shuffle(data, array.dtype.itemsize))
+
+    blocks = [data[offset:offset + BLOCK_SIZE] for offset in range(0, data.nbytes, BLOCK_SIZE)]
+    compressed = _map(encoder, blocks)
+    return b''.join(compressed), [len(block) for block in compressed]
+
+
+def decompress(data, blocks, scheme, dtype, shape):
+    """
+    Decompresses array data produced by compress().
+
+    The returned array is a new writable array.
+
+    :param data: A bytes-like object containing the compressed blocks.
+    :param blocks: The list of compressed block sizes.
+    :param scheme: The compression scheme name.
+    :param dtype: The array data type.
+    :param shape: The array shape.
+    :return: A numpy array.
+    """
+
+    codec, shuffle = _parse(scheme)
+    _, _, decoder = codec
+
+    dtype = np.dtype(dtype).newbyteorder('<')
+    nbytes = int(np.prod(shape, dtype=np.int64)) * dtype.itemsize
+
+    # locate blocks
+    data = memoryview(data).cast('B')
+    offsets = np.cumsum([0] + list(blocks))
+    if offsets[-1] != data.nbytes:
+        raise InternalError('Compressed array data is inconsistent with the block table.')
+
+    # each block decompresses to BLOCK_SIZE bytes, other than the last
+    sizes = [min(BLOCK_SIZE, nbytes - i * BLOCK_SIZE) for i in range(len(blocks))]
+    if sum(sizes) != nbytes:
+        raise InternalError('Compressed array data is inconsistent with the array shape.')
+
+    output = np.empty(nbytes, dtype=np.uint8)
+
+    def decode(index):
+        start, end = offsets[index], offsets[index + 1]
+        decoded = decoder(data[start:end], sizes[index])
+        if len(decoded) != sizes[index]:
+            raise InternalError('Decompressed array block has an unexpected size.')
+        position = index * BLOCK_SIZE
+        output[position:position + sizes[index]] = np.frombuffer(decoded, dtype=np.uint8)
+
+    try:
+        _map(decode, range(len(blocks)))
+    except InternalError:
+        raise
+    except Exception:
+        raise InternalError('Array data could not be decompressed.')
+
+    if shuffle:
+        output = _unshuffle(output, dtype.itemsize)
+    return output.view(dtype).reshape(shape)
+
+
+def _parse(scheme):
+    """
+    Returns the codec and shuffle flag for a scheme name.
+    """
+
+    name = scheme[:-len(_SHUFFLE_SUFFIX)] if scheme.endswith(_SHUFFLE_SUFFIX) else scheme
+    try:
+        codec = _CODECS[name]
+    except KeyError:
+        raise InternalError('Unrecognised compression scheme \'{}\'.'.format(scheme))
+
+    if not codec[0]:
+        raise InternalError('The compression scheme \'{}\' is not available on this system.'.format(scheme))
+    return codec, name != scheme
+
+
+def _map(function, items):
+    """
+    Applies a function to each item, using a thread pool if there is more than one item.
+
+    The codecs release the GIL while compressing, so blocks are processed in parallel.
+    """
+
+    items = list(items)
+    if len(items) < 2 or THREADS < 2:
+        return [function(item) for item in items]
+
+    with ThreadPoolExecutor(max_workers=min(THREADS, len(items))) as executor:
+        return list(executor.map(function, items))
+
+
+def _shuffle(data, itemsize):
+    """
+    Groups the bytes of each element by significance.
+    """
+
+    if itemsize == 1:
+        return data
+    return np.frombuffer(data, dtype=np.uint8).reshape(-1, itemsize).T.copy().reshape(-1)
+
+
+def _unshuffle(data, itemsize):
+    """
+    Reverses the byte-shuffle filter.
+    """
+
+    if itemsize == 1:
+        return data
+    return np.ascontiguousarray(data.reshape(itemsize, -1).T).reshape(-1)
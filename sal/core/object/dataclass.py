@@ -1,5 +1,7 @@
 import pkgutil
 import importlib
+import threading
+from contextlib import contextmanager
 import numpy as np
 
 # todo: consider making DataObject etc.. Abstract Base Classes (ABCs)
@@ -14,6 +16,9 @@ _DATACLASS_SUMMARY_REGISTRY = {}
 TYPE_OBJECT = 'object'
 TYPE_SUMMARY = 'summary'
 
+# set while deserialise() builds objects from arrays it owns, see _adopting()
+_ADOPTION = threading.local()
+
 
 def register(cls):
     """
@@ -62,6 +67,32 @@ def build(d):
     return resolve(name, type).from_dict(d)
 
 
+@contextmanager
+def _adopting():
+    """
+    Context in which from_dict() adopts the arrays of the dictionary.
+
+    Used by deserialise() when the decoded arrays are not referenced
+    elsewhere, the data classes then use the arrays without copying them.
+    Outside this context from_dict() copies the supplied arrays.
+    """
+
+    previous = getattr(_ADOPTION, 'active', False)
+    _ADOPTION.active = True
+    try:
+        yield
+    finally:
+        _ADOPTION.active = previous
+
+
+def _copy_arrays():
+    """
+    Returns True if from_dict() must copy the arrays of the dictionary, see _adopting().
+    """
+
+    return not getattr(_ADOPTION, 'active', False)
+
+
 def resolve(name, type):
     """
     Returns the Python class that implements the data class specified by the string class/type names.
@@ -251,6 +282,21 @@ class DataObject(DataClass):
 
         raise NotImplementedError('This method must be implemented by sub-classes.')
 
+    def select(self, selection):
+        """
+        Returns a new data object containing a subset of the data.
+
+        Data classes holding array data may implement this method to support
+        sliced data requests. The default implementation raises a
+        NotImplementedError.
+
+        :param selection: A Selection object.
+        :return: A DataObject.
+        :raises ValueError: If the selection is not compatible with the object.
+        """
+
+        raise NotImplementedError('The data class does not support data selections.')
+
     @classmethod
     def is_compatible(cls, d):
         """
@@ -161,6 +161,96 @@ class BranchReport:
         )
 
 
+class TreeReport:
+    """
+    Describes the contents of a subtree.
+
+    A tree report holds the BranchReport for the root branch of the subtree
+    and a TreeReport for each of its child branches that lie within the
+    requested depth. Branches beyond the requested depth are listed by the
+    BranchReport of their parent but are not described.
+
+    :param report: The BranchReport of the subtree root.
+    :param children: A dictionary of child branch names to TreeReport objects (default=None).
+    """
+
+    def __init__(self, report, children=None):
+
+        if not isinstance(report, BranchReport):
+            raise TypeError('The report must be a BranchReport.')
+
+        children = dict(children or {})
+        for name, child in children.items():
+            if name not in report.branches:
+                raise ValueError('The subtree \'{}\' is not a child branch of the report.'.format(name))
+            if not isinstance(child, TreeReport):
+                raise TypeError('Subtrees must be TreeReport objects.')
+
+        self.report = report
+        self.children = children
+
+    def __repr__(self):
+
+        return (
+            'node: branch (tree)\n'
+            'description: {}\n'
+            'revision: {} (latest = {})\n'
+            'children:\n'
+            '{}'
+        ).format(self.report.description, self.report.revision_current, self.report.revision_latest, '\n'.join(self._tree_lines(1)) or '  <none>')
+
+    def _tree_lines(self, level):
+        """
+        Generates the indented hierarchy of the subtree for display.
+        """
+
+        indent = '  ' * level
+        lines = []
+        for name in self.report.branches:
+            lines.append('{}{}/ <branch>'.format(indent, name))
+            if name in self.children:
+                lines.extend(self.children[name]._tree_lines(level + 1))
+        for name, obj in self.report.leaves:
+            lines.append('{}{}  <{} ({}, v{})>'.format(indent, name, obj.cls, obj.group, obj.version))
+        return lines
+
+    def walk(self, path=''):
+        """
+        Iterates over the described branches of the subtree.
+
+        Yields a (path, BranchReport) tuple for each branch, starting with the
+        subtree root. Paths are relative to the subtree root, the root has
+        the path ''.
+
+        :param path: The path prefix (default='').
+        :return: A generator of (path, BranchReport) tuples.
+        """
+
+        yield path, self.report
+        for name in self.report.branches:
+            if name in self.children:
+                yield from self.children[name].walk('{}/{}'.format(path, name) if path else name)
+
+    def to_dict(self):
+        """
+        Serialises the object into a dictionary.
+
+        :return: Serialised object.
+        """
+
+        d = self.report.to_dict()
+        d['subtrees'] = {name: child.to_dict() for name, child in self.children.items()}
+        return d
+
+    @classmethod
+    def from_dict(cls, d):
+
+        return cls(
+            report=BranchReport.from_dict(d),
+            children={name: cls.from_dict(child) for name, child in d['subtrees'].items()}
+        )
+
+
 class LeafReport:
     """
     Describes the contents of a leaf node.
@@ -1,7 +1,68 @@
-from re import match
+import re
+from functools import lru_cache
 from string import whitespace
 from .exception import InvalidPath
 
+# number of recently decomposed paths retained by the path cache
+CACHE_SIZE = 4096
+
+_SEGMENT_PATTERN = re.compile(r"^(/?[a-z0-9.\-_]+)$")
+_PATH_PATTERN = re.compile(r"^(/|(/?[a-z0-9.\-_]+(/[a-z0-9.\-_]+)*))(:(([0-9]+)|(head)))?$")
+
+
+class Path(str):
+    """
+    A parsed, normalised path.
+
+    Path is a string holding the normalised path, so may be used anywhere a
+    path string is accepted. The decomposed path is held alongside the
+    string and is used by decompose() in place of parsing the path again.
+    Parse a path once where it enters the system and pass the Path on.
+
+    Raises an InvalidPath exception if the path does not conform to the
+    data system path specification.
+
+    :param path: A path string.
+    """
+
+    __slots__ = ('segments', 'revision', 'absolute')
+
+    def __new__(cls, path):
+
+        if isinstance(path, Path):
+            return path
+
+        segments, revision, absolute = _decompose(path, True)
+        return cls._create(segments, revision, absolute)
+
+    @classmethod
+    def _create(cls, segments, revision, absolute):
+        """
+        Creates a Path from a normalised, decomposed path.
+        """
+
+        path = str.__new__(cls, _compose(segments, revision, absolute))
+        path.segments = tuple(segments)
+        path.revision = revision
+        path.absolute = absolute
+        return path
+
+    def at(self, revision):
+        """
+        Returns the path of the node at the specified revision.
+
+        :param revision: The revision number, 0 for the head revision.
+        :return: A Path instance.
+        """
+
+        revision = int(revision)
+        if revision < 0:
+            raise InvalidPath("The revision number cannot be negative.")
+        return Path._create(self.segments, revision, self.absolute)
+
+    def __repr__(self):
+        return 'Path({})'.format(str.__repr__(self))
+
 
 def is_valid(path):
     """
@@ -23,7 +84,7 @@ def segment_valid(path_segment):
     :return: True if the path segment is valid, False if not.
     """
 
-    return match(r"^(/?[a-z0-9.\-_]+)$", path_segment) is not None
+    return _SEGMENT_PATTERN.match(path_segment) is not None
 
 
 def is_absolute(path):
@@ -75,6 +136,28 @@ def decompose(path, normalise=True):
     >> decompose("../n/../m/:head", normalise=False)
     (["..", "n", "..", "m"], 0, False)
 
+    Recently decomposed paths are cached. A Path instance is returned without
+    parsing, it is already normalised.
+
+    :param path: A path string.
+    :param normalise: Enable/disable path normalisation.
+    :return: A tuple containing the decomposed path.
+    """
+
+    if isinstance(path, Path):
+        return list(path.segments), path.revision, path.absolute
+
+    segments, revision, absolute = _decompose(path, normalise)
+    return list(segments), revision, absolute
+
+
+@lru_cache(maxsize=CACHE_SIZE)
+def _decompose(path, normalise):
+    """
+    Splits the path into its component parts, see decompose().
+
+    The path segments are returned as a tuple as the result is cached.
+
     :param path: A path string.
     :param normalise: Enable/disable path normalisation.
     :return: A tuple containing the decomposed path.
@@ -92,7 +175,7 @@ def decompose(path, normalise=True):
 
     # is this an absolute root path?
     if subpath == "/":
-        return [], revision, True
+        return (), revision, True
     segments = subpath.split("/")
 
     # if there is an initial blank segment this is an absolute path
@@ -105,7 +188,7 @@ def decompose(path, normalise=True):
     if normalise:
         segments = _normalise_path_segments(segments, absolute)
 
-    return segments, revision, absolute
+    return tuple(segments), revision, absolute
 
 
 def normalise(path):
@@ -189,7 +272,7 @@ def _validate(path):
     :return: True if the path is valid, False if not.
     """
 
-    return match(r"^(/|(/?[a-z0-9.\-_]+(/[a-z0-9.\-_]+)*))(:(([0-9]+)|(head)))?$", path) is not None
+    return _PATH_PATTERN.match(path) is not None
 
 
 def _sanitise_and_check(path):
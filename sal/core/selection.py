@@ -0,0 +1,272 @@
+"""
+Describes subsets of data object arrays for sliced data requests.
+
+A selection is specified per dimension of a data object either as an index
+slice or, for objects with coordinate dimensions (such as Signal), a
+coordinate range. Selections are passed between the client and server via
+the query string, see Selection.to_query() and Selection.from_query().
+
+A selection may also request the selected data is reduced to a fixed number
+of bins per dimension, see the bins and reduce parameters of Selection.
+"""
+
+REDUCTIONS = ('mean', 'min', 'max')
+
+
+class Selection:
+    """
+    Describes a subset of the data held by a data object.
+
+    Index slices are specified with python slice objects, one per dimension.
+    Coordinate ranges are specified with (lower, upper, step) tuples, one per
+    dimension. The lower and upper coordinates are inclusive, the step is an
+    index step applied to the points within the range. Any element may be
+    None (or omitted), in which case the whole of that dimension is selected.
+    Trailing dimensions that are not specified are selected in full.
+
+    For example, to select every 10th point of the first dimension and the
+    first 5 points of the second dimension::
+
+        Selection(slices=[slice(None, None, 10), slice(0, 5)])
+
+    To select a time window between 0.1 and 0.2 seconds on the first
+    dimension of a signal::
+
+        Selection(ranges=[(0.1, 0.2, None)])
+
+    A dimension may be selected using either an index slice or a range, but
+    not both. Slice and range steps must be positive.
+
+    The selected data may be decimated to at most a fixed number of bins per
+    dimension, the points in each bin are combined with the reduction
+    specified by reduce: 'mean', 'min' or 'max'. Binning is applied after the
+    slices and ranges. For example, to obtain a 1000 point envelope of the
+    maximum of a long signal::
+
+        Selection(bins=[1000], reduce='max')
+
+    Binning is only supported by data classes with coordinate dimensions,
+    such as Signal.
+
+    :param slices: A sequence of slice objects or None (default=None).
+    :param ranges: A sequence of (lower, upper, step) tuples or None (default=None).
+    :param bins: A sequence of bin counts or None (default=None).
+    :param reduce: The bin reduction, 'mean', 'min' or 'max' (default='mean').
+    """
+
+    def __init__(self, slices=None, ranges=None, bins=None, reduce=None):
+
+        slices = tuple(slices or ())
+        ranges = tuple(ranges or ())
+        bins = tuple(bins or ())
+
+        for s in slices:
+            if s is None:
+                continue
+            if not isinstance(s, slice):
+                raise TypeError('Slices must be slice objects or None.')
+            self._validate_step(s.step)
+
+        normalised = []
+        for r in ranges:
+            if r is None:
+                normalised.append(None)
+                continue
+            lower, upper, step = (tuple(r) + (None, None, None))[:3]
+            lower = None if lower is None else float(lower)
+            upper = None if upper is None else float(upper)
+            self._validate_step(step)
+            if lower is not None and upper is not None and lower > upper:
+                raise ValueError('The lower bound of a range must not exceed the upper bound.')
+            normalised.append((lower, upper, step))
+        ranges = tuple(normalised)
+
+        # a dimension may only be selected by a slice or a range
+        for s, r in zip(slices, ranges):
+            if not self._is_full(s) and r is not None:
+                raise ValueError('A dimension cannot be selected by both an index slice and a coordinate range.')
+
+        for b in bins:
+            if b is not None and (int(b) != b or b < 1):
+                raise ValueError('Bin counts must be positive integers.')
+        bins = tuple(None if b is None else int(b) for b in bins)
+
+        if reduce is not None and not any(b is not None for b in bins):
+            raise ValueError('A reduction can only be specified if bins are requested.')
+        reduce = reduce or 'mean'
+        if reduce not in REDUCTIONS:
+            raise ValueError('The reduction must be one of: {}.'.format(', '.join(REDUCTIONS)))
+
+        self.slices = slices
+        self.ranges = ranges
+        self.bins = bins
+        self.reduce = reduce
+
+    def __repr__(self):
+        return '<Selection (slices={}, ranges={}, bins={}, reduce={})>'.format(self.slices, self.ranges, self.bins, self.reduce)
+
+    @property
+    def has_ranges(self):
+        """
+        True if the selection contains coordinate ranges.
+        """
+        return any(r is not None for r in self.ranges)
+
+    @property
+    def has_bins(self):
+        """
+        True if the selection requests the data is binned.
+        """
+        return any(b is not None for b in self.bins)
+
+    def index(self, ndim):
+        """
+        Returns a tuple of index slices for an array with ndim dimensions.
+
+        :param ndim: Number of array dimensions.
+        :return: A tuple of slice objects.
+        """
+
+        if len(self.slices) > ndim or len(self.ranges) > ndim or len(self.bins) > ndim:
+            raise ValueError('The selection has more dimensions than the data ({}).'.format(ndim))
+
+        return tuple(self._slice(i) for i in range(ndim))
+
+    def resolve(self, dimensions):
+        """
+        Returns a tuple of index slices for a list of coordinate dimensions.
+
+        Coordinate ranges are converted to index slices using the dimension
+        objects. Each dimension must provide a coordinate_slice() method.
+
+        :param dimensions: A list of Dimension objects.
+        :return: A tuple of slice objects.
+        """
+
+        slices = list(self.index(len(dimensions)))
+        for i, r in enumerate(self.ranges):
+            if r is None:
+                continue
+            lower, upper, step = r
+            s = dimensions[i].coordinate_slice(lower, upper)
+            slices[i] = slice(s.start, s.stop, step)
+
+        # a selection must not produce an empty dimension
+        for s, dimension in zip(slices, dimensions):
+            if not len(range(*s.indices(len(dimension)))):
+                raise ValueError('The selection does not contain any data.')
+
+        return tuple(slices)
+
+    def to_query(self):
+        """
+        Encodes the selection as query string arguments.
+
+        :return: A dictionary of query arguments.
+        """
+
+        query = {}
+        if any(not self._is_full(s) for s in self.slices):
+            query['slice'] = ','.join(self._encode_item(s.start, s.stop, s.step) if s else '' for s in self.slices)
+        if self.has_ranges:
+            query['range'] = ','.join(self._encode_item(*r) if r else '' for r in self.ranges)
+        if self.has_bins:
+            query['bins'] = ','.join('' if b is None else str(b) for b in self.bins)
+            query['reduce'] = self.reduce
+        return query
+
+    @classmethod
+    def from_query(cls, slice_string=None, range_string=None, bins_string=None, reduce=None):
+        """
+        Decodes a selection from query string arguments.
+
+        Each argument is a comma separated list with an item per dimension.
+        Slice items take the form start:stop[:step], range items take the
+        form lower:upper[:step]. Any part of an item may be left empty. An
+        empty item selects the whole dimension. Bin items are bin counts, an
+        empty item leaves the dimension unbinned.
+
+        :param slice_string: The slice query argument (default=None).
+        :param range_string: The range query argument (default=None).
+        :param bins_string: The bins query argument (default=None).
+        :param reduce: The reduce query argument (default=None).
+        :return: A Selection object.
+        """
+
+        slices = []
+        if slice_string:
+            for item in slice_string.split(','):
+                start, stop, step = cls._decode_item(item, int)
+                slices.append(slice(start, stop, step))
+
+        ranges = []
+        if range_string:
+            for item in range_string.split(','):
+                lower, upper, step = cls._decode_item(item, float)
+                if lower is None and upper is None and step is None:
+                    ranges.append(None)
+                else:
+                    ranges.append((lower, upper, step))
+
+        bins = []
+        if bins_string:
+            for item in bins_string.split(','):
+                item = item.strip()
+                bins.append(int(item) if item else None)
+
+        return cls(slices, ranges, bins, reduce)
+
+    def _slice(self, i):
+        """
+        Returns the index slice for dimension i.
+        """
+
+        if i < len(self.slices) and self.slices[i] is not None:
+            return self.slices[i]
+        return slice(None)
+
+    @staticmethod
+    def _is_full(s):
+        """
+        Returns True if the slice selects the whole of a dimension.
+        """
+
+        return s is None or (s.start is None and s.stop is None and s.step in (None, 1))
+
+    @staticmethod
+    def _validate_step(step):
+        """
+        Checks a step is None or a positive integer.
+        """
+
+        if step is None:
+            return
+        if int(step) != step or step < 1:
+            raise ValueError('Steps must be positive integers.')
+
+    @staticmethod
+    def _encode_item(start, stop, step):
+        """
+        Encodes a single selection item e.g. '10:20:2'.
+        """
+
+        item = ['' if v is None else str(v) for v in (start, stop)]
+        if step is not None:
+            item.append(str(step))
+        return ':'.join(item)
+
+    @staticmethod
+    def _decode_item(item, dtype):
+        """
+        Decodes a single selection item e.g. '10:20:2'.
+        """
+
+        parts = item.strip().split(':')
+        if len(parts) > 3:
+            raise ValueError('Selection items may contain at most three fields.')
+        parts += [''] * (3 - len(parts))
+
+        start = dtype(parts[0]) if parts[0] else None
+        stop = dtype(parts[1]) if parts[1] else None
+        step = int(parts[2]) if parts[2] else None
+        return start, stop, step
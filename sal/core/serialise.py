@@ -1,21 +1,37 @@
 """
 Serialise persistence layer objects for transmission using JSON.
-"""
 
-# TODO: add unit tests
+A binary envelope is also provided for bulk array transport. The envelope
+carries the JSON document as a header followed by the raw array buffers, see
+encode_binary() and decode_binary(). Envelopes may be generated and read
+incrementally, see iter_binary() and EnvelopeReader.
+"""
 
-import base64
+import re
+import json
+import uuid
+import struct
+import binascii
 
 import numpy as _np
 
 from sal.core.object import DataClass, build
+from sal.core.object.dataclass import _adopting
 from sal.core.exception import InternalError
-from sal.core.object import Branch, BranchReport, LeafReport
+from sal.core import compression as _compression
+from sal.core.object import Branch, BranchReport, LeafReport, TreeReport
 
 # supported numpy types
 _NUMPY_INTEGER_TYPES = (_np.int8, _np.int16, _np.int32, _np.int64, _np.uint8, _np.uint16, _np.uint32, _np.uint64)
 _NUMPY_FLOAT_TYPES = (_np.float32, _np.float64)
 
+
+class _Columns:
+    """
+    Type marker for dictionaries encoded as typed columns, see _encode_columns().
+    """
+
+
 # tables for converting numpy->type id and vice versa
 _TYPES_NUMPY_TO_ID = {
     _np.int8: 'int8',
@@ -32,7 +48,8 @@ _TYPES_NUMPY_TO_ID = {
     str: 'string',
     _np.str_: 'string',
     _np.ndarray: 'array',
-    dict: 'branch'
+    dict: 'branch',
+    _Columns: 'columns'
 }
 
 _TYPES_ID_TO_NUMPY = {
@@ -49,15 +66,85 @@ _TYPES_ID_TO_NUMPY = {
     'bool': bool,
     'string': str,
     'array': _np.ndarray,
-    'branch': dict
+    'branch': dict,
+    'columns': _Columns
 }
 
+# scalar encoders keyed by exact python/numpy type: type -> (type id, value conversion or None)
+# exact type lookups avoid an isinstance() chain per item, values of other types take the general path
+_SCALAR_ENCODERS = {
+    bool: ('bool', None),
+    int: ('int64', None),
+    float: ('float64', None),
+    str: ('string', None),
+    _np.str_: ('string', None),
+}
+_SCALAR_ENCODERS.update({t: (_TYPES_NUMPY_TO_ID[t], int) for t in _NUMPY_INTEGER_TYPES})
+_SCALAR_ENCODERS.update({t: (_TYPES_NUMPY_TO_ID[t], float) for t in _NUMPY_FLOAT_TYPES})
+
+# binary transport content type
+BINARY_MIME_TYPE = 'application/x-sal-binary'
+
+# binary envelope preamble: magic, envelope version, header length
+_BINARY_MAGIC = b'SALB'
+_BINARY_VERSION = 1
+_BINARY_PREAMBLE = struct.Struct('<4sIQ')
+
+# all envelope buffers start on an aligned byte boundary
+_BINARY_ALIGNMENT = 64
+
+# upper limit on the header size accepted by the streaming reader, guards against corrupt preambles
+_BINARY_MAX_HEADER = 256 * 1024 * 1024
+
+# default size of the chunks generated and read when streaming envelopes
+BINARY_CHUNK_SIZE = 8 * 1024 * 1024
+
+# numerical arrays of at least this size are deferred when generating skeleton documents
+DEFER_THRESHOLD = 64 * 1024
 
-def serialise(obj):
+# optional document encodings supported by this implementation, peers only use an encoding the other side lists
+ENCODINGS = ('columnar',)
+
+# request header listing the optional document encodings accepted by the client
+ENCODING_HEADER = 'X-SAL-Encoding'
+
+# dictionaries of at least this many scalar values are encoded as typed columns if the columnar encoding is enabled
+COLUMNAR_THRESHOLD = 256
+
+# column value types held as JSON lists rather than numerical arrays
+_LIST_COLUMN_TYPES = ('bool', 'string')
+
+
+def serialise(obj, buffers=None, compression=None, defer=None, columnar=False):
     """
     Encodes a persistence layer object in a json compatible serialised representation.
 
+    If a buffers list is supplied, numerical arrays are not embedded in the
+    document. Instead, the raw array data is appended to the list and the
+    document references the buffer by index. The document and buffers may
+    then be packed for transmission with encode_binary().
+
+    If a compression scheme is specified (see sal.core.compression), large
+    numerical arrays are compressed. Arrays that do not compress are sent
+    uncompressed.
+
+    If defer is specified, a skeleton document is generated. Numerical
+    arrays of at least defer bytes are omitted, the document only records
+    their type, shape and component key. The component key is the '/'
+    separated path of the array in the object dictionary e.g.
+    'dimensions/0/data'.
+
+    If columnar is True, dictionaries holding many scalar values are encoded
+    as typed columns: the values are grouped by type and each group is packed
+    into a single array (see _encode_columns()). The columnar encoding must
+    only be used if the recipient supports it (see ENCODINGS), it is
+    decoded transparently by deserialise().
+
     :param obj: Persistence layer object.
+    :param buffers: Optional list to receive raw array buffers (default=None).
+    :param compression: Optional compression scheme name (default=None).
+    :param defer: Optional minimum size in bytes of the arrays to omit (default=None).
+    :param columnar: Encode large scalar dictionaries as typed columns (default=False).
     :return: A dictionary containing the serialised object.
     """
 
@@ -68,6 +155,13 @@ def serialise(obj):
             'object': obj.to_dict()
         }
 
+    if isinstance(obj, TreeReport):
+        return {
+            'content': 'report',
+            'type': 'tree',
+            'object': obj.to_dict()
+        }
+
     if isinstance(obj, LeafReport):
         return {
             'content': 'report',
@@ -86,15 +180,30 @@ def serialise(obj):
         return {
             'content': 'object',
             'type': 'leaf',
-            'object': encode_types(obj.to_dict())
+            'object': encode_types(obj.to_dict(), buffers, compression, defer, columnar=columnar)
         }
 
 
-def deserialise(d):
+def deserialise(d, buffers=None, deferred=None, adopt=False):
     """
     Decodes a persistence layer object from a serialised representation.
 
+    The buffers list must be supplied if the document references array
+    buffers (see serialise()). By default, arrays held in the buffers are
+    copied into the decoded object. If adopt is True, the buffers are handed
+    over to the decoded object and its arrays are views of the buffers. The
+    caller must not modify or reuse the buffers afterwards.
+
+    A deferred dictionary must be supplied to decode skeleton documents.
+    Omitted arrays are replaced by zero filled placeholder arrays of the
+    correct type and shape, the dictionary is populated with the component
+    key and placeholder of each omitted array. The placeholder memory is not
+    committed until written.
+
     :param d: A dictionary containing the serialised object.
+    :param buffers: Optional list of raw array buffers (default=None).
+    :param deferred: Optional dictionary to receive placeholder arrays (default=None).
+    :param adopt: The decoded object adopts the buffers without copying (default=False).
     :return: Persistence layer object.
     """
 
@@ -113,37 +222,54 @@ def deserialise(d):
         if type == 'leaf':
             return LeafReport.from_dict(obj)
 
+        if type == 'tree':
+            return TreeReport.from_dict(obj)
+
     elif content == 'object':
 
         if type == 'branch':
             return Branch.from_dict(obj)
 
         if type == 'leaf':
-            # data class requires decoding of types
-            return build(decode_types(obj))
+            # data class requires decoding of types, the decoded arrays are not referenced elsewhere
+            decoded = decode_types(obj, buffers, deferred, adopt)
+            with _adopting():
+                return build(decoded)
 
     raise InternalError('Unrecognised class type.')
 
 
-def encode_types(d):
+def encode_types(d, buffers=None, compression=None, defer=None, prefix='', columnar=False):
     """
     Encodes python/numpy types for transmission over json transport.
 
     :param d: Dictionary containing typed data.
+    :param buffers: Optional list to receive raw array buffers (default=None).
+    :param compression: Optional compression scheme name (default=None).
+    :param defer: Optional minimum size in bytes of the arrays to omit (default=None).
+    :param prefix: The component key prefix of the dictionary (default='').
+    :param columnar: Encode large scalar dictionaries as typed columns (default=False).
     :return: Encoded data.
     """
 
     packed = {}
     for key, item in d.items():
 
-        if item is None:
+        # fast path for the common scalar types
+        encoder = _SCALAR_ENCODERS.get(type(item))
+        if encoder is not None:
+            dtype, convert = encoder
+            packed[key] = {'type': dtype, 'value': item if convert is None else convert(item)}
+
+        elif item is None:
             packed[key] = None
 
         elif isinstance(item, dict):
-            packed[key] = _encode_branch(item)
+            columns = _encode_columns(item, buffers, compression) if columnar else None
+            packed[key] = columns or _encode_branch(item, buffers, compression, defer, prefix + key + '/', columnar)
 
         elif isinstance(item, _np.ndarray):
-            packed[key] = _encode_array(item)
+            packed[key] = _encode_array(item, buffers, compression, defer, prefix + key)
 
         else:
             packed[key] = _encode_scalar(item)
@@ -151,25 +277,107 @@ def encode_types(d):
     return packed
 
 
-def _encode_branch(d):
+def _encode_branch(d, buffers=None, compression=None, defer=None, prefix='', columnar=False):
     """
     Encodes branch nodes for transmission over json transport.
 
     :param d: Dictionary containing typed data.
+    :param buffers: Optional list to receive raw array buffers (default=None).
+    :param compression: Optional compression scheme name (default=None).
+    :param defer: Optional minimum size in bytes of the arrays to omit (default=None).
+    :param prefix: The component key prefix of the dictionary (default='').
+    :param columnar: Encode large scalar dictionaries as typed columns (default=False).
     :return: Encoded data.
     """
 
     return {
         'type': _TYPES_NUMPY_TO_ID[dict],
-        'value': encode_types(d)
+        'value': encode_types(d, buffers, compression, defer, prefix, columnar)
+    }
+
+
+def _encode_columns(d, buffers=None, compression=None):
+    """
+    Encodes a dictionary of scalar values as typed columns.
+
+    The keys are listed in order and the values are grouped by type id, each
+    group forms a column. Numerical columns are packed into a single array,
+    encoded as per any other array, so the values are transferred as one
+    buffer (or base64 string) per type rather than a type-encoded object per
+    value. Boolean and string columns are JSON lists. The index array holds
+    the column of each key, it is omitted if there is only one column.
+
+    Dictionaries with fewer than COLUMNAR_THRESHOLD values, or holding any
+    value that is not a scalar, are not encoded as columns.
+
+    :param d: Dictionary containing typed data.
+    :param buffers: Optional list to receive raw array buffers (default=None).
+    :param compression: Optional compression scheme name (default=None).
+    :return: Encoded data or None if the dictionary is not suitable.
+    """
+
+    if len(d) < COLUMNAR_THRESHOLD:
+        return None
+
+    # group the values by type id, columns are numbered in order of appearance
+    groups = {}
+    index = []
+    for item in d.values():
+        encoder = _SCALAR_ENCODERS.get(type(item))
+        if encoder is None:
+            return None
+
+        group = groups.get(encoder[0])
+        if group is None:
+            group = groups[encoder[0]] = (len(groups), [])
+        index.append(group[0])
+        group[1].append(item)
+
+    columns = []
+    for dtype, (_, values) in groups.items():
+        if dtype not in _LIST_COLUMN_TYPES:
+            try:
+                values = _np.array(values, dtype=_TYPES_ID_TO_NUMPY[dtype])
+            except OverflowError:
+                # python integers outside the int64 range
+                return None
+            values = _encode_array(values, buffers, compression)['value']
+        columns.append({'type': dtype, 'values': values})
+
+    value = {
+        'keys': list(d.keys()),
+        'columns': columns
     }
 
+    if len(columns) > 1:
+        value['index'] = _encode_array(_np.array(index, dtype=_np.uint8), buffers, compression)['value']
 
-def _encode_array(d):
+    return {
+        'type': _TYPES_NUMPY_TO_ID[_Columns],
+        'value': value
+    }
+
+
+def _encode_array(d, buffers=None, compression=None, defer=None, key=None):
     """
     Encodes arrays for transmission over json transport.
 
+    If a buffers list is supplied, numerical arrays are appended to the list
+    as little endian, c-ordered arrays and referenced by index.
+
+    If a compression scheme is supplied, numerical arrays larger than the
+    compression threshold are compressed. The compressed data replaces the
+    raw data in the buffer or base64 string, the scheme and the compressed
+    block sizes are recorded in the 'compression' and 'blocks' attributes.
+
+    If defer is specified, numerical arrays of at least defer bytes are
+    encoded as 'deferred', the data attribute holds the component key.
+
     :param d: Dictionary containing typed data.
+    :param buffers: Optional list to receive raw array buffers (default=None).
+    :param compression: Optional compression scheme name (default=None).
+    :param defer: Optional minimum size in bytes of the arrays to omit (default=None).
+    :param key: The component key of the array (default=None).
     :return: Encoded data.
     """
 
@@ -193,21 +401,52 @@ def _encode_array(d):
             }
         }
 
-    else:
-
-        # base64 encode
-        data = d.tostring()
-        encoded = base64.b64encode(data).decode('utf-8')
+    if defer is not None and d.nbytes >= defer:
         return {
             'type': dtype,
             'value': {
                 'type': array_dtype,
                 'shape': shape,
-                'encoding': 'base64',
-                'data': encoded
+                'encoding': 'deferred',
+                'data': key
             }
         }
 
+    # no copy is made if the array is already little endian and contiguous
+    data = _np.ascontiguousarray(d, dtype=d.dtype.newbyteorder('<'))
+
+    value = {
+        'type': array_dtype,
+        'shape': shape
+    }
+
+    if compression and data.nbytes >= _compression.COMPRESSION_THRESHOLD:
+
+        # only keep the compressed data if it is smaller
+        compressed, blocks = _compression.compress(data, compression)
+        if len(compressed) < data.nbytes:
+            value['compression'] = compression
+            value['blocks'] = blocks
+            data = compressed
+
+    if buffers is not None:
+
+        # raw buffer
+        buffers.append(data)
+        value['encoding'] = 'buffer'
+        value['data'] = len(buffers) - 1
+
+    else:
+
+        # base64 encode
+        value['encoding'] = 'base64'
+        value['data'] = binascii.b2a_base64(_byte_view(data), newline=False).decode('ascii')
+
+    return {
+        'type': dtype,
+        'value': value
+    }
+
 
 def _encode_scalar(d):
     """
@@ -251,11 +490,14 @@ def _encode_scalar(d):
     }
 
 
-def decode_types(d):
+def decode_types(d, buffers=None, deferred=None, adopt=False):
     """
     Decodes python/numpy types from json encoding.
 
     :param d: Dictionary containing encoded type data.
+    :param buffers: Optional list of raw array buffers (default=None).
+    :param deferred: Optional dictionary to receive placeholder arrays (default=None).
+    :param adopt: Return arrays held in the buffers as views of the buffers (default=False).
     :return: Decoded data.
     """
 
@@ -273,20 +515,83 @@ def decode_types(d):
             raise InternalError('Malformed type data found during de-serialisation.')
 
         if dtype is dict:
-            decoded[key] = decode_types(value)
+            decoded[key] = decode_types(value, buffers, deferred, adopt)
+        elif dtype is _Columns:
+            decoded[key] = _decode_columns(value, buffers)
         elif dtype is _np.ndarray:
-            decoded[key] = _decode_array(value)
+            decoded[key] = _decode_array(value, buffers, deferred, adopt)
         else:
             decoded[key] = dtype(value)
 
     return decoded
 
 
-def _decode_array(d):
+def _decode_columns(d, buffers=None):
+    """
+    Decodes a dictionary encoded as typed columns, see _encode_columns().
+
+    The values are returned as the same python/numpy types as type-encoded
+    scalars, the key order is preserved.
+
+    :param d: Dictionary containing encoded column data.
+    :param buffers: Optional list of raw array buffers (default=None).
+    :return: Decoded data.
+    """
+
+    try:
+        keys = d['keys']
+        columns = []
+        for column in d['columns']:
+            dtype = _TYPES_ID_TO_NUMPY[column['type']]
+            values = column['values']
+            if column['type'] in _LIST_COLUMN_TYPES:
+                values = [dtype(value) for value in values]
+            elif dtype in _NUMPY_INTEGER_TYPES or dtype in _NUMPY_FLOAT_TYPES:
+                # the column is unpacked into scalars, a view of the buffer is sufficient
+                values = _decode_array(values, buffers, adopt=True)
+                if values.ndim != 1:
+                    raise InternalError('Malformed column data found during de-serialisation.')
+            else:
+                raise InternalError('Malformed column data found during de-serialisation.')
+            columns.append(values)
+        index = _decode_array(d['index'], buffers, adopt=True) if len(columns) > 1 else None
+    except (KeyError, TypeError):
+        raise InternalError('Malformed column data found during de-serialisation.')
+
+    # iterating a numerical column yields numpy scalars of the column type
+    if index is None:
+        if len(columns) != 1 or len(columns[0]) != len(keys):
+            raise InternalError('Malformed column data found during de-serialisation.')
+        return dict(zip(keys, columns[0]))
+
+    if index.shape != (len(keys),) or index.dtype.kind != 'u':
+        raise InternalError('Malformed column data found during de-serialisation.')
+
+    counts = _np.bincount(index, minlength=len(columns))
+    if len(counts) != len(columns) or any(count != len(column) for count, column in zip(counts, columns)):
+        raise InternalError('Malformed column data found during de-serialisation.')
+
+    iterators = [iter(column) for column in columns]
+    return {key: next(iterators[column]) for key, column in zip(keys, index.tolist())}
+
+
+def _decode_array(d, buffers=None, deferred=None, adopt=False):
     """
     Decodes arrays from json encoding.
 
+    If adopt is True, arrays held in raw buffers are returned as views of the
+    buffer, no copy of the data is made. The arrays are only writable if the
+    buffers are writable. A buffer supplied as a numpy array of the decoded
+    dtype and shape is returned as it is (see buffer_targets()). Otherwise
+    the arrays are copied out of the buffers. Compressed and base64 encoded
+    arrays are always decoded into new, writable arrays.
+
+    Deferred arrays are replaced by a placeholder, see deserialise().
+
     :param d: Dictionary containing encoded type data.
+    :param buffers: Optional list of raw array buffers (default=None).
+    :param deferred: Optional dictionary to receive placeholder arrays (default=None).
+    :param adopt: Return arrays held in raw buffers as views of the buffers (default=False).
     :return: Decoded data.
     """
 
@@ -298,12 +603,531 @@ def _decode_array(d):
     except KeyError:
         raise InternalError('Malformed array data found during de-serialisation.')
 
-    if encoding == 'base64':
-        return _np.fromstring(base64.b64decode(data), dtype=dtype).reshape(shape)
-
     if encoding == 'list':
         return _np.array(data, dtype=dtype)
 
-    raise InternalError('Unrecognised array encoding type found during de-serialisation.')
+    if encoding == 'deferred':
+        if deferred is None:
+            raise InternalError('Skeleton documents require a deferred dictionary during de-serialisation.')
+
+        # zero filled allocations are not committed until written
+        placeholder = _np.zeros(shape, dtype=_np.dtype(dtype).newbyteorder('<'))
+        deferred[data] = placeholder
+        return placeholder
+
+    if encoding == 'base64':
+        try:
+            buffer = bytearray(binascii.a2b_base64(data))
+        except (binascii.Error, TypeError, ValueError):
+            raise InternalError('Malformed array data found during de-serialisation.')
+
+    elif encoding == 'buffer':
+        try:
+            buffer = buffers[data]
+        except (TypeError, IndexError):
+            raise InternalError('Array references a buffer that was not supplied during de-serialisation.')
+
+    else:
+        raise InternalError('Unrecognised array encoding type found during de-serialisation.')
+
+    compression = d.get('compression')
+    if compression:
+        try:
+            blocks = d['blocks']
+        except KeyError:
+            raise InternalError('Malformed array data found during de-serialisation.')
+        return _compression.decompress(buffer, blocks, compression, dtype, shape)
+
+    dtype = _np.dtype(dtype).newbyteorder('<')
+    if isinstance(buffer, _np.ndarray) and buffer.dtype == dtype and buffer.shape == tuple(shape):
+        array = buffer
+    else:
+        array = _np.frombuffer(buffer, dtype=dtype).reshape(shape)
+    return array if adopt or encoding == 'base64' else array.copy()
+
+
+def buffer_targets(document, lengths, target):
+    """
+    Matches the buffers of a serialised document with the arrays of an object.
+
+    The arrays of the target object's dictionary representation that have
+    the dtype and shape of an uncompressed buffer array, at the same
+    position in the document, are returned as the destinations for the
+    buffers. Reading the buffers into the target arrays (see
+    EnvelopeReader.read_buffers()) and passing the arrays to deserialise()
+    builds an object that adopts the target arrays, no array memory is
+    allocated.
+
+    An array is only used as a destination if it is C contiguous, writable
+    and little endian. Buffers without a suitable destination have no
+    target.
+
+    :param document: A serialised leaf object document.
+    :param lengths: The buffer lengths in bytes.
+    :param target: A DataObject instance.
+    :return: A list holding a numpy array or None for each buffer.
+    """
+
+    targets = [None] * len(lengths)
+    if document.get('content') != 'object' or document.get('type') != 'leaf' or not isinstance(target, DataClass):
+        return targets
+
+    used = set()
+
+    def match(encoded, current):
+        for key, item in encoded.items():
+
+            if not isinstance(item, dict) or not isinstance(current, dict) or key not in current:
+                continue
+
+            kind = _TYPES_ID_TO_NUMPY.get(item.get('type'))
+            value = item.get('value')
+            if kind is dict and isinstance(value, dict):
+                match(value, current[key])
+                continue
+
+            array = current[key]
+            if kind is not _np.ndarray or not isinstance(array, _np.ndarray) or not isinstance(value, dict):
+                continue
+
+            index = value.get('data')
+            if value.get('encoding') != 'buffer' or value.get('compression') or not isinstance(index, int) or not 0 <= index < len(targets):
+                continue
+
+            try:
+                dtype = _np.dtype(_TYPES_ID_TO_NUMPY[value['type']]).newbyteorder('<')
+            except (KeyError, TypeError):
+                continue
+
+            suitable = array.dtype == dtype and array.shape == tuple(value.get('shape', ())) \
+                and array.flags.c_contiguous and array.flags.writeable and array.nbytes == lengths[index]
+
+            if suitable and id(array) not in used:
+                targets[index] = array
+                used.add(id(array))
+
+    match(document.get('object', {}), target.to_dict())
+    return targets
+
+
+def encode_binary(document, buffers):
+    """
+    Packs a serialised document and its array buffers into a binary envelope.
+
+    See iter_binary() for a description of the envelope layout.
+
+    :param document: A JSON compatible dictionary (see serialise()).
+    :param buffers: A list of raw array buffers referenced by the document.
+    :return: A bytes object containing the envelope.
+    """
+
+    return b''.join(iter_binary(document, buffers))
+
+
+def iter_binary(document, buffers, chunk_size=None):
+    """
+    Generates the binary envelope for a document and its buffers in chunks.
+
+    The envelope consists of:
+
+        preamble: magic b'SALB' (4 bytes), version (uint32), header length (uint64)
+        header: the JSON document encoded as UTF-8
+        buffers: the raw buffers in document order
+
+    All integers are little endian. The header and each buffer are padded with
+    zeros to start on a 64 byte boundary. The header document lists the length
+    of each buffer in bytes under the key '_buffers'.
+
+    The chunks reference the buffer memory directly, no copies of the array
+    data are made. By default each buffer is generated as a single chunk, if
+    chunk_size is specified the buffers are split into chunks of at most
+    chunk_size bytes.
+
+    :param document: A JSON compatible dictionary (see serialise()).
+    :param buffers: A list of raw array buffers referenced by the document.
+    :param chunk_size: The maximum buffer chunk size in bytes (default=None).
+    :return: A generator yielding bytes-like objects.
+    """
+
+    views = [_byte_view(buffer) for buffer in buffers]
+
+    yield _binary_header(document, [view.nbytes for view in views])
+
+    for view in views:
+        if chunk_size:
+            for offset in range(0, view.nbytes, chunk_size):
+                yield view[offset:offset + chunk_size]
+        else:
+            yield view
+        yield _padding(view.nbytes)
+
+
+def iter_json(document, buffers=None, chunk_size=BINARY_CHUNK_SIZE):
+    """
+    Generates the JSON text of a serialised document in chunks.
+
+    The document may reference array buffers (see serialise()), the arrays
+    are base64 encoded as the text is generated so the generated text is
+    identical to that of a document serialised without a buffers list. The
+    base64 text of an array is generated in chunks of approximately
+    chunk_size bytes, so the complete text is never held in memory.
+
+    :param document: A JSON compatible dictionary (see serialise()).
+    :param buffers: A list of raw array buffers referenced by the document (default=None).
+    :param chunk_size: The approximate maximum chunk size in bytes (default=BINARY_CHUNK_SIZE).
+    :return: A generator yielding bytes objects.
+    """
+
+    if not buffers:
+        yield json.dumps(document).encode('utf-8')
+        return
+
+    # buffer references are replaced by unique markers, the text is split at each marker
+    marker = 'sal-buffer-{}-'.format(uuid.uuid4().hex)
+    text = json.dumps(_mark_buffers(document, marker))
+    step = max(3, chunk_size // 4 * 3)
+
+    pieces = re.split('"{}([0-9]+)"'.format(marker), text)
+    for index, piece in enumerate(pieces):
+
+        # even pieces are document text, odd pieces are buffer indices
+        if index % 2 == 0:
+            yield piece.encode('utf-8')
+            continue
+
+        view = _byte_view(buffers[int(piece)])
+        yield b'"'
+        for offset in range(0, view.nbytes, step):
+            yield binascii.b2a_base64(view[offset:offset + step], newline=False)
+        yield b'"'
+
+
+def buffer_size(buffers):
+    """
+    Returns the total size of a list of array buffers in bytes.
+
+    :param buffers: A list of raw array buffers.
+    :return: The size in bytes.
+    """
+
+    return sum(_byte_view(buffer).nbytes for buffer in buffers)
+
+
+def decode_binary(data):
+    """
+    Unpacks a binary envelope into a serialised document and array buffers.
+
+    The returned buffers are memoryview slices of the supplied data, no copies
+    are made. The data may be any object supporting the buffer protocol e.g.
+    bytes, bytearray or mmap.
+
+    :param data: A bytes-like object containing the envelope.
+    :return: A tuple containing the document dictionary and buffer list.
+    """
+
+    data = memoryview(data).cast('B')
+
+    try:
+        magic, version, length = _BINARY_PREAMBLE.unpack_from(data)
+    except struct.error:
+        raise InternalError('Binary envelope is truncated.')
+
+    if magic != _BINARY_MAGIC or version != _BINARY_VERSION:
+        raise InternalError('Unrecognised binary envelope.')
+
+    offset = _BINARY_PREAMBLE.size
+    try:
+        document = json.loads(bytes(data[offset:offset + length]).decode('utf-8'))
+    except ValueError:
+        raise InternalError('Malformed binary envelope header.')
+    lengths = _buffer_lengths(document)
+
+    offset = _align(offset + length)
+    buffers = []
+    for length in lengths:
+        if offset + length > data.nbytes:
+            raise InternalError('Binary envelope is truncated.')
+        buffers.append(data[offset:offset + length])
+        offset = _align(offset + length)
+
+    return document, buffers
+
+
+class EnvelopeReader:
+    """
+    Reads a binary envelope incrementally from a stream.
+
+    The preamble and header are read when the reader is created, the header
+    document is available via the document attribute. The array buffers are
+    then read in order, either in full with read_buffers() or one at a time
+    with buffers(). Reading the buffers one at a time allows the array data
+    to be passed straight to storage in chunks without holding the complete
+    envelope in memory.
+
+    The stream must provide a read() method (e.g. a file object or the WSGI
+    input stream). If the stream provides readinto(), data is read directly
+    into the destination memory.
+
+    :param stream: A binary stream positioned at the start of an envelope.
+    :raises InternalError: If the envelope is malformed or truncated.
+    """
+
+    def __init__(self, stream):
+
+        self._stream = stream
+        self._offset = 0
+
+        preamble = self._read(_BINARY_PREAMBLE.size)
+        magic, version, length = _BINARY_PREAMBLE.unpack(preamble)
+        if magic != _BINARY_MAGIC or version != _BINARY_VERSION:
+            raise InternalError('Unrecognised binary envelope.')
+
+        if length > _BINARY_MAX_HEADER:
+            raise InternalError('Malformed binary envelope header.')
+
+        try:
+            document = json.loads(bytes(self._read(length)).decode('utf-8'))
+        except ValueError:
+            raise InternalError('Malformed binary envelope header.')
+        lengths = _buffer_lengths(document)
+
+        self.document = document
+        self.lengths = lengths
+        self._next = 0
+
+    def chunks(self, size=BINARY_CHUNK_SIZE):
+        """
+        Regenerates the complete envelope in chunks.
+
+        The header is regenerated and the remaining buffers are read from the
+        stream. This allows a received envelope to be written to storage
+        without holding it in memory. The buffers must not have been read.
+
+        :param size: The maximum buffer chunk size in bytes (default=BINARY_CHUNK_SIZE).
+        :return: A generator yielding bytes-like objects.
+        """
+
+        if self._next:
+            raise InternalError('The envelope buffers have already been read.')
+
+        yield _binary_header(self.document, self.lengths)
+        for reader in self.buffers():
+            yield from reader.chunks(size)
+            yield _padding(reader.nbytes)
+
+    def buffers(self):
+        """
+        Generates a BufferReader for each envelope buffer in order.
+
+        Each buffer must be read before the next buffer is requested, any
+        unread data is discarded when the generator advances.
+
+        :return: A generator of BufferReader objects.
+        """
+
+        while self._next < len(self.lengths):
+            index = self._next
+            self._next += 1
+
+            self._skip(_align(self._offset) - self._offset)
+            reader = BufferReader(self, index, self.lengths[index])
+            yield reader
+            reader.discard()
+
+    def read_buffers(self, targets=None):
+        """
+        Reads all the remaining buffers into memory.
+
+        Each buffer is read into a separate writable bytearray. If a list of
+        targets is supplied (see buffer_targets()), the buffers with a
+        target array are read directly into the array and the array is
+        returned in place of a bytearray.
+
+        :param targets: Optional list of destination arrays or None for each buffer (default=None).
+        :return: A list of bytearray or numpy array objects.
+        """
+
+        buffers = []
+        for reader in self.buffers():
+            buffer = targets[reader.index] if targets is not None and reader.index < len(targets) else None
+            if buffer is None or _byte_view(buffer).nbytes != reader.nbytes:
+                buffer = bytearray(reader.nbytes)
+            reader.readinto(buffer)
+            buffers.append(buffer)
+        return buffers
+
+    def _read(self, size):
+        """
+        Reads exactly size bytes from the stream.
+        """
+
+        buffer = bytearray(size)
+        self._readinto(memoryview(buffer))
+        return buffer
+
+    def _readinto(self, view):
+        """
+        Fills the supplied byte memoryview from the stream.
+        """
+
+        filled = 0
+        readinto = getattr(self._stream, 'readinto', None)
+        while filled < view.nbytes:
+            if readinto:
+                count = readinto(view[filled:])
+            else:
+                chunk = self._stream.read(view.nbytes - filled)
+                count = len(chunk)
+                view[filled:filled + count] = chunk
+            if not count:
+                raise InternalError('Binary envelope is truncated.')
+            filled += count
+        self._offset += filled
+
+    def _skip(self, size):
+        """
+        Reads and discards size bytes from the stream.
+        """
+
+        while size > 0:
+            count = min(size, BINARY_CHUNK_SIZE)
+            self._read(count)
+            size -= count
+
+
+class BufferReader:
+    """
+    Reads a single buffer of a binary envelope.
+
+    Buffer readers are obtained from EnvelopeReader.buffers().
+
+    :param envelope: The parent EnvelopeReader.
+    :param index: The buffer index.
+    :param nbytes: The buffer length in bytes.
+    """
+
+    def __init__(self, envelope, index, nbytes):
+        self._envelope = envelope
+        self.index = index
+        self.nbytes = nbytes
+        self.remaining = nbytes
+
+    def readinto(self, buffer):
+        """
+        Reads buffer data into a writable bytes-like object.
+
+        At most the size of the supplied object is read.
+
+        :param buffer: A writable bytes-like object e.g. a bytearray or numpy array.
+        :return: The number of bytes read.
+        """
+
+        view = _byte_view(buffer)
+        count = min(view.nbytes, self.remaining)
+        self._envelope._readinto(view[:count])
+        self.remaining -= count
+        return count
+
+    def read(self, size=-1):
+        """
+        Reads up to size bytes of buffer data, all the remaining data if size is negative.
+
+        :param size: The maximum number of bytes to read (default=-1).
+        :return: A bytearray.
+        """
+
+        if size < 0 or size > self.remaining:
+            size = self.remaining
+        buffer = bytearray(size)
+        self.readinto(buffer)
+        return buffer
+
+    def chunks(self, size=BINARY_CHUNK_SIZE):
+        """
+        Generates the remaining buffer data in chunks.
+
+        :param size: The maximum chunk size in bytes (default=BINARY_CHUNK_SIZE).
+        :return: A generator of bytearray objects.
+        """
+
+        while self.remaining:
+            yield self.read(size)
+
+    def discard(self):
+        """
+        Skips any unread buffer data.
+        """
+
+        self._envelope._skip(self.remaining)
+        self.remaining = 0
+
+
+def _binary_header(document, lengths):
+    """
+    Returns the envelope preamble and header for a document, including the alignment padding.
+    """
+
+    header = dict(document)
+    header['_buffers'] = list(lengths)
+    header = json.dumps(header).encode('utf-8')
+
+    preamble = _BINARY_PREAMBLE.pack(_BINARY_MAGIC, _BINARY_VERSION, len(header))
+    return preamble + header + _padding(_BINARY_PREAMBLE.size + len(header))
+
+
+def _buffer_lengths(document):
+    """
+    Removes and validates the buffer lengths listed by an envelope header document.
+    """
+
+    lengths = document.pop('_buffers', None) if isinstance(document, dict) else None
+
+    # booleans are integers to python but are not valid lengths
+    if not isinstance(lengths, list) or not all(type(length) is int and length >= 0 for length in lengths):
+        raise InternalError('Malformed binary envelope header.')
+    return lengths
+
+
+def _mark_buffers(d, marker):
+    """
+    Returns a copy of a document with buffer references replaced by base64 encoded markers.
+    """
+
+    if isinstance(d, list):
+        return [_mark_buffers(item, marker) for item in d]
+
+    if not isinstance(d, dict):
+        return d
+
+    if d.get('encoding') == 'buffer' and isinstance(d.get('data'), int):
+        return dict(d, encoding='base64', data=marker + str(d['data']))
+
+    return {key: _mark_buffers(value, marker) for key, value in d.items()}
+
+
+def _byte_view(buffer):
+    """
+    Returns a flat, unsigned byte memoryview of a buffer without copying.
+    """
+
+    if isinstance(buffer, _np.ndarray):
+        return memoryview(buffer.reshape(-1).view(_np.uint8))
+    return memoryview(buffer).cast('B')
+
+
+def _align(offset):
+    """
+    Rounds an offset up to the next envelope alignment boundary.
+    """
+
+    return -(-offset // _BINARY_ALIGNMENT) * _BINARY_ALIGNMENT
+
+
+def _padding(offset):
+    """
+    Returns the zero padding required to align the supplied offset.
+    """
+
+    return bytes(_align(offset) - offset)
 
 
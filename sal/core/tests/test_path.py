@@ -1,6 +1,7 @@
 import unittest
 
-import jetserver.jetvfs.path as pth
+import sal.core.path as pth
+from sal.core.exception import InvalidPath
 
 VALID_SEGMENTS = [
     "abcdefghijklmnopqrstuvwxyz._-01234567890",
@@ -148,7 +149,7 @@ class TestPath(unittest.TestCase):
 
         # test invalid paths
         for path in self.invalid_paths:
-            with self.assertRaises(ValueError, msg="Invalid path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid path " + path + " did not raise an InvalidPath exception"):
                 pth.is_absolute(path)
 
         # test absolute paths
@@ -163,7 +164,7 @@ class TestPath(unittest.TestCase):
 
         # test invalid paths
         for path in self.invalid_paths:
-            with self.assertRaises(ValueError, msg="Invalid path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid path " + path + " did not raise an InvalidPath exception"):
                 pth.is_relative(path)
 
         # test relative paths
@@ -178,7 +179,7 @@ class TestPath(unittest.TestCase):
 
         # test invalid paths
         for path in self.invalid_paths:
-            with self.assertRaises(ValueError, msg="Invalid path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid path " + path + " did not raise an InvalidPath exception"):
                 pth.decompose(path)
 
         # test path decomposition, default (normalised)
@@ -197,7 +198,7 @@ class TestPath(unittest.TestCase):
 
         # test invalid paths
         for path in self.invalid_paths:
-            with self.assertRaises(ValueError, msg="Invalid path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid path " + path + " did not raise an InvalidPath exception"):
                 pth.normalise(path)
 
         # test path normalisation
@@ -208,14 +209,41 @@ class TestPath(unittest.TestCase):
 
         # test invalid base paths
         for path in self.invalid_paths + self.relative_paths:
-            with self.assertRaises(ValueError, msg="Invalid base path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid base path " + path + " did not raise an InvalidPath exception"):
                 pth.to_absolute(path, ".")
 
         # test invalid relative paths
         for path in self.invalid_paths + self.absolute_paths:
-            with self.assertRaises(ValueError, msg="Invalid relative path " + path + " did not raise a ValueError Exception"):
+            with self.assertRaises(InvalidPath, msg="Invalid relative path " + path + " did not raise an InvalidPath exception"):
                 pth.to_absolute("/", path)
 
         # test to_absolute produces valid results
         for basepath, relpath, result in self.to_absolute_paths:
             self.assertEqual(result, pth.to_absolute(basepath, relpath), "Relative path " + relpath + " incorrectly combined with base path " + basepath + ".")
+
+    def test_path(self):
+
+        # test invalid paths
+        for path in self.invalid_paths:
+            with self.assertRaises(InvalidPath, msg="Invalid path " + path + " did not raise an InvalidPath exception"):
+                pth.Path(path)
+
+        # parsed paths hold the normalised path string and decompose without parsing
+        for path, normalised in self.normalise_paths:
+            parsed = pth.Path(path)
+            self.assertEqual(normalised, parsed, "Path " + path + " incorrectly parsed.")
+            self.assertEqual(pth.decompose(path), pth.decompose(parsed), "Parsed path " + path + " incorrectly decomposed.")
+            self.assertEqual(pth.decompose(path), (list(parsed.segments), parsed.revision, parsed.absolute))
+
+        # revisions
+        parsed = pth.Path("/a/b/../c:57")
+        self.assertEqual("/a/c", parsed.at(0))
+        self.assertEqual(12, parsed.at(12).revision)
+        self.assertIs(parsed, pth.Path(parsed))
+        with self.assertRaises(InvalidPath):
+            parsed.at(-1)
+
+        # decompose returns a new segment list for each call
+        segments, _, _ = pth.decompose("/a/b")
+        segments.append("c")
+        self.assertEqual(["a", "b"], pth.decompose("/a/b")[0])
@@ -0,0 +1,124 @@
+import unittest
+import numpy as np
+from sal.core.selection import Selection
+from sal.dataclass import ArrayDimension
+
+
+class TestSelection(unittest.TestCase):
+
+    def test_init(self):
+
+        s = Selection(slices=[slice(0, 10, 2), None], ranges=[None, (0.5, 1.5)])
+        self.assertEqual(s.slices, (slice(0, 10, 2), None))
+        self.assertEqual(s.ranges, (None, (0.5, 1.5, None)))
+        self.assertTrue(s.has_ranges)
+
+        s = Selection()
+        self.assertEqual(s.slices, ())
+        self.assertEqual(s.ranges, ())
+        self.assertFalse(s.has_ranges)
+
+    def test_init_invalid(self):
+
+        # non-positive steps
+        with self.assertRaises(ValueError):
+            Selection(slices=[slice(0, 10, -1)])
+
+        with self.assertRaises(ValueError):
+            Selection(ranges=[(0.0, 1.0, 0)])
+
+        # inverted range
+        with self.assertRaises(ValueError):
+            Selection(ranges=[(1.0, 0.0)])
+
+        # slice and range on the same dimension
+        with self.assertRaises(ValueError):
+            Selection(slices=[slice(0, 10)], ranges=[(0.0, 1.0)])
+
+        # not a slice
+        with self.assertRaises(TypeError):
+            Selection(slices=[5])
+
+    def test_index(self):
+
+        s = Selection(slices=[slice(2, 5)])
+        self.assertEqual(s.index(3), (slice(2, 5), slice(None), slice(None)))
+
+        with self.assertRaises(ValueError):
+            Selection(slices=[slice(2, 5), None]).index(1)
+
+    def test_resolve(self):
+
+        # monotonic coordinates, ascending and descending
+        for data, expected in [([0.0, 1.0, 2.0, 3.0, 4.0], slice(1, 4)), ([4.0, 3.0, 2.0, 1.0, 0.0], slice(1, 4))]:
+            dimension = ArrayDimension(data=np.array(data))
+            self.assertEqual(Selection(ranges=[(1.0, 3.0)]).resolve([dimension]), (slice(1, 4, None),))
+            self.assertEqual(dimension.coordinate_slice(1.0, 3.0), expected)
+
+        # non-monotonic coordinates are accepted if the points within the range are contiguous
+        dimension = ArrayDimension(data=np.array([0.0, 5.0, 1.0, 2.0, 9.0]))
+        self.assertEqual(dimension.coordinate_slice(1.0, 2.0), slice(2, 4))
+
+        # but are rejected if the slice would include points outside the range
+        with self.assertRaises(ValueError):
+            dimension.coordinate_slice(0.0, 2.0)
+
+        with self.assertRaises(ValueError):
+            dimension.coordinate_slice(10.0, 20.0)
+
+    def test_query_round_trip(self):
+
+        s = Selection(slices=[slice(None, None, 10), slice(0, 5)])
+        query = s.to_query()
+        self.assertEqual(query, {'slice': '::10,0:5'})
+
+        d = Selection.from_query(query.get('slice'), query.get('range'))
+        self.assertEqual(d.slices, s.slices)
+        self.assertEqual(d.ranges, ())
+
+        s = Selection(ranges=[(0.1, 0.2, 4), None, (None, 3.0)])
+        query = s.to_query()
+        self.assertEqual(query, {'range': '0.1:0.2:4,,:3.0'})
+
+        d = Selection.from_query(query.get('slice'), query.get('range'))
+        self.assertEqual(d.ranges, s.ranges)
+
+    def test_bins(self):
+
+        s = Selection(bins=[1000], reduce='max')
+        self.assertTrue(s.has_bins)
+        self.assertEqual(s.bins, (1000,))
+        self.assertEqual(s.to_query(), {'bins': '1000', 'reduce': 'max'})
+
+        d = Selection.from_query(None, '0.1:0.2', ',50', 'min')
+        self.assertEqual(d.bins, (None, 50))
+        self.assertEqual(d.reduce, 'min')
+
+        # default reduction
+        self.assertEqual(Selection(bins=[10]).reduce, 'mean')
+
+        with self.assertRaises(ValueError):
+            Selection(bins=[0])
+
+        with self.assertRaises(ValueError):
+            Selection(bins=[10], reduce='median')
+
+        # reduction without bins
+        with self.assertRaises(ValueError):
+            Selection(reduce='max')
+
+    def test_query_full(self):
+
+        self.assertEqual(Selection(slices=[slice(None)]).to_query(), {})
+        self.assertEqual(Selection.from_query('', '').slices, ())
+
+    def test_query_invalid(self):
+
+        with self.assertRaises(ValueError):
+            Selection.from_query('1:2:3:4')
+
+        with self.assertRaises(ValueError):
+            Selection.from_query('a:b')
+
+        with self.assertRaises(ValueError):
+            Selection.from_query(None, '0.1:cat')
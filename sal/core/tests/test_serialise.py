@@ -0,0 +1,366 @@
+import io
+import json
+import zlib
+import unittest
+import numpy as np
+from sal.core.serialise import serialise, deserialise, encode_binary, decode_binary, iter_binary, iter_json, buffer_targets, EnvelopeReader
+from sal.core.serialise import COLUMNAR_THRESHOLD, _binary_header
+from sal.core.compression import decompress
+from sal.core.exception import InternalError
+from sal.core.object import Branch, BranchReport, TreeReport, ObjectReport
+from sal.core.time import new_timestamp
+from sal.dataclass import *
+
+
+class TestSerialise(unittest.TestCase):
+
+    def setUp(self):
+
+        self.array = Array(
+            shape=(3, 4),
+            data=np.arange(12, dtype=np.float32).reshape(3, 4),
+            dtype=np.float32,
+            description='A test array.'
+        )
+
+        self.signal = Signal(
+            dimensions=[
+                CalculatedDimension(length=5, start=0.0, step=0.1, units='s', temporal=True),
+                ArrayDimension(data=np.array([1.5, 2.5]), dtype=np.float32, units='m')
+            ],
+            data=np.arange(10, dtype=np.int16).reshape(5, 2),
+            dtype=np.int16,
+            error=AsymmetricArrayError(
+                lower=np.ones((5, 2)),
+                upper=2 * np.ones((5, 2))
+            ),
+            mask=ArrayStatus(
+                status=np.zeros((5, 2), dtype=np.uint8),
+                key=['ok', 'saturated']
+            ),
+            units='V'
+        )
+
+    def test_json_round_trip(self):
+
+        d = deserialise(serialise(self.array))
+        self.assertIsInstance(d, Array)
+        self.assertEqual(d.description, self.array.description)
+        self.assertEqual(d.data.dtype, np.float32)
+        np.testing.assert_array_equal(d.data, self.array.data)
+
+        b = deserialise(serialise(Branch('A branch.')))
+        self.assertIsInstance(b, Branch)
+        self.assertEqual(b.description, 'A branch.')
+
+    def test_tree_report(self):
+
+        timestamp = new_timestamp()
+        leaf = ObjectReport('scalar', 'core', 1)
+        tree = TreeReport(
+            BranchReport('Root.', ['a', 'b'], [], timestamp, revision_current=3, revision_latest=4),
+            {'a': TreeReport(BranchReport('Branch a.', [], [('scalar', leaf)], timestamp, revision_current=3, revision_latest=4))}
+        )
+
+        d = deserialise(json.loads(json.dumps(serialise(tree))))
+        self.assertIsInstance(d, TreeReport)
+        self.assertEqual([path for path, _ in d.walk()], ['', 'a'])
+        self.assertEqual(d.report.branches, ('a', 'b'))
+        self.assertEqual(d.report.revision_current, 3)
+        self.assertEqual(d.report.revision_latest, 4)
+
+        report = d.children['a'].report
+        self.assertEqual(report.description, 'Branch a.')
+        self.assertEqual([(name, obj.cls, obj.group, obj.version) for name, obj in report.leaves], [('scalar', 'scalar', 'core', 1)])
+
+    def test_scalar_types(self):
+
+        items = {
+            'bool': True,
+            'int': 5,
+            'float': 2.5,
+            'string': 'text',
+            'int8': np.int8(-3),
+            'uint64': np.uint64(2**63),
+            'float32': np.float32(1.5)
+        }
+
+        d = deserialise(serialise(Dictionary(items)))
+        for key, value in items.items():
+            self.assertEqual(d[key], value)
+        self.assertIsInstance(d['int'], np.int64)
+        self.assertIsInstance(d['uint64'], np.uint64)
+        self.assertIsInstance(d['float32'], np.float32)
+        self.assertIsInstance(d['string'], str)
+
+    def test_binary_round_trip(self):
+
+        buffers = []
+        document = serialise(self.signal, buffers)
+        self.assertEqual(len(buffers), 5)
+
+        document, buffers = decode_binary(encode_binary(document, buffers))
+        s = deserialise(document, buffers)
+
+        self.assertIsInstance(s, Signal)
+        self.assertEqual(s.units, 'V')
+        self.assertEqual(s.data.dtype, np.int16)
+        np.testing.assert_array_equal(s.data, self.signal.data)
+        np.testing.assert_array_equal(s.dimensions[0].data, self.signal.dimensions[0].data)
+        np.testing.assert_array_equal(s.dimensions[1].data, self.signal.dimensions[1].data)
+        np.testing.assert_array_equal(s.error.lower, self.signal.error.lower)
+        np.testing.assert_array_equal(s.error.upper, self.signal.error.upper)
+        np.testing.assert_array_equal(s.mask.status, self.signal.mask.status)
+        np.testing.assert_array_equal(s.mask.key, self.signal.mask.key)
+
+    def test_binary_adopt(self):
+
+        buffers = []
+        document = serialise(self.signal, buffers)
+        document, buffers = decode_binary(bytearray(encode_binary(document, buffers)))
+        views = [np.frombuffer(buffer, dtype=np.uint8) for buffer in buffers]
+
+        # by default the arrays are copied out of the buffers
+        s = deserialise(document, buffers)
+        for array in (s.data, s.dimensions[1].data, s.error.lower, s.error.upper, s.mask.status):
+            self.assertFalse(any(np.shares_memory(array, view) for view in views))
+
+        # adopted buffers are used without copying
+        s = deserialise(document, buffers, adopt=True)
+        for array in (s.data, s.dimensions[1].data, s.error.lower, s.error.upper, s.mask.status):
+            self.assertTrue(any(np.shares_memory(array, view) for view in views))
+
+        # from_dict() outside of deserialise() copies the supplied arrays
+        d = s.to_dict()
+        self.assertFalse(np.shares_memory(Signal.from_dict(d).data, s.data))
+
+    def test_binary_alignment(self):
+
+        buffers = []
+        document = serialise(self.signal, buffers)
+        envelope = encode_binary(document, buffers)
+
+        _, buffers = decode_binary(envelope)
+        base = np.frombuffer(envelope, dtype=np.uint8).ctypes.data
+        for buffer in buffers:
+            offset = np.frombuffer(buffer, dtype=np.uint8).ctypes.data - base
+            self.assertEqual(offset % 64, 0)
+
+    def test_binary_chunked(self):
+
+        buffers = []
+        document = serialise(self.signal, buffers)
+        envelope = encode_binary(document, buffers)
+        self.assertEqual(b''.join(bytes(chunk) for chunk in iter_binary(document, buffers, chunk_size=7)), envelope)
+
+    def test_binary_stream(self):
+
+        buffers = []
+        document = serialise(self.signal, buffers)
+        envelope = encode_binary(document, buffers)
+
+        # read all buffers
+        reader = EnvelopeReader(io.BytesIO(envelope))
+        s = deserialise(reader.document, reader.read_buffers())
+        self.assertIsInstance(s, Signal)
+        np.testing.assert_array_equal(s.data, self.signal.data)
+        np.testing.assert_array_equal(s.error.upper, self.signal.error.upper)
+
+        # read buffers in chunks, skipping the second buffer
+        reader = EnvelopeReader(io.BytesIO(envelope))
+        received = []
+        for buffer in reader.buffers():
+            if buffer.index == 1:
+                continue
+            received.append(b''.join(buffer.chunks(size=3)))
+
+        self.assertEqual(len(received), len(buffers) - 1)
+        self.assertEqual(received[0], buffers[0].tobytes())
+        self.assertEqual(received[-1], buffers[-1].tobytes())
+
+        # regenerate the envelope
+        reader = EnvelopeReader(io.BytesIO(envelope))
+        self.assertEqual(b''.join(bytes(chunk) for chunk in reader.chunks(size=5)), envelope)
+
+        # truncated
+        reader = EnvelopeReader(io.BytesIO(envelope[:-32]))
+        with self.assertRaises(InternalError):
+            reader.read_buffers()
+
+    def test_buffer_targets(self):
+
+        buffers = []
+        envelope = encode_binary(serialise(self.signal, buffers), buffers)
+
+        target = Signal(
+            dimensions=[
+                CalculatedDimension(length=5, start=1.0, step=0.2, units='s', temporal=True),
+                ArrayDimension(data=np.zeros(2, dtype=np.float32), dtype=np.float32, units='m')
+            ],
+            data=np.zeros((5, 2), dtype=np.int16),
+            dtype=np.int16,
+            error=AsymmetricArrayError(lower=np.zeros((5, 2)), upper=np.zeros((5, 2))),
+            mask=ArrayStatus(status=np.zeros((5, 2), dtype=np.uint8), key=['ok']),
+        )
+
+        # the buffers are read into the target arrays, the decoded object adopts the arrays
+        reader = EnvelopeReader(io.BytesIO(envelope))
+        targets = buffer_targets(reader.document, reader.lengths, target)
+        self.assertEqual(sum(array is not None for array in targets), len(buffers))
+
+        s = deserialise(reader.document, reader.read_buffers(targets), adopt=True)
+        self.assertIs(s.data, target.data)
+        self.assertIs(s.dimensions[1].data, target.dimensions[1].data)
+        self.assertIs(s.error.lower, target.error.lower)
+        self.assertIs(s.error.upper, target.error.upper)
+        self.assertIs(s.mask.status, target.mask.status)
+
+        np.testing.assert_array_equal(target.data, self.signal.data)
+        np.testing.assert_array_equal(target.error.upper, self.signal.error.upper)
+        np.testing.assert_array_equal(s.dimensions[0].data, self.signal.dimensions[0].data)
+        np.testing.assert_array_equal(s.mask.key, self.signal.mask.key)
+
+        # arrays of a different dtype or shape are not reused
+        buffers = []
+        envelope = encode_binary(serialise(self.array, buffers), buffers)
+        for other in [Array(shape=(3, 4), dtype=np.float64), Array(shape=(4, 3), dtype=np.float32)]:
+            reader = EnvelopeReader(io.BytesIO(envelope))
+            self.assertEqual(buffer_targets(reader.document, reader.lengths, other), [None])
+
+    def test_json_stream(self):
+
+        # the streamed text is identical to the text of a document without buffers
+        expected = json.dumps(serialise(self.signal)).encode('utf-8')
+        buffers = []
+        document = serialise(self.signal, buffers)
+        self.assertEqual(b''.join(iter_json(document, buffers, chunk_size=16)), expected)
+
+        s = deserialise(json.loads(b''.join(iter_json(document, buffers)).decode('utf-8')))
+        np.testing.assert_array_equal(s.data, self.signal.data)
+
+        # documents without buffers
+        self.assertEqual(b''.join(iter_json(serialise(Branch('A branch.')))), json.dumps(serialise(Branch('A branch.'))).encode('utf-8'))
+
+    def test_deferred(self):
+
+        # only arrays at or above the threshold are deferred
+        a = Array(shape=(1000,), data=np.arange(1000, dtype=np.float64), dtype=np.float64)
+        document = serialise(a, defer=1024)
+        self.assertEqual(document['object']['data']['value']['encoding'], 'deferred')
+        self.assertEqual(document['object']['data']['value']['data'], 'data')
+
+        deferred = {}
+        s = deserialise(document, deferred=deferred)
+        self.assertIsInstance(s, Array)
+        self.assertEqual(list(deferred.keys()), ['data'])
+        self.assertIs(deferred['data'], s.data)
+        self.assertEqual(s.data.shape, (1000,))
+
+        # deferred arrays cannot be decoded without a placeholder dictionary
+        with self.assertRaises(InternalError):
+            deserialise(document)
+
+        # arrays below the threshold are encoded in place
+        document = serialise(a, defer=1024 * 1024)
+        self.assertEqual(document['object']['data']['value']['encoding'], 'base64')
+
+    def test_compression(self):
+
+        # slowly varying data larger than the compression threshold
+        a = Array(shape=(2, 40000), data=np.cumsum(np.ones((2, 40000), dtype=np.int16), axis=1), dtype=np.int16)
+
+        for scheme in ('zlib', 'zlib-shuffle'):
+
+            document = serialise(a, compression=scheme)
+            data = document['object']['data']['value']
+            self.assertEqual(data['compression'], scheme)
+            self.assertLess(len(data['data']), a.data.nbytes)
+
+            d = deserialise(document)
+            self.assertEqual(d.data.dtype, np.int16)
+            np.testing.assert_array_equal(d.data, a.data)
+
+            buffers = []
+            document, buffers = decode_binary(encode_binary(serialise(a, buffers, scheme), buffers))
+            np.testing.assert_array_equal(deserialise(document, buffers).data, a.data)
+
+        # small arrays are not compressed
+        document = serialise(self.array, compression='zlib')
+        self.assertNotIn('compression', document['object']['data']['value'])
+
+        # blocks that inflate beyond the array size are rejected without decompressing them in full
+        block = zlib.compress(bytes(64 * 1024 * 1024), 9)
+        with self.assertRaises(InternalError):
+            decompress(block, [len(block)], 'zlib', np.float64, (10,))
+
+        # truncated blocks are rejected
+        block = zlib.compress(bytes(80), 9)
+        with self.assertRaises(InternalError):
+            decompress(block[:-4], [len(block) - 4], 'zlib', np.float64, (10,))
+
+    def test_columnar(self):
+
+        items = {}
+        for index in range(COLUMNAR_THRESHOLD):
+            items['float.{}'.format(index)] = float(index) / 3
+            items['int.{}'.format(index)] = np.int32(index)
+        items['enabled'] = True
+        items['name'] = 'parameters'
+        dictionary = Dictionary(items)
+
+        # large scalar dictionaries are encoded as one column per type
+        document = serialise(dictionary, columnar=True)
+        encoded = document['object']['items']
+        self.assertEqual(encoded['type'], 'columns')
+        self.assertEqual([column['type'] for column in encoded['value']['columns']], ['float64', 'int32', 'bool', 'string'])
+        self.assertEqual(encoded['value']['columns'][0]['values']['encoding'], 'base64')
+
+        # decoded values match the per-value encoding in type, value and order
+        reference = deserialise(serialise(dictionary))
+        buffers = []
+        document = serialise(dictionary, buffers, columnar=True)
+        document, buffers = decode_binary(encode_binary(document, buffers))
+        for decoded in (deserialise(document, buffers), deserialise(json.loads(json.dumps(serialise(dictionary, columnar=True))))):
+            self.assertEqual(list(decoded.keys()), list(reference.keys()))
+            for key in reference.keys():
+                self.assertEqual(decoded[key], reference[key])
+                self.assertIs(type(decoded[key]), type(reference[key]))
+
+        # small dictionaries and the default encoding are unchanged
+        self.assertEqual(serialise(dictionary)['object']['items']['type'], 'branch')
+        self.assertEqual(serialise(Dictionary({'a': 1.0}), columnar=True)['object']['items']['type'], 'branch')
+
+        # malformed columns are rejected
+        document = serialise(dictionary, columnar=True)
+        document['object']['items']['value']['keys'].pop()
+        with self.assertRaises(InternalError):
+            deserialise(document)
+
+    def test_binary_invalid(self):
+
+        buffers = []
+        envelope = encode_binary(serialise(self.array, buffers), buffers)
+
+        # bad magic
+        with self.assertRaises(InternalError):
+            decode_binary(b'XXXX' + envelope[4:])
+
+        # truncated
+        with self.assertRaises(InternalError):
+            decode_binary(envelope[:-32])
+
+        with self.assertRaises(InternalError):
+            decode_binary(envelope[:8])
+
+        # missing buffers
+        with self.assertRaises(InternalError):
+            deserialise(serialise(self.array, []))
+
+        # buffer lengths must be non-negative integers
+        document = serialise(self.array, [])
+        for lengths in [[-1], ['48'], [1.5], [True], [None]]:
+            envelope = _binary_header(document, lengths) + bytes(64)
+            with self.assertRaises(InternalError):
+                decode_binary(envelope)
+            with self.assertRaises(InternalError):
+                EnvelopeReader(io.BytesIO(envelope))
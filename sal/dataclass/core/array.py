@@ -1,6 +1,7 @@
 import numpy as np
 
 from sal.core.object import DataObject, DataSummary, dataclass
+from sal.core.object.dataclass import _copy_arrays
 
 
 class ArraySummary(DataSummary):
@@ -65,7 +66,7 @@ class Array(DataObject):
     VERSION = 1
     SUMMARY_CLASS = ArraySummary
 
-    def __init__(self, shape, data=None, dtype=None, description=None):
+    def __init__(self, shape, data=None, dtype=None, description=None, copy=True):
         """
         The data array shape is is a tuple defining the length of each
         dimension. For example:
@@ -100,10 +101,15 @@ class Array(DataObject):
         The description is a python string and therefore supports UTF8
         characters.
 
+        By default the supplied data is copied. If copy is False, data that is
+        already of the required data type and C-ordered is used directly
+        without copying, the array then shares memory with the caller.
+
         :param shape: A tuple defining the dimensions of the array.
         :param data: Initial data to populate the data array with (default=None).
         :param dtype: The data type for the data array (default=np.float64).
         :param description: A string describing the array (default='An array.').
+        :param copy: Copy the supplied data (default=True).
         """
 
         supported_types = {
@@ -131,7 +137,7 @@ class Array(DataObject):
         # validate data or initialise an empty data array
         if data is not None:
 
-            data = np.array(data)
+            data = np.asarray(data)
 
             # check dimensions
             if data.shape != shape:
@@ -142,6 +148,8 @@ class Array(DataObject):
             # convert data if required
             if dtype != data.dtype.type or not data.flags.c_contiguous:
                 data = data.astype(dtype, order='C')
+            elif copy:
+                data = data.copy()
 
             self.data = data
         else:
@@ -162,6 +170,34 @@ class Array(DataObject):
 
         return self.SUMMARY_CLASS(self.shape, self.description)
 
+    def select(self, selection):
+        """
+        Returns a new Array containing a subset of the data array.
+
+        Arrays do not have coordinates, only index slices are supported.
+        Binning is not supported.
+
+        :param selection: A Selection object.
+        :return: An Array object.
+        """
+
+        if selection.has_ranges:
+            raise ValueError('Array does not support coordinate ranges, use index slices.')
+
+        if selection.has_bins:
+            raise ValueError('Array does not support binning, use a Signal.')
+
+        data = self.data[selection.index(self.data.ndim)]
+        if not data.size:
+            raise ValueError('The selection does not contain any data.')
+
+        return Array(
+            shape=data.shape,
+            data=data,
+            dtype=self.data.dtype.type,
+            description=self.description
+        )
+
     def to_dict(self):
         """
         Returns a dictionary representation of the object.
@@ -196,5 +232,6 @@ class Array(DataObject):
             description=d['description'],
             shape=data.shape,
             data=data,
-            dtype=data.dtype.type
+            dtype=data.dtype.type,
+            copy=_copy_arrays()
         )
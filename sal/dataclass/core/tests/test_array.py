@@ -64,6 +64,23 @@ class TestArray(unittest.TestCase):
         with self.assertRaises(ValueError):
             Array(shape=(10,), data=self.data)
 
+    def test_init_copy(self):
+
+        a = np.array(self.data, dtype=np.float32)
+
+        # data is copied by default
+        d = Array(shape=(3, 4), data=a, dtype=np.float32)
+        self.assertFalse(np.shares_memory(d.data, a))
+
+        # compatible data is adopted without a copy
+        d = Array(shape=(3, 4), data=a, dtype=np.float32, copy=False)
+        self.assertTrue(np.shares_memory(d.data, a))
+
+        # incompatible data is still converted
+        d = Array(shape=(3, 4), data=a, dtype=np.float64, copy=False)
+        self.assertFalse(np.shares_memory(d.data, a))
+        self.assertEqual(d.data.dtype, np.float64)
+
     def test_shape(self):
 
         shapes = (
@@ -1,6 +1,8 @@
 import numpy as np
+from sal.core.object.dataclass import _copy_arrays
 from .base import Dimension, DimensionSummary
 from .. import subobject
+from ..reduction import reduce_bins
 
 # TODO: add tests
 
@@ -24,7 +26,7 @@ class ArrayDimension(Dimension):
     VERSION = 1
     SUMMARY_CLASS = ArrayDimensionSummary
 
-    def __init__(self, data, dtype=None, units=None, error=None, temporal=False, description=None):
+    def __init__(self, data, dtype=None, units=None, error=None, temporal=False, description=None, copy=True):
         """
         An array dimension is defined by a 1 dimensional array containing the 
         axis values for each point along the dimension. The array length
@@ -47,6 +49,7 @@ class ArrayDimension(Dimension):
         :param error: An Error object or None (default=None).
         :param temporal: True is the dimension represent time, False otherwise (default=False).
         :param description: A string describing the signal (default='A signal.').
+        :param copy: Copy the supplied data, see Array (default=True).
         """
 
         supported_types = {
@@ -58,7 +61,7 @@ class ArrayDimension(Dimension):
         description = description or 'An array dimension.'
 
         # validate data
-        data = np.array(data)
+        data = np.asarray(data)
         if data.ndim != 1:
             raise ValueError('The data array must be 1D.')
 
@@ -76,6 +79,8 @@ class ArrayDimension(Dimension):
         # ensure array datatype is correct
         if dtype != data.dtype.type or not data.flags.c_contiguous:
             data = data.astype(dtype, order='C')
+        elif copy:
+            data = data.copy()
 
         self.data = data
         super().__init__(len(data), units, error, temporal, description)
@@ -95,6 +100,39 @@ class ArrayDimension(Dimension):
             description=self.description
         )
 
+    def select(self, s):
+
+        # select error points?
+        error = self.error
+        if error:
+            error = error.select((s, ))
+
+        return ArrayDimension(
+            data=self.data[s],
+            dtype=self.data.dtype.type,
+            units=self.units,
+            error=error,
+            temporal=self.temporal,
+            description=self.description
+        )
+
+    def bin(self, starts):
+
+        # bin error points?
+        error = self.error
+        if error:
+            error = error.bin((starts, ))
+
+        data = reduce_bins(self.data, (starts, ), 'mean')
+        return ArrayDimension(
+            data=data,
+            dtype=data.dtype.type,
+            units=self.units,
+            error=error,
+            temporal=self.temporal,
+            description=self.description
+        )
+
     def to_dict(self):
 
         v = self._new_dict()
@@ -118,7 +156,8 @@ class ArrayDimension(Dimension):
             description=d['description'],
             units=d['units'],
             error=error,
-            temporal=d['temporal']
+            temporal=d['temporal'],
+            copy=_copy_arrays()
         )
 
         return c
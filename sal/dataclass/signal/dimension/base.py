@@ -86,6 +86,60 @@ class Dimension(DataObject):
     def __len__(self):
         return self.length
 
+    def select(self, s):
+        """
+        Returns a new dimension containing a subset of the dimension points.
+
+        :param s: A slice object.
+        :return: A Dimension object.
+        """
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
+    def bin(self, starts):
+        """
+        Returns a new dimension for binned data.
+
+        The coordinate of each bin is the mean of the coordinates of the
+        points in the bin. Errors report the largest error in each bin.
+
+        :param starts: An array of the index of the first point in each bin.
+        :return: A Dimension object.
+        """
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
+    def coordinate_slice(self, lower=None, upper=None):
+        """
+        Returns the index slice containing the coordinates in the range [lower, upper].
+
+        The slice spans all the points lying within the range. Either limit may
+        be None, in which case the range is unbounded at that end.
+
+        The points within the range must be contiguous, which is always the
+        case for monotonic coordinates. A range that selects a non-contiguous
+        set of points of a non-monotonic dimension cannot be expressed as a
+        slice and is rejected.
+
+        :param lower: The lower coordinate limit (default=None).
+        :param upper: The upper coordinate limit (default=None).
+        :return: A slice object.
+        :raises ValueError: If no coordinates lie within the range or the coordinates within the range are not contiguous.
+        """
+
+        inside = np.ones(self.length, dtype=bool)
+        if lower is not None:
+            inside &= self.data >= lower
+        if upper is not None:
+            inside &= self.data <= upper
+
+        indices = np.flatnonzero(inside)
+        if not indices.size:
+            raise ValueError('No dimension coordinates lie within the range [{}, {}].'.format(lower, upper))
+
+        # the slice must not include points outside the range
+        if indices.size != indices[-1] - indices[0] + 1:
+            raise ValueError('The dimension coordinates within the range [{}, {}] are not contiguous, the dimension is not monotonic.'.format(lower, upper))
+        return slice(int(indices[0]), int(indices[-1]) + 1)
+
     def _new_dict(self):
 
         v = super()._new_dict()
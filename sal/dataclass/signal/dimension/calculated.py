@@ -83,6 +83,69 @@ class CalculatedDimension(Dimension):
             description=self.description
         )
 
+    def select(self, s):
+
+        start, stop, step = s.indices(self.length)
+
+        # select error points?
+        error = self.error
+        if error:
+            error = error.select((s, ))
+
+        return CalculatedDimension(
+            length=len(range(start, stop, step)),
+            start=self.start + self.step * start,
+            step=self.step * step,
+            units=self.units,
+            error=error,
+            temporal=self.temporal,
+            description=self.description
+        )
+
+    def bin(self, starts):
+
+        # bin error points?
+        error = self.error
+        if error:
+            error = error.bin((starts, ))
+
+        # bins are regularly spaced, the coordinate is the centre of each bin window
+        width = int(starts[1] - starts[0]) if len(starts) > 1 else self.length
+        return CalculatedDimension(
+            length=len(starts),
+            start=self.start + 0.5 * self.step * (width - 1),
+            step=self.step * width,
+            units=self.units,
+            error=error,
+            temporal=self.temporal,
+            description=self.description
+        )
+
+    def coordinate_slice(self, lower=None, upper=None):
+
+        # the coordinates are regularly spaced so the indices can be calculated directly
+        if self.step == 0:
+            return super().coordinate_slice(lower, upper)
+
+        # fractional index of each limit, a small tolerance absorbs floating point rounding
+        tolerance = 1e-9
+        first = 0
+        last = self.length - 1
+
+        lower_index = None if lower is None else (lower - self.start) / self.step
+        upper_index = None if upper is None else (upper - self.start) / self.step
+        if self.step < 0:
+            lower_index, upper_index = upper_index, lower_index
+
+        if lower_index is not None:
+            first = max(first, int(np.ceil(lower_index - tolerance)))
+        if upper_index is not None:
+            last = min(last, int(np.floor(upper_index + tolerance)))
+
+        if first > last:
+            raise ValueError('No dimension coordinates lie within the range [{}, {}].'.format(lower, upper))
+        return slice(first, last + 1)
+
     def to_dict(self):
 
         v = self._new_dict()
@@ -1,6 +1,8 @@
 import numpy as np
+from sal.core.object.dataclass import _copy_arrays
 from .base import Error, ErrorSummary
 from .. import subobject
+from ..reduction import reduce_bins, ERROR_REDUCTION
 
 # TODO: add tests
 
@@ -28,7 +30,7 @@ class AsymmetricArrayError(Error):
     VERSION = 1
     SUMMARY_CLASS = AsymmetricArrayErrorSummary
 
-    def __init__(self, lower, upper, dtype=None, description=None):
+    def __init__(self, lower, upper, dtype=None, description=None, copy=True):
         """
         The dimensions of the error are defined by the shape of the data
         supplied. The shape must match the shape of the object to which
@@ -45,6 +47,7 @@ class AsymmetricArrayError(Error):
         :param upper: Array holding the upper error values.
         :param dtype: The data type for the data array (default=np.float64).
         :param description: A text description of the error. 
+        :param copy: Copy the supplied arrays, see Array (default=True).
         """
 
         supported_types = {
@@ -56,8 +59,8 @@ class AsymmetricArrayError(Error):
         description = description or 'Asymmetrical error per point.'
 
         # explicitly convert data to a numpy array, lets us use numpy to handle lists etc...
-        lower = np.array(lower)
-        upper = np.array(upper)
+        lower = np.asarray(lower)
+        upper = np.asarray(upper)
 
         # validate error shapes
         if lower.shape != upper.shape:
@@ -77,9 +80,13 @@ class AsymmetricArrayError(Error):
         # ensure array data type is correct
         if dtype != lower.dtype.type or not lower.flags.c_contiguous:
             lower = lower.astype(dtype, order='C')
+        elif copy:
+            lower = lower.copy()
 
         if dtype != upper.dtype.type or not upper.flags.c_contiguous:
             upper = upper.astype(dtype, order='C')
+        elif copy:
+            upper = upper.copy()
 
         self.lower = lower
         self.upper = upper
@@ -89,6 +96,17 @@ class AsymmetricArrayError(Error):
     def shape_compatible(self, shape):
         return shape == self.lower.shape and shape == self.upper.shape
 
+    def select(self, slices):
+        return AsymmetricArrayError(self.lower[slices], self.upper[slices], self.lower.dtype.type, self.description)
+
+    def bin(self, edges):
+        return AsymmetricArrayError(
+            reduce_bins(self.lower, edges, ERROR_REDUCTION),
+            reduce_bins(self.upper, edges, ERROR_REDUCTION),
+            self.lower.dtype.type,
+            self.description
+        )
+
     def summary(self):
         return self.SUMMARY_CLASS(self.description)
 
@@ -109,13 +127,14 @@ class AsymmetricArrayError(Error):
             raise ValueError('The dictionary does not contain a serialised asymmetrical array error class.')
 
         if d['lower'].dtype != d['upper'].dtype:
-            raise ValueError('Cannot deserialise, lower and upper data types are inconsistent (lower: {}, upper: {})'.format(d['lower'].dtype), dtype=d['upper'].dtype)
+            raise ValueError('Cannot deserialise, lower and upper data types are inconsistent (lower: {}, upper: {})'.format(d['lower'].dtype, d['upper'].dtype))
 
         c = cls(
             lower=d['lower'],
             upper=d['upper'],
             dtype=d['lower'].dtype.type,
-            description=d['description']
+            description=d['description'],
+            copy=_copy_arrays()
         )
 
         return c
@@ -21,6 +21,27 @@ class Error(DataObject):
         """
         raise NotImplementedError('This method must be implemented by sub-classes.')
 
+    def select(self, slices):
+        """
+        Returns a new error object for a subset of the data points.
+
+        :param slices: A tuple of slice objects, one per data dimension.
+        :return: An Error object.
+        """
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
+    def bin(self, edges):
+        """
+        Returns a new error object for binned data.
+
+        As error values are magnitudes, the largest error in each bin is
+        reported to give a conservative uncertainty for every reduction.
+
+        :param edges: A tuple of bin start indices or None, one per data dimension.
+        :return: An Error object.
+        """
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
 
 class ErrorSummary(DataSummary):
     """
@@ -74,6 +74,12 @@ class ConstantError(Error):
     def shape_compatible(self, shape):
         return True
 
+    def select(self, slices):
+        return ConstantError(self._lower, self._upper, self.relative, self.description)
+
+    def bin(self, edges):
+        return ConstantError(self._lower, self._upper, self.relative, self.description)
+
     def summary(self):
         return self.SUMMARY_CLASS(self.description)
 
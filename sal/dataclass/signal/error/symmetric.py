@@ -1,6 +1,8 @@
 import numpy as np
+from sal.core.object.dataclass import _copy_arrays
 from .base import Error, ErrorSummary
 from .. import subobject
+from ..reduction import reduce_bins, ERROR_REDUCTION
 
 # TODO: add tests
 
@@ -28,7 +30,7 @@ class SymmetricArrayError(Error):
     VERSION = 1
     SUMMARY_CLASS = SymmetricArrayErrorSummary
 
-    def __init__(self, data, dtype=None, description=None):
+    def __init__(self, data, dtype=None, description=None, copy=True):
         """
         The dimensions of the error are defined by the shape of the data
         supplied. The shape must match the shape of the object to which
@@ -43,6 +45,7 @@ class SymmetricArrayError(Error):
         :param data: Array holding the error values.
         :param dtype: The data type for the data array (default=np.float64).
         :param description: A text description of the error. 
+        :param copy: Copy the supplied data, see Array (default=True).
         """
 
         supported_types = {
@@ -54,7 +57,7 @@ class SymmetricArrayError(Error):
         description = description or 'Symmetrical error per point.'
 
         # explicitly convert data to a numpy array, lets us use numpy to handle lists etc...
-        data = np.array(data)
+        data = np.asarray(data)
 
         # validate data type
         if dtype:
@@ -69,6 +72,8 @@ class SymmetricArrayError(Error):
         # ensure array data type/order is correct
         if dtype != data.dtype.type or not data.flags.c_contiguous:
             data = data.astype(dtype, order='C')
+        elif copy:
+            data = data.copy()
 
         self.data = data
 
@@ -77,6 +82,12 @@ class SymmetricArrayError(Error):
     def shape_compatible(self, shape):
         return shape == self.data.shape
 
+    def select(self, slices):
+        return SymmetricArrayError(self.data[slices], self.data.dtype.type, self.description)
+
+    def bin(self, edges):
+        return SymmetricArrayError(reduce_bins(self.data, edges, ERROR_REDUCTION), self.data.dtype.type, self.description)
+
     def summary(self):
         return self.SUMMARY_CLASS(self.description)
 
@@ -93,7 +104,8 @@ class SymmetricArrayError(Error):
         c = cls(
             data=d['data'],
             dtype=d['data'].dtype.type,
-            description=d['description']
+            description=d['description'],
+            copy=_copy_arrays()
         )
 
         return c
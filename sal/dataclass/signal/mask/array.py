@@ -1,6 +1,8 @@
 import numpy as np
+from sal.core.object.dataclass import _copy_arrays
 from .base import Mask, MaskSummary
 from .. import subobject
+from ..reduction import reduce_bins, STATUS_REDUCTION
 
 
 # TODO: add docstrings
@@ -20,15 +22,16 @@ class ArrayStatus(Mask):
     VERSION = 1
     SUMMARY_CLASS = ArrayStatusSummary
 
-    def __init__(self, status, key, description=None):
+    def __init__(self, status, key, description=None, copy=True):
 
         description = description or 'Array status mask.'
 
         # explicitly convert data to a numpy array, lets us use numpy to handle lists etc...
-        status = np.array(status, dtype=np.uint8, order='C')
+        # if copy is False, a C-ordered uint8 array is used without copying
+        status = np.array(status, dtype=np.uint8, order='C') if copy else np.asarray(status, dtype=np.uint8, order='C')
 
-        # validate status
-        if (status >= len(key)).any():
+        # validate status, max() avoids allocating a temporary array
+        if status.size and status.max() >= len(key):
             raise ValueError('Status array contains status values that lie outside the range of listed keys (valid range=[0, {}]).'.format(len(key) - 1))
 
         self.status = status
@@ -39,6 +42,14 @@ class ArrayStatus(Mask):
     def shape_compatible(self, shape):
         return shape == self.status.shape
 
+    def select(self, slices):
+        return ArrayStatus(self.status[slices], self.key, self.description)
+
+    def bin(self, edges):
+
+        # each bin reports the highest status value present, keys should be ordered by severity
+        return ArrayStatus(reduce_bins(self.status, edges, STATUS_REDUCTION), self.key, self.description)
+
     def summary(self):
         return self.SUMMARY_CLASS(self.description)
 
@@ -56,7 +67,8 @@ class ArrayStatus(Mask):
         c = cls(
             status=d['status'],
             key=d['key'],
-            description=d['description']
+            description=d['description'],
+            copy=_copy_arrays()
         )
 
         return c
@@ -10,6 +10,12 @@ class Mask(DataObject):
     def shape_compatible(self, shape):
         raise NotImplementedError('This method must be implemented by sub-classes.')
 
+    def select(self, slices):
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
+    def bin(self, edges):
+        raise NotImplementedError('This method must be implemented by sub-classes.')
+
 
 # TODO: add tests
 # TODO: add docstrings
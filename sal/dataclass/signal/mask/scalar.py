@@ -35,6 +35,12 @@ class ScalarStatus(Mask):
     def shape_compatible(self, shape):
         return True
 
+    def select(self, slices):
+        return ScalarStatus(self.status, self.key, self.description)
+
+    def bin(self, edges):
+        return ScalarStatus(self.status, self.key, self.description)
+
     def summary(self):
         return self.SUMMARY_CLASS(self.description)
 
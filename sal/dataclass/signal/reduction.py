@@ -0,0 +1,88 @@
+"""
+Vectorised binning kernels used to decimate signals.
+
+A dimension of length n is divided into bins of equal width w = ceil(n / bins)
+starting at index 0, the final bin holds the remaining n - w * (k - 1) points.
+The reductions are performed with numpy ufunc.reduceat() so the cost is a
+single pass over the data, independent of the number of bins.
+"""
+
+import numpy as np
+
+# reductions applied to error magnitudes and status masks when binning
+ERROR_REDUCTION = 'max'
+STATUS_REDUCTION = 'max'
+
+
+def bin_width(length, bins):
+    """
+    Returns the number of points in each bin.
+
+    :param length: The length of the dimension.
+    :param bins: The maximum number of bins or None.
+    :return: The bin width or None if the dimension is not binned.
+    """
+
+    if bins is None or bins >= length:
+        return None
+    return -(-length // bins)
+
+
+def bin_edges(shape, bins):
+    """
+    Returns the index of the first point of each bin, per dimension.
+
+    :param shape: The data array shape.
+    :param bins: A sequence of bin counts or None, one per dimension.
+    :return: A tuple of index arrays or None, one per dimension.
+    """
+
+    bins = tuple(bins) + (None,) * (len(shape) - len(bins))
+
+    edges = []
+    for length, b in zip(shape, bins):
+        width = bin_width(length, b)
+        edges.append(None if width is None else np.arange(0, length, width))
+    return tuple(edges)
+
+
+def reduce_bins(data, edges, method):
+    """
+    Reduces the points in each bin of an array.
+
+    The mean of integer data is returned as float64, the mean of floating
+    point data and minimum and maximum reductions preserve the data type.
+
+    :param data: A numpy array.
+    :param edges: A tuple of bin start indices or None, one per axis (see bin_edges()).
+    :param method: The reduction, 'mean', 'min' or 'max'.
+    :return: The reduced array.
+    """
+
+    dtype = data.dtype
+    for axis, starts in enumerate(edges):
+
+        if starts is None:
+            continue
+
+        if method == 'min':
+            data = np.minimum.reduceat(data, starts, axis=axis)
+
+        elif method == 'max':
+            data = np.maximum.reduceat(data, starts, axis=axis)
+
+        elif method == 'mean':
+
+            # accumulate in float64 to avoid integer overflow and precision loss
+            sums = np.add.reduceat(data, starts, axis=axis, dtype=np.float64)
+            counts = np.diff(np.append(starts, data.shape[axis]))
+            shape = [1] * data.ndim
+            shape[axis] = counts.size
+            data = sums / counts.reshape(shape)
+            if np.issubdtype(dtype, np.floating):
+                data = data.astype(dtype, copy=False)
+
+        else:
+            raise ValueError('Unsupported reduction \'{}\'.'.format(method))
+
+    return np.ascontiguousarray(data)
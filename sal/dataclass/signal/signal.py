@@ -1,9 +1,11 @@
 import numpy as np
 
 from sal.core.object import DataObject, DataSummary, dataclass
+from sal.core.object.dataclass import _copy_arrays
 from .dimension import Dimension, DimensionSummary
 from .error import Error, ErrorSummary
 from .mask import Mask, MaskSummary
+from .reduction import bin_edges, reduce_bins
 from . import subobject
 
 # TODO: add tests
@@ -181,7 +183,7 @@ class Signal(DataObject):
     VERSION = 1
     SUMMARY_CLASS = SignalSummary
 
-    def __init__(self, dimensions, data=None, dtype=None, error=None, mask=None, units=None, description=None):
+    def __init__(self, dimensions, data=None, dtype=None, error=None, mask=None, units=None, description=None, copy=True):
         """
         The minimal requirements to create a signal object is a list of
         Dimension objects. This will create an Signal object with an empty
@@ -296,6 +298,7 @@ class Signal(DataObject):
         :param mask: A Mask object or None (default=None)
         :param units: A string describing the data units (default='au'). 
         :param description: A string describing the signal (default='A signal.').
+        :param copy: Copy the supplied data, see Array (default=True).
         """
 
         supported_types = {
@@ -348,7 +351,7 @@ class Signal(DataObject):
         # validate data or initialise an empty data array
         if data is not None:
 
-            data = np.array(data)
+            data = np.asarray(data)
 
             # check dimensions
             if data.shape != shape:
@@ -357,6 +360,8 @@ class Signal(DataObject):
             # convert data if required
             if dtype != data.dtype.type or not data.flags.c_contiguous:
                 data = data.astype(dtype, order='C')
+            elif copy:
+                data = data.copy()
 
             self.data = data
         else:
@@ -421,6 +426,65 @@ class Signal(DataObject):
             description=self.description
         )
 
+    def select(self, selection):
+        """
+        Returns a new Signal containing a subset of the signal.
+
+        Each dimension may be selected with an index slice or a coordinate
+        range. The dimensions, errors and mask are reduced to match the
+        selected data.
+
+        If the selection requests bins, the selected data is divided into at
+        most the requested number of equal width bins per dimension and the
+        points in each bin are combined with the requested reduction (mean,
+        min or max). The errors and mask are binned with the data, each bin
+        reporting the largest error magnitude and highest status value in the
+        bin. Calculated dimensions remain calculated dimensions, with the
+        coordinate of each bin at the centre of the bin window. The mean of
+        integer data is returned as float64 data, floating point data keeps
+        its data type.
+
+        :param selection: A Selection object.
+        :return: A Signal object.
+        """
+
+        slices = selection.resolve(self.dimensions)
+
+        dimensions = [dimension.select(s) for dimension, s in zip(self.dimensions, slices)]
+
+        error = self.error
+        if error:
+            error = error.select(slices)
+
+        mask = self.mask
+        if mask:
+            mask = mask.select(slices)
+
+        data = self.data[slices]
+
+        if selection.has_bins:
+
+            edges = bin_edges(data.shape, selection.bins)
+            data = reduce_bins(data, edges, selection.reduce)
+
+            dimensions = [dimension.bin(starts) if starts is not None else dimension for dimension, starts in zip(dimensions, edges)]
+
+            if error:
+                error = error.bin(edges)
+
+            if mask:
+                mask = mask.bin(edges)
+
+        return Signal(
+            dimensions=dimensions,
+            data=data,
+            dtype=data.dtype.type,
+            error=error,
+            mask=mask,
+            units=self.units,
+            description=self.description
+        )
+
     def to_dict(self):
         """
         Returns a dictionary representation of the object.
@@ -494,7 +558,8 @@ class Signal(DataObject):
             data=d['data'],
             dtype=d['data'].dtype.type,
             error=error,
-            mask=mask
+            mask=mask,
+            copy=_copy_arrays()
         )
 
         return c
@@ -0,0 +1,54 @@
+import unittest
+import numpy as np
+from sal.dataclass.signal.reduction import bin_width, bin_edges, reduce_bins
+
+
+class TestReduction(unittest.TestCase):
+
+    def test_edges(self):
+
+        self.assertEqual(bin_width(10, 4), 3)
+        self.assertIsNone(bin_width(10, 10))
+        self.assertIsNone(bin_width(10, None))
+
+        rows, columns = bin_edges((10, 6), [4])
+        np.testing.assert_array_equal(rows, [0, 3, 6, 9])
+        self.assertIsNone(columns)
+
+    def test_reduce(self):
+
+        # the final bin holds the single remaining point
+        data = np.arange(10, dtype=np.float32)
+        edges = bin_edges(data.shape, [4])
+
+        expected = {
+            'min': [0, 3, 6, 9],
+            'max': [2, 5, 8, 9],
+            'mean': [1, 4, 7, 9]
+        }
+
+        for method, values in expected.items():
+            reduced = reduce_bins(data, edges, method)
+            np.testing.assert_array_equal(reduced, values)
+            self.assertEqual(reduced.dtype, np.float32)
+
+        with self.assertRaises(ValueError):
+            reduce_bins(data, edges, 'median')
+
+    def test_integer_mean(self):
+
+        # large integers must not overflow when summed
+        data = np.full(4, np.iinfo(np.int32).max, dtype=np.int32)
+        reduced = reduce_bins(data, bin_edges(data.shape, [2]), 'mean')
+        self.assertEqual(reduced.dtype, np.float64)
+        np.testing.assert_array_equal(reduced, [np.iinfo(np.int32).max] * 2)
+
+        reduced = reduce_bins(data, bin_edges(data.shape, [2]), 'max')
+        self.assertEqual(reduced.dtype, np.int32)
+
+    def test_multiple_axes(self):
+
+        data = np.arange(24, dtype=np.float64).reshape(4, 6)
+        reduced = reduce_bins(data, bin_edges(data.shape, [2, 3]), 'mean')
+        np.testing.assert_array_equal(reduced, [[3.5, 5.5, 7.5], [15.5, 17.5, 19.5]])
+        self.assertTrue(reduced.flags.c_contiguous)
@@ -0,0 +1,74 @@
+import unittest
+import numpy as np
+from sal.core.selection import Selection
+from sal.dataclass import *
+
+
+class TestSignalBinning(unittest.TestCase):
+
+    def setUp(self):
+
+        self.signal = Signal(
+            dimensions=[CalculatedDimension(length=10, start=1.0, step=0.5, temporal=True)],
+            data=np.arange(10, dtype=np.float32),
+            dtype=np.float32,
+            error=SymmetricArrayError(np.arange(10) / 10),
+            mask=ArrayStatus([0, 0, 1, 0, 0, 0, 0, 0, 0, 1], key=['ok', 'bad'])
+        )
+
+    def test_bins(self):
+
+        signal = self.signal.select(Selection(bins=[4], reduce='mean'))
+
+        np.testing.assert_array_equal(signal.data, [1, 4, 7, 9])
+        self.assertEqual(signal.data.dtype, np.float32)
+
+        # each bin reports the largest error and highest status in the bin
+        np.testing.assert_allclose(signal.error.data, [0.2, 0.5, 0.8, 0.9])
+        np.testing.assert_array_equal(signal.mask.status, [1, 0, 0, 1])
+
+        # the calculated coordinate is the centre of each bin window
+        dimension = signal.dimensions[0]
+        self.assertIsInstance(dimension, CalculatedDimension)
+        self.assertEqual(dimension.length, 4)
+        self.assertEqual(dimension.start, 1.5)
+        self.assertEqual(dimension.step, 1.5)
+        self.assertTrue(dimension.temporal)
+
+        signal = self.signal.select(Selection(bins=[4], reduce='max'))
+        np.testing.assert_array_equal(signal.data, [2, 5, 8, 9])
+
+    def test_slice_and_bins(self):
+
+        # binning is applied to the selected points
+        signal = self.signal.select(Selection(slices=[slice(2, None)], bins=[4]))
+        np.testing.assert_array_equal(signal.data, [2.5, 4.5, 6.5, 8.5])
+
+        dimension = signal.dimensions[0]
+        self.assertEqual(dimension.length, 4)
+        self.assertEqual(dimension.start, 2.25)
+        self.assertEqual(dimension.step, 1.0)
+
+    def test_array_dimension(self):
+
+        signal = Signal(
+            dimensions=[ArrayDimension(np.arange(10, dtype=np.float32) * 2, dtype=np.float32)],
+            data=np.arange(10, dtype=np.int32),
+            dtype=np.int32
+        )
+
+        signal = signal.select(Selection(bins=[4]))
+
+        # the integer mean is float64, the float32 coordinates keep their type
+        np.testing.assert_array_equal(signal.data, [1, 4, 7, 9])
+        self.assertEqual(signal.data.dtype, np.float64)
+        np.testing.assert_array_equal(signal.dimensions[0].data, [2, 8, 14, 18])
+        self.assertEqual(signal.dimensions[0].data.dtype, np.float32)
+
+    def test_unbinned(self):
+
+        # fewer points than bins leaves the signal unchanged
+        signal = self.signal.select(Selection(bins=[20]))
+        np.testing.assert_array_equal(signal.data, self.signal.data)
+        self.assertEqual(signal.dimensions[0].start, 1.0)
+        self.assertEqual(signal.dimensions[0].step, 0.5)
@@ -2,11 +2,160 @@
 Utility functions for generating and validating authentication tokens.
 """
 
-from functools import wraps
+import hmac
+import json
+import time
+import hashlib
+import threading
+from collections import OrderedDict
+from datetime import timezone
+from functools import wraps, lru_cache
 from flask_restful import reqparse, request, current_app
 from itsdangerous import URLSafeTimedSerializer, SignatureExpired, BadSignature
 from sal.core.exception import AuthenticationFailed
 
+# default number of verified tokens cached per worker process
+DEFAULT_TOKEN_CACHE_SIZE = 4096
+
+# default time in seconds before a cached token is verified again
+DEFAULT_TOKEN_CACHE_TTL = 300
+
+
+class TokenCache:
+    """
+    A bounded cache of verified authentication tokens.
+
+    Verifying a token requires the signature to be recomputed, under heavy
+    load this is a substantial fraction of the cost of a small request.
+    Clients reuse a token for many requests, so the result of a successful
+    verification is cached for a short period.
+
+    An entry holds the user name and client address decoded from the token
+    and is discarded once either the token expires or the entry is older
+    than the ttl. The client address is still checked against each request.
+    Only valid tokens are cached, the least recently used entries are
+    evicted once the cache is full.
+
+    If a SharedStore is supplied, verified tokens are also held in the
+    shared store so a token verified by one server process is accepted by
+    the other processes sharing the store without verification. Tokens are
+    held under a hash of the token, the token itself is not stored. Shared
+    entries are authenticated with a HMAC of the token and entry keyed by
+    the token secret, entries that were not written by a server holding the
+    secret are ignored.
+
+    The cache may be shared between threads.
+
+    :param size: The maximum number of cached tokens (default=4096).
+    :param ttl: The maximum time in seconds an entry is held (default=300).
+    :param shared: A SharedStore instance or None (default=None).
+    :param secret: The token secret string, required if a shared store is supplied (default=None).
+    """
+
+    def __init__(self, size=DEFAULT_TOKEN_CACHE_SIZE, ttl=DEFAULT_TOKEN_CACHE_TTL, shared=None, secret=None):
+
+        if size < 0 or ttl < 0:
+            raise ValueError('The token cache size and ttl cannot be negative.')
+
+        if shared is not None and not secret:
+            raise ValueError('A token secret is required to share verified tokens.')
+
+        self.size = size
+        self.ttl = ttl
+        self.shared = shared
+        self._key = secret.encode('utf-8') if secret else None
+        self._items = OrderedDict()
+        self._lock = threading.Lock()
+
+    def get(self, token):
+        """
+        Returns the user name and client address of a cached token.
+
+        :param token: A token string.
+        :return: A (user, address) tuple or None if the token is not cached.
+        """
+
+        now = time.time()
+        with self._lock:
+            entry = self._items.get(token)
+            if entry is not None:
+                user, address, expires = entry
+                if now < expires:
+                    self._items.move_to_end(token)
+                    return user, address
+                del self._items[token]
+
+        if self.shared is None or not self.size or not self.ttl:
+            return None
+
+        # a token verified by another process, held locally until the shared entry expires
+        try:
+            mac, entry = self.shared.get(self._shared_key(token)).decode('utf-8').split(':', 1)
+            if not hmac.compare_digest(mac, self._mac(token, entry)):
+                return None
+            user, address, expires = json.loads(entry)
+        except (AttributeError, TypeError, ValueError):
+            return None
+
+        if now >= expires:
+            return None
+
+        self._insert(token, user, address, expires)
+        return user, address
+
+    def put(self, token, user, address, expires):
+        """
+        Adds a verified token to the cache.
+
+        :param token: A token string.
+        :param user: The user name decoded from the token.
+        :param address: The client address decoded from the token.
+        :param expires: The expiry time of the token in seconds since the epoch.
+        """
+
+        if not self.size or not self.ttl:
+            return
+
+        now = time.time()
+        expires = min(expires, now + self.ttl)
+        self._insert(token, user, address, expires)
+
+        if self.shared is not None and expires > now:
+            entry = json.dumps([user, address, expires])
+            value = '{}:{}'.format(self._mac(token, entry), entry).encode('utf-8')
+            self.shared.set(self._shared_key(token), value, expires - now)
+
+    def clear(self):
+        """
+        Removes all tokens from the cache.
+        """
+
+        with self._lock:
+            self._items.clear()
+
+    def _insert(self, token, user, address, expires):
+        """
+        Adds an entry to the local cache, evicting the least recently used entries.
+        """
+
+        with self._lock:
+            self._items[token] = (user, address, expires)
+            self._items.move_to_end(token)
+            while len(self._items) > self.size:
+                self._items.popitem(last=False)
+
+    def _mac(self, token, entry):
+        """
+        Returns the hex HMAC authenticating a shared entry for a token.
+        """
+
+        message = 'sal-token-cache\n{}\n{}'.format(token, entry).encode('utf-8')
+        return hmac.new(self._key, message, hashlib.sha256).hexdigest()
+
+    @staticmethod
+    def _shared_key(token):
+        return 'token:' + hashlib.sha256(token.encode('utf-8')).hexdigest()
+
 
 def auth_required():
     """
@@ -31,8 +180,7 @@ def generate_token(user):
     :return: A URL-safe authorisation token string.
     """
 
-    secret = current_app.config['SAL']['TOKEN_SECRET']
-    serializer = URLSafeTimedSerializer(secret)
+    serializer = _serializer(current_app.config['SAL']['TOKEN_SECRET'])
     return serializer.dumps((user, request.remote_addr))
 
 
@@ -44,17 +192,26 @@ def verify_token(token):
     decoded and returned. If the token has expired or is otherwise invalid,
     this function will return None.
 
+    Successfully verified tokens are held in the server token cache, if
+    enabled, until they expire.
+
     :param token: A token string.
     :return: The user name if valid, else None.
     """
 
-    secret = current_app.config['SAL']['TOKEN_SECRET']
+    cache = current_app.config['SAL']['TOKEN_CACHE']
+    if cache is not None:
+        entry = cache.get(token)
+        if entry is not None:
+            user, ip = entry
+            return user if ip == request.remote_addr else None
+
     lifetime = current_app.config['SAL']['TOKEN_LIFETIME']
-    serializer = URLSafeTimedSerializer(secret)
+    serializer = _serializer(current_app.config['SAL']['TOKEN_SECRET'])
 
     # extract data from token
     try:
-        data = serializer.loads(token, max_age=lifetime)
+        data, timestamp = serializer.loads(token, max_age=lifetime, return_timestamp=True)
     except SignatureExpired:
         # valid token, but expired
         return None
@@ -65,9 +222,15 @@ def verify_token(token):
     # unpack contents
     try:
         user, ip = data
-    except ValueError:
+    except (TypeError, ValueError):
         return None
 
+    if cache is not None:
+        # older itsdangerous releases return a naive utc timestamp
+        if timestamp.tzinfo is None:
+            timestamp = timestamp.replace(tzinfo=timezone.utc)
+        cache.put(token, user, ip, timestamp.timestamp() + lifetime)
+
     # check client ip is the same as the token
     if ip != request.remote_addr:
         return None
@@ -75,6 +238,17 @@ def verify_token(token):
     return user
 
 
+@lru_cache(maxsize=8)
+def _serializer(secret):
+    """
+    Returns the token serializer for a secret.
+
+    The serializer is immutable and shared by all requests.
+    """
+
+    return URLSafeTimedSerializer(secret)
+
+
 def authenticated_endpoint(f):
     @wraps(f)
     def wrapper(*args, **kwargs):
@@ -0,0 +1,296 @@
+import os
+import time
+import threading
+from collections import deque
+
+from sal.core.path import Path
+from sal.core.time import encode_timestamp, new_timestamp
+
+"""
+Change events for the SAL server.
+
+The server publishes an event for each node written through the persistence
+provider: the operation ('put', 'copy' or 'delete'), the node path and the
+head revision following the write. Subscribers receive the events for the
+nodes at or below the path prefixes they subscribe to.
+
+The bus observes the writes made through an ObservedPersistence proxy of the
+provider, the head revision is that of the write (see Write.revision).
+Events are held per process, a process only publishes the writes it makes.
+Writes made by other processes are detected from the head revision of the
+tree when subscribers are idle and are published as 'revision' events
+without a path, see EventBus.poll(). Each event has an id, recent events
+are retained so a subscriber may resume from the last event it received.
+Event ids are only meaningful to the process that issued them. If the
+events a subscriber requires are no longer available (or were issued by
+another process), or the subscriber does not keep up, it receives a 'reset'
+event and must resynchronise with the tree.
+"""
+
+# event name published for each persistence provider write operation
+EVENT_NAMES = {
+    'put': 'put',
+    'put_stream': 'put',
+    'put_many': 'put',
+    'copy': 'copy',
+    'delete': 'delete'
+}
+
+# events that apply to the whole tree, these are delivered to every subscriber
+TREE_EVENTS = ('revision', 'reset')
+
+# default number of recent events retained for resuming subscribers
+DEFAULT_HISTORY = 4096
+
+# default number of undelivered events held for a subscriber before it is reset
+DEFAULT_BACKLOG = 1024
+
+# default maximum number of concurrent subscribers
+DEFAULT_MAX_SUBSCRIBERS = 256
+
+# default minimum time in seconds between checks of the head revision for writes made by other processes
+DEFAULT_POLL_INTERVAL = 15.0
+
+
+class Subscription:
+    """
+    A subscriber's queue of events.
+
+    Subscriptions are created by EventBus.subscribe() and must be closed
+    once the subscriber disconnects.
+
+    :param bus: The EventBus.
+    :param prefixes: A tuple of normalised absolute path strings.
+    :param backlog: The maximum number of undelivered events.
+    """
+
+    def __init__(self, bus, prefixes, backlog):
+
+        self.prefixes = prefixes
+        self._bus = bus
+        self._backlog = backlog
+        self._events = deque()
+        self._condition = threading.Condition()
+        self._closed = False
+
+    def matches(self, event):
+        """
+        Tests if an event is delivered to the subscription.
+
+        :param event: An event dictionary.
+        :return: True if the event matches the subscribed prefixes.
+        """
+
+        if event['operation'] in TREE_EVENTS:
+            return True
+
+        path = event['path']
+        return any(prefix == '/' or path == prefix or path.startswith(prefix + '/') for prefix in self.prefixes)
+
+    def next(self, timeout=None):
+        """
+        Returns the next event, waiting up to timeout seconds.
+
+        :param timeout: The maximum time to wait in seconds or None to wait indefinitely (default=None).
+        :return: An event dictionary or None if no event arrived or the subscription is closed.
+        """
+
+        with self._condition:
+            if not self._events and not self._closed:
+                self._condition.wait(timeout)
+            return self._events.popleft() if self._events else None
+
+    def close(self):
+        """
+        Closes the subscription, the subscriber no longer receives events.
+        """
+
+        self._bus._unsubscribe(self)
+        with self._condition:
+            self._closed = True
+            self._condition.notify_all()
+
+    @property
+    def closed(self):
+        return self._closed
+
+    def _deliver(self, event):
+        """
+        Queues an event, a subscriber that has fallen behind is reset.
+        """
+
+        with self._condition:
+            if self._closed:
+                return
+
+            if len(self._events) >= self._backlog:
+                self._events.clear()
+                self._events.append(self._bus._reset_event())
+                self._closed = True
+                self._bus._unsubscribe(self)
+            else:
+                self._events.append(event)
+            self._condition.notify_all()
+
+
+class EventBus:
+    """
+    Publishes node change events to subscribers.
+
+    The bus publishes the writes it is notified of by an ObservedPersistence
+    proxy, the provider is used to poll for writes made by other processes.
+    The bus may be shared between threads.
+
+    :param provider: A PersistenceProvider instance.
+    :param history: The number of recent events retained (default=DEFAULT_HISTORY).
+    :param backlog: The maximum number of undelivered events per subscriber (default=DEFAULT_BACKLOG).
+    :param max_subscribers: The maximum number of concurrent subscribers (default=DEFAULT_MAX_SUBSCRIBERS).
+    :param poll_interval: The minimum time in seconds between checks for writes made by other processes (default=DEFAULT_POLL_INTERVAL).
+    """
+
+    def __init__(self, provider, history=DEFAULT_HISTORY, backlog=DEFAULT_BACKLOG, max_subscribers=DEFAULT_MAX_SUBSCRIBERS,
+                 poll_interval=DEFAULT_POLL_INTERVAL):
+
+        self.provider = provider
+        self.max_subscribers = max_subscribers
+        self.poll_interval = poll_interval
+
+        # event ids are prefixed by an instance id unique to the bus
+        self.instance = os.urandom(4).hex()
+
+        self._history = deque(maxlen=history)
+        self._backlog = backlog
+        self._subscriptions = set()
+        self._sequence = 0
+        self._revision = None
+        self._polled = None
+        self._lock = threading.RLock()
+
+    def written(self, write):
+        """
+        Publishes the events for a write, called by ObservedPersistence.
+
+        :param write: A Write instance.
+        """
+
+        self.publish(EVENT_NAMES[write.operation], write.paths, write.revision)
+
+    def publish(self, operation, paths, revision):
+        """
+        Publishes an event for each path.
+
+        :param operation: The event name e.g. 'put'.
+        :param paths: A list of normalised node path strings, None for tree events.
+        :param revision: The head revision following the operation.
+        """
+
+        with self._lock:
+
+            self._revision = revision if self._revision is None else max(self._revision, revision)
+
+            events = []
+            timestamp = encode_timestamp(new_timestamp())
+            for path in paths or [None]:
+                self._sequence += 1
+                event = {'id': self._id(self._sequence), 'operation': operation, 'path': path, 'revision': revision, 'timestamp': timestamp}
+                self._history.append((self._sequence, event))
+                events.append(event)
+
+            subscriptions = list(self._subscriptions)
+
+        for subscription in subscriptions:
+            for event in events:
+                if subscription.matches(event):
+                    subscription._deliver(event)
+
+    def poll(self):
+        """
+        Publishes a 'revision' event if the tree was modified by another process.
+
+        The head revision of the tree is compared with the latest revision
+        published by this process. The subscribers share the check, the tree
+        is listed at most once per poll interval.
+        """
+
+        with self._lock:
+            now = time.monotonic()
+            if self._polled is not None and now - self._polled < self.poll_interval:
+                return
+            self._polled = now
+
+        head = self.provider.list('/').revision_latest
+        with self._lock:
+            if self._revision is None:
+                self._revision = head
+                return
+            changed = head > self._revision
+
+        if changed:
+            self.publish('revision', None, head)
+
+    def subscribe(self, paths=('/',), last_id=None):
+        """
+        Subscribes to the events for nodes at or below the paths.
+
+        If the id of the last event received by the subscriber is supplied,
+        the retained events following it are queued. If events have been
+        missed that are no longer retained, a 'reset' event is queued.
+
+        :param paths: A list of absolute path strings (default=('/',)).
+        :param last_id: The id string of the last event received or None (default=None).
+        :return: A Subscription.
+        :raises InvalidPath: If a path is invalid.
+        :raises ValueError: If a path is relative or has a revision.
+        :raises OverflowError: If the maximum number of subscribers has been reached.
+        """
+
+        prefixes = []
+        for path in paths:
+            path = Path(path)
+            if not path.absolute or path.revision:
+                raise ValueError('Subscription paths must be absolute paths without a revision.')
+            prefixes.append(str(path))
+
+        subscription = Subscription(self, tuple(prefixes), self._backlog)
+        with self._lock:
+
+            if len(self._subscriptions) >= self.max_subscribers:
+                raise OverflowError('The maximum number of subscribers has been reached.')
+
+            if last_id is not None:
+                sequence = self._sequence_of(last_id)
+                oldest = self._history[0][0] if self._history else self._sequence + 1
+                if sequence is None or sequence > self._sequence or sequence + 1 < oldest:
+                    subscription._deliver(self._reset_event())
+                else:
+                    for number, event in self._history:
+                        if number > sequence and subscription.matches(event):
+                            subscription._deliver(event)
+
+            if not subscription.closed:
+                self._subscriptions.add(subscription)
+        return subscription
+
+    def _id(self, sequence):
+        return '{}-{}'.format(self.instance, sequence)
+
+    def _sequence_of(self, event_id):
+        """
+        Returns the sequence number of an event id issued by this bus or None.
+        """
+
+        instance, _, sequence = str(event_id).partition('-')
+        if instance != self.instance or not sequence.isdigit():
+            return None
+        return int(sequence)
+
+    def _unsubscribe(self, subscription):
+        with self._lock:
+            self._subscriptions.discard(subscription)
+
+    def _reset_event(self):
+        """
+        Returns a reset event, the id is that of the latest event so a resuming subscriber continues from it.
+        """
+
+        return {'id': self._id(self._sequence), 'operation': 'reset', 'path': None, 'revision': self._revision, 'timestamp': encode_timestamp(new_timestamp())}
@@ -0,0 +1,458 @@
+import time
+import bisect
+import threading
+from datetime import datetime
+
+import numpy as np
+
+from sal.core.object import LeafReport, TreeReport, DataSummary
+from sal.core.path import Path
+from sal.core.exception import NodeNotFound, InvalidRequest
+from sal.core.time import validate_timestamp
+
+"""
+Leaf metadata index for the SAL server.
+
+The index holds the LeafReport fields and the summary metadata of every leaf
+in the head revision of the data tree, so leaves matching a query may be
+found without crawling the tree. The summary metadata is the flattened
+summary dictionary of the leaf object, keyed by '/' separated paths e.g.
+'units' or 'dimensions/0/temporal'. Only scalar values are indexed.
+
+The index is built from the persistence provider on first use and is kept
+up to date by the writes observed by an ObservedPersistence proxy of the
+provider, the head revision is tracked from the written nodes. Writes made by other processes, for instance
+when several server processes write to the same tree, are detected by
+checking the head revision of the tree at most once per refresh interval.
+If the head revision has moved by more than the writes seen by the index,
+the index is rebuilt.
+"""
+
+# persistence provider write operations that replace the whole subtree at the written paths
+SUBTREE_OPERATIONS = ('copy', 'delete')
+
+# default maximum number of search results
+DEFAULT_LIMIT = 1000
+
+# default minimum time in seconds between checks of the head revision for writes made by other processes
+DEFAULT_REFRESH_INTERVAL = 5.0
+
+# a metadata key segment matching any single key segment
+WILDCARD = '*'
+
+
+class MetadataIndex:
+    """
+    An index of the leaf metadata of a persistence provider's data tree.
+
+    The index records the writes it is notified of by an ObservedPersistence
+    proxy of the provider, see written(). The index may be shared between
+    threads.
+
+    :param provider: A PersistenceProvider instance.
+    :param refresh_interval: The minimum time in seconds between checks for writes made by other processes (default=DEFAULT_REFRESH_INTERVAL).
+    """
+
+    def __init__(self, provider, refresh_interval=DEFAULT_REFRESH_INTERVAL):
+
+        self.provider = provider
+        self.refresh_interval = refresh_interval
+
+        # path -> leaf record, leaf paths are kept sorted for prefix queries
+        self._records = {}
+        self._paths = []
+        self._classes = {}
+
+        # the head revision described by the index, None if the index must be built
+        self._revision = None
+
+        # monotonic time the head revision of the tree was last known to match the index
+        self._checked = None
+        self._lock = threading.RLock()
+
+    @property
+    def revision(self):
+        """
+        The head revision described by the index or None if not built.
+        """
+
+        return self._revision
+
+    def build(self):
+        """
+        Builds the index from the head revision of the tree.
+        """
+
+        with self._lock:
+            head = self._head()
+            self._clear()
+            self._crawl((), head)
+            self._revision = head
+            self._checked = time.monotonic()
+
+    def search(self, path='/', cls=None, group=None, version=None, metadata=None, modified_after=None, modified_before=None, limit=DEFAULT_LIMIT):
+        """
+        Returns the leaves under a path that match all the supplied criteria.
+
+        Metadata criteria are a dictionary of summary metadata keys and the
+        values they must equal. A key segment of '*' matches any key segment,
+        for instance {'dimensions/*/temporal': True} matches objects with any
+        temporal dimension.
+
+        The index is built if required before it is searched. Writes made by
+        other processes are only seen once the refresh interval has elapsed
+        since the head revision was last checked. Leaves are returned in path
+        order.
+
+        :param path: An absolute path without a revision (default='/').
+        :param cls: The object class (default=None).
+        :param group: The object group (default=None).
+        :param version: The object version (default=None).
+        :param metadata: A dictionary of metadata keys and values (default=None).
+        :param modified_after: An ISO 8601 string or datetime, matches leaves modified at or after this time (default=None).
+        :param modified_before: An ISO 8601 string or datetime, matches leaves modified before this time (default=None).
+        :param limit: The maximum number of results or None for no limit (default=DEFAULT_LIMIT).
+        :return: A list of (path, LeafReport) tuples.
+        :raises InvalidRequest: If the search criteria are invalid.
+        """
+
+        prefix = self._prefix(path)
+        criteria = self._criteria(metadata)
+
+        try:
+            modified_after = validate_timestamp(modified_after) if modified_after is not None else None
+            modified_before = validate_timestamp(modified_before) if modified_before is not None else None
+        except ValueError:
+            raise InvalidRequest('Modification times must be ISO 8601 strings.')
+
+        if limit is not None and (not isinstance(limit, int) or isinstance(limit, bool) or limit < 1):
+            raise InvalidRequest('The result limit must be an integer >= 1.')
+
+        with self._lock:
+
+            if self._stale():
+                self.build()
+
+            # narrow the candidates by class if it is more selective than the path
+            paths = self._range(prefix)
+            if cls is not None:
+                classed = self._classes.get(cls, ())
+                if len(classed) < len(paths):
+                    paths = sorted(p for p in classed if p == prefix or p.startswith(prefix.rstrip('/') + '/'))
+
+            results = []
+            for leaf in paths:
+                record = self._records[leaf]
+                if cls is not None and record['class'] != cls:
+                    continue
+                if group is not None and record['group'] != group:
+                    continue
+                if version is not None and record['version'] != version:
+                    continue
+                if modified_after is not None and record['timestamp'] < modified_after:
+                    continue
+                if modified_before is not None and record['timestamp'] >= modified_before:
+                    continue
+                if not all(self._match(record['metadata'], key, value) for key, value in criteria):
+                    continue
+
+                results.append((leaf, self._report(record)))
+                if limit is not None and len(results) >= limit:
+                    break
+
+            return results
+
+    def written(self, write):
+        """
+        Updates the index after nodes have been written in a single revision, called by ObservedPersistence.
+
+        The subtrees at the paths of a copy or delete were replaced and are
+        indexed again. Otherwise only the nodes themselves were written (put),
+        the descendants of a branch node are unchanged.
+
+        If other writes have been made since the index was last updated, the
+        index is marked for rebuilding instead.
+
+        :param write: A Write instance.
+        """
+
+        subtree = write.operation in SUBTREE_OPERATIONS
+        with self._lock:
+
+            if self._revision is None:
+                return
+
+            try:
+                # the head revision is read from the written nodes, see Write.revision
+                head = write.revision
+
+                # writes already seen by the index
+                if head == self._revision:
+                    return
+
+                if head != self._revision + 1:
+                    self._revision = None
+                    return
+
+                for path in write.paths:
+                    self._refresh(Path(path).segments, write.report(path), head, subtree)
+                self._revision = head
+                self._checked = time.monotonic()
+
+            except Exception:
+                # never fail a write that has succeeded, the index is rebuilt on the next search
+                self._revision = None
+
+    def _refresh(self, segments, report, revision, subtree):
+        """
+        Indexes a written node at the specified revision, the report is the node report or None if deleted.
+        """
+
+        root = '/' + '/'.join(segments)
+
+        # a written leaf replaces any subtree, a written branch keeps its descendants
+        if subtree or isinstance(report, LeafReport):
+            self._remove(segments)
+            if report is not None:
+                self._crawl(segments, revision)
+
+        elif root in self._records:
+            self._discard(root)
+
+    def _stale(self):
+        """
+        Returns True if the index must be rebuilt.
+
+        The head revision of the tree is checked at most once per refresh interval.
+        """
+
+        if self._revision is None:
+            return True
+
+        now = time.monotonic()
+        if self._checked is not None and now - self._checked < self.refresh_interval:
+            return False
+
+        self._checked = now
+        return self._revision != self._head()
+
+    def _head(self):
+        """
+        Returns the head revision of the tree.
+        """
+
+        return self.provider.list('/').revision_latest
+
+    def _crawl(self, segments, revision):
+        """
+        Adds the leaves of the subtree at the specified revision.
+        """
+
+        root = '/' + '/'.join(segments)
+        try:
+            tree = self.provider.list_tree('{}:{}'.format(root, revision))
+        except NodeNotFound:
+            return
+
+        if isinstance(tree, TreeReport):
+            leaves = [
+                '/' + '/'.join(segments + ((relative,) if relative else ()) + (name,))
+                for relative, report in tree.walk() for name, _ in report.leaves
+            ]
+        else:
+            leaves = [root]
+
+        if not leaves:
+            return
+
+        versioned = ['{}:{}'.format(leaf, revision) for leaf in leaves]
+        summaries = self.provider.get_many(versioned, summary=True)
+        added = []
+        for leaf, versioned_path, summary in zip(leaves, versioned, summaries):
+            if isinstance(summary, Exception):
+                continue
+            self._add(leaf, self.provider.list(versioned_path), summary)
+            added.append(leaf)
+
+        # new paths are merged with a single sort rather than an insertion per path
+        if len(added) == 1:
+            bisect.insort(self._paths, added[0])
+        else:
+            self._paths.extend(added)
+            self._paths.sort()
+
+    def _add(self, path, report, summary):
+        """
+        Adds a leaf record, the caller adds the path to the sorted paths.
+        """
+
+        metadata = {}
+        if isinstance(summary, DataSummary):
+            _flatten(summary.to_dict(), '', metadata)
+
+        self._records[path] = {
+            'description': report.description,
+            'class': report.cls,
+            'group': report.group,
+            'version': report.version,
+            'timestamp': report.timestamp,
+            'revision_modified': tuple(report.revision_modified),
+            'metadata': metadata
+        }
+        self._classes.setdefault(report.cls, set()).add(path)
+
+    def _remove(self, segments):
+        """
+        Removes the records of the node and its descendants.
+        """
+
+        root = '/' + '/'.join(segments)
+        for path in self._range(root):
+            record = self._records.pop(path)
+            self._classes[record['class']].discard(path)
+
+        if root == '/':
+            self._paths = []
+            return
+
+        start = bisect.bisect_left(self._paths, root + '/')
+        end = bisect.bisect_left(self._paths, root + '0')
+        del self._paths[start:end]
+
+        index = bisect.bisect_left(self._paths, root)
+        if index < len(self._paths) and self._paths[index] == root:
+            del self._paths[index]
+
+    def _discard(self, path):
+        """
+        Removes the record of a single leaf.
+        """
+
+        record = self._records.pop(path)
+        self._classes[record['class']].discard(path)
+        del self._paths[bisect.bisect_left(self._paths, path)]
+
+    def _clear(self):
+        """
+        Removes all records.
+        """
+
+        self._records = {}
+        self._paths = []
+        self._classes = {}
+
+    def _range(self, root):
+        """
+        Returns the sorted leaf paths at or below a node path.
+        """
+
+        if root == '/':
+            return list(self._paths)
+
+        # descendants sort between root + '/' and root + '0' as '0' follows '/'
+        start = bisect.bisect_left(self._paths, root + '/')
+        end = bisect.bisect_left(self._paths, root + '0')
+        descendants = self._paths[start:end]
+        return [root] + descendants if root in self._records else descendants
+
+    def _report(self, record):
+        """
+        Generates the LeafReport for a leaf record.
+        """
+
+        return LeafReport(
+            record['description'],
+            record['class'],
+            record['group'],
+            record['version'],
+            record['timestamp'],
+            revision_current=self._revision,
+            revision_latest=self._revision,
+            revision_modified=record['revision_modified']
+        )
+
+    @staticmethod
+    def _prefix(path):
+        """
+        Validates the search path, returns the normalised path string.
+        """
+
+        if not isinstance(path, str):
+            raise InvalidRequest('The search path must be a path string.')
+
+        path = Path(path)
+        if not path.absolute:
+            raise InvalidRequest('The search path must be an absolute path.')
+        if path.revision:
+            raise InvalidRequest('The search index describes the head revision, a revision cannot be specified.')
+        return str(path)
+
+    @staticmethod
+    def _criteria(metadata):
+        """
+        Validates the metadata criteria, returns a list of (key segments, value) tuples.
+        """
+
+        if metadata is None:
+            return []
+
+        if not isinstance(metadata, dict):
+            raise InvalidRequest('The metadata criteria must be a dictionary.')
+
+        criteria = []
+        for key, value in metadata.items():
+            if not isinstance(key, str) or not key:
+                raise InvalidRequest('Metadata keys must be non-empty strings.')
+            if not isinstance(value, (str, bool, int, float)):
+                raise InvalidRequest('Metadata values must be strings, numbers or booleans.')
+            criteria.append((tuple(key.split('/')), value))
+        return criteria
+
+    @staticmethod
+    def _match(metadata, key, value):
+        """
+        Tests if any metadata entry matching the key equals the value.
+        """
+
+        if WILDCARD not in key:
+            return _equal(metadata.get('/'.join(key), _MISSING), value)
+
+        for name, item in metadata.items():
+            segments = name.split('/')
+            if len(segments) == len(key) and all(k == WILDCARD or k == s for k, s in zip(key, segments)):
+                if _equal(item, value):
+                    return True
+        return False
+
+
+# sentinel for absent metadata entries
+_MISSING = object()
+
+
+def _equal(item, value):
+    """
+    Compares a metadata entry with a value, booleans only equal booleans.
+    """
+
+    if item is _MISSING or isinstance(item, bool) != isinstance(value, bool):
+        return False
+    return item == value
+
+
+def _flatten(d, prefix, metadata):
+    """
+    Adds the scalar values of a nested dictionary to a flat metadata dictionary.
+    """
+
+    for key, value in d.items():
+        name = prefix + key
+        if name == '_type':
+            continue
+        if isinstance(value, dict):
+            _flatten(value, name + '/', metadata)
+        elif isinstance(value, (str, bool, int, float)):
+            metadata[name] = value
+        elif isinstance(value, np.generic) and value.ndim == 0 and value.dtype.kind in 'biuf':
+            metadata[name] = value.item()
+        elif isinstance(value, datetime):
+            metadata[name] = value.isoformat()
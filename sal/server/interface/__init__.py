@@ -1,3 +1,4 @@
 from .persistence import PersistenceProvider
 from .authentication import AuthenticationProvider
-from .authorisation import AuthorisationProvider
\ No newline at end of file
+from .authorisation import AuthorisationProvider
+from .store import SharedStore
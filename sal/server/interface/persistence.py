@@ -1,4 +1,7 @@
-from sal.core.exception import UnsupportedOperation
+from sal.core.exception import SALException, UnsupportedOperation, InvalidRequest
+from sal.core.object import Branch, DataObject, BranchReport, TreeReport
+from sal.core.serialise import deserialise
+from sal.core.path import decompose
 
 """
 Persistence provider must implement data model
@@ -78,6 +81,50 @@ class PersistenceProvider:
 
         raise UnsupportedOperation
 
+    def list_tree(self, path, depth=None, group=None):
+        """
+        Returns node meta data for the subtree at the specific path.
+
+        If the path identifies a branch node, a TreeReport describing the
+        branch and its descendant branches is returned. The depth limits the
+        number of branch levels described, a depth of 1 describes the branch
+        and its immediate children only (the equivalent of list()). If depth
+        is None the full subtree is described. For leaf nodes, a LeafReport
+        object is returned.
+
+        The revision of the path applies to the whole subtree.
+
+        The default implementation calls list() for each branch in the
+        subtree. Persistence providers able to describe a subtree in a single
+        operation (e.g. an indexed database query) should override this
+        method.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param path: A valid node path.
+        :param depth: The number of branch levels to describe or None for the full subtree (default=None).
+        :param group: A permission group (default: guest).
+        :return: A TreeReport or LeafReport object.
+        :raises InvalidPath: If the supplied path is invalid.
+        :raises NodeNotFound: If the path does not point ot a node.
+        :raises PermissionDenied: If the group does not have permission to access the node.
+        """
+
+        report = self.list(path, group)
+        if not isinstance(report, BranchReport):
+            return report
+
+        children = {}
+        if depth is None or depth > 1:
+            segments, revision, _ = decompose(path)
+            for name in report.branches:
+                child_path = '/{}:{}'.format('/'.join(segments + [name]), revision)
+                children[name] = self.list_tree(child_path, None if depth is None else depth - 1, group)
+
+        return TreeReport(report, children)
+
     def get(self, path, summary=False, group=None):
         """
         Returns node data for the specific path.
@@ -92,6 +139,11 @@ class PersistenceProvider:
         returned, if true a data summary is returned. The summary argument has
         no effect for branch nodes.
 
+        Summary requests are frequent and should not require the data object
+        to be loaded. Providers should generate the summary with the object's
+        summary() method when the object is written and store it alongside
+        the object. Likewise, list() should be answered from stored metadata.
+
         If the persistence provider supports permissions, a group id may be
         provided. The operation will be carried out according to the
         permissions of the specified group.
@@ -107,6 +159,106 @@ class PersistenceProvider:
 
         raise UnsupportedOperation
 
+    def get_many(self, paths, summary=False, group=None):
+        """
+        Returns node data for a list of paths.
+
+        The objects are returned in the same order as the paths. The request
+        for each path succeeds or fails independently. If the request for a
+        path fails, the SAL exception raised for that path is returned in
+        place of the object.
+
+        The default implementation calls get() for each path. Persistence
+        providers able to read many nodes in a single operation should
+        override this method.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param paths: A list of valid node paths.
+        :param summary: Return summary objects (default: False).
+        :param group: A permission group (default: guest).
+        :return: A list of Branch, DataObject, DataSummary or SALException objects.
+        """
+
+        results = []
+        for path in paths:
+            try:
+                results.append(self.get(path, summary, group))
+            except SALException as e:
+                results.append(e)
+        return results
+
+    def get_selection(self, path, selection, group=None):
+        """
+        Returns a subset of the data object for the specific path.
+
+        The selection describes the index slices and/or coordinate ranges
+        requested for each dimension of the data object (see
+        sal.core.selection.Selection).
+
+        The default implementation obtains the full data object via get() and
+        applies the selection using the data object's select() method.
+        Persistence providers able to read partial data objects from storage
+        should override this method so that only the requested data is read.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param path: A valid node path.
+        :param selection: A Selection object.
+        :param group: A permission group (default: guest).
+        :return: A DataObject.
+        :raises InvalidPath: If the supplied path is invalid.
+        :raises NodeNotFound: If the path does not point ot a node.
+        :raises PermissionDenied: If the group does not have permission to access the node.
+        :raises InvalidRequest: If the selection cannot be applied to the node.
+        """
+
+        return self._select(self.get(path, False, group), selection)
+
+    def get_versioned(self, path, summary=False, selection=None, group=None):
+        """
+        Returns node data for the specific path and the revisions identifying it.
+
+        The object is obtained as per get() or, if a selection is supplied,
+        get_selection(). The revision of the object (the requested revision
+        with the head revision resolved) and the latest revision, at or
+        before that revision, in which the node was modified are also
+        returned. The revisions identify the object returned, for instance
+        when generating entity tags.
+
+        The default implementation calls list() to resolve the revisions and
+        then reads the object at the resolved revision. Persistence providers
+        should override this method so the node is resolved only once.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param path: A valid node path.
+        :param summary: Return a summary object (default: False).
+        :param selection: A Selection object or None (default: None).
+        :param group: A permission group (default: guest).
+        :return: A tuple containing the object, the object revision and the revision the node was last modified.
+        :raises InvalidPath: If the supplied path is invalid.
+        :raises NodeNotFound: If the path does not point ot a node.
+        :raises PermissionDenied: If the group does not have permission to access the node.
+        :raises InvalidRequest: If the selection cannot be applied to the node.
+        """
+
+        report = self.list(path, group)
+        revision = report.revision_current
+        modified = self._last_modified(report.revision_modified, revision)
+
+        segments, _, _ = decompose(path)
+        resolved = '/{}:{}'.format('/'.join(segments), revision)
+        if selection is not None:
+            return self.get_selection(resolved, selection, group), revision, modified
+        return self.get(resolved, summary, group), revision, modified
+
     def put(self, path, content, group=None):
         """
         Creates/updates node data at the specific path.
@@ -142,6 +294,76 @@ class PersistenceProvider:
 
         raise UnsupportedOperation
 
+    def put_stream(self, path, stream, group=None):
+        """
+        Creates/updates node data at the specific path from a binary stream.
+
+        The stream is an EnvelopeReader (see sal.core.serialise) positioned
+        after the envelope header. The serialised object document is
+        available via the stream's document attribute, the array buffers are
+        read in order via its buffers() method. This allows large data
+        objects to be written to storage in chunks, as they are received,
+        without holding the complete object in memory.
+
+        The default implementation reads the buffers into memory, builds the
+        object and calls put(). Persistence providers able to write array
+        data incrementally should override this method.
+
+        See put() for the behaviour of the operation.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param path: A valid node path.
+        :param stream: An EnvelopeReader object.
+        :param group: A permission group (default: guest).
+        :raises InvalidPath: If the supplied path is invalid.
+        :raises NodeNotFound: If the path does not point ot a node.
+        :raises PermissionDenied: If the group does not have permission to access the node.
+        :raises InvalidRequest: If the stream does not contain a valid Branch or DataObject.
+        """
+
+        try:
+            obj = deserialise(stream.document, stream.read_buffers(), adopt=True)
+        except (SALException, ValueError, TypeError, KeyError):
+            raise InvalidRequest('Could not de-serialise content.')
+
+        if not isinstance(obj, (Branch, DataObject)):
+            raise InvalidRequest('Content does not describe a Branch or DataObject.')
+
+        self.put(path, obj, group)
+
+    def put_many(self, items, group=None):
+        """
+        Creates/updates the nodes of a list of (path, content) items in order.
+
+        Each item is written as if by put(), the items are applied in order
+        so a branch may be created by an item and populated by the items that
+        follow it.
+
+        Persistence providers should apply the items as a single transaction
+        in a single revision: either all the items are written or, if any
+        item fails, none are, and readers never observe a partially applied
+        batch. The default implementation calls put() for each item and is
+        NOT atomic, the items preceding a failed item remain written.
+        Persistence providers able to write many nodes in a single
+        transaction should override this method.
+
+        If the persistence provider supports permissions, a group id may be
+        provided. The operation will be carried out according to the
+        permissions of the specified group.
+
+        :param items: A list of (path, content) tuples, the content is a Branch or DataObject instance.
+        :param group: A permission group (default: guest).
+        :raises InvalidPath: If a supplied path is invalid.
+        :raises NodeNotFound: If the parent of a node does not exist.
+        :raises PermissionDenied: If the group does not have permission to access a node.
+        """
+
+        for path, content in items:
+            self.put(path, content, group)
+
     def delete(self, path, group=None):
         """
         Delete the node specified by the path.
@@ -185,3 +407,26 @@ class PersistenceProvider:
 
         raise UnsupportedOperation
 
+    @staticmethod
+    def _select(obj, selection):
+        """
+        Applies a selection to a data object, see get_selection().
+        """
+
+        if not isinstance(obj, DataObject):
+            raise InvalidRequest('A data selection may only be applied to a leaf node.')
+
+        try:
+            return obj.select(selection)
+        except NotImplementedError as e:
+            raise InvalidRequest(str(e))
+        except ValueError as e:
+            raise InvalidRequest('Invalid data selection: {}'.format(e))
+
+    @staticmethod
+    def _last_modified(modified, revision):
+        """
+        Returns the latest of a node's modification revisions at or before a revision.
+        """
+
+        return max((r for r in modified if r <= revision), default=revision)
@@ -0,0 +1,73 @@
+from sal.core.exception import UnsupportedOperation
+
+"""
+Shared store interface
+
+A shared store holds short lived state that is shared between the server
+worker processes of a deployment, on one or more hosts, e.g. a Redis or
+memcached service. The server uses the store to share verified
+authentication tokens (see sal.server.auth.TokenCache) and, via
+CachedPersistence, serialised data objects and summaries.
+
+The store is a cache: values may be evicted at any time and the server
+remains correct if every lookup misses.
+"""
+
+
+class SharedStore:
+    """
+    Base class for shared stores.
+
+    Values are bytes objects held under string keys. Implementations must
+    be safe to use from multiple threads.
+
+    A store must not fail a request because the backing service is
+    unavailable: get() should return None and set() / delete() should do
+    nothing if the service cannot be reached.
+    """
+
+    NAME = 'Shared Store'
+    VERSION = '0.0.0'
+
+    def get(self, key):
+        """
+        Returns the value held under a key.
+
+        :param key: A key string.
+        :return: A bytes object or None if the key is not held.
+        """
+
+        raise UnsupportedOperation
+
+    def get_many(self, keys):
+        """
+        Returns the values held under a list of keys.
+
+        The default implementation calls get() for each key. Stores able to
+        look up many keys in a single operation should override this method.
+
+        :param keys: A list of key strings.
+        :return: A list of bytes objects or None for each key not held.
+        """
+
+        return [self.get(key) for key in keys]
+
+    def set(self, key, value, ttl=None):
+        """
+        Stores a value under a key, replacing any existing value.
+
+        :param key: A key string.
+        :param value: A bytes object.
+        :param ttl: The time in seconds the value is held or None for no limit (default=None).
+        """
+
+        raise UnsupportedOperation
+
+    def delete(self, key):
+        """
+        Removes a key from the store.
+
+        :param key: A key string.
+        """
+
+        raise UnsupportedOperation
@@ -3,8 +3,13 @@ from flask_restful import Api
 
 from sal.core.version import VERSION as RELEASE_VERSION
 from sal.core import exception
-from sal.server.interface import PersistenceProvider, AuthenticationProvider, AuthorisationProvider
-from sal.server.resource import ServerInfo, DataTree, Authenticator
+from sal.server.interface import PersistenceProvider, AuthenticationProvider, AuthorisationProvider, SharedStore
+from sal.server.resource import ServerInfo, ServerMetrics, DataTree, DataBatch, DataSearch, EventStream, Authenticator
+from sal.server.auth import TokenCache, DEFAULT_TOKEN_CACHE_SIZE, DEFAULT_TOKEN_CACHE_TTL
+from sal.server import metrics
+from sal.server.index import MetadataIndex
+from sal.server.events import EventBus
+from sal.server.proxy import ObservedPersistence
 from sal.dataclass import *
 
 API_VERSION = 2
@@ -19,11 +24,32 @@ class SALServer(Flask):
     generate a random 64 char (32 byte) hex string as a secret
     to generate a good key: binascii.hexlify(os.urandom(32)).decode('ascii')
     warning: do not generate dynamically in the configuration script otherwise each worker process will generate a different key!
+
+    verified authentication tokens are cached by each worker process, auth_token_cache_size limits the number of tokens
+    cached and auth_token_cache_ttl the time in seconds before a cached token is verified again. a size of 0 disables
+    the cache. if a shared_store is supplied (e.g. a RedisStore), verified tokens are also shared between all the worker
+    processes using the store. shared entries are authenticated with the token secret, entries written without the secret
+    are ignored. to share cached data objects pass the same store to CachedPersistence.
+
+    request metrics are disabled by default, set metrics_enabled to True to collect metrics and report them by the
+    /metrics endpoint. the endpoint is not authenticated, restrict access to it at the reverse proxy if the metrics should
+    not be public. the persistence provider operations are timed by a proxy of the provider, the provider is not modified.
+
+    the /search endpoint is backed by a leaf metadata index held by each worker process. the index is disabled by default,
+    set search_enabled to True to enable the index and the endpoint. the index is built by crawling the tree on the first
+    search and is updated by the writes made through the server, which are observed by a proxy of the provider.
+
+    the /events endpoint streams the writes made through the server to subscribers as server-sent events. events are
+    disabled by default, set events_enabled to True to enable the endpoint. events are published by each worker process
+    for the writes it makes, writes made by other processes are reported as a change of head revision. each subscriber
+    holds a connection open, so workers must be able to serve long lived requests (e.g. threaded or asynchronous workers).
+    the writes are observed by a proxy of the provider, the provider is not modified.
     """
 
     def __init__(self, persistence_provider, authentication_provider=None, authorisation_provider=None,
                  auth_token_secret=None, auth_token_lifetime=None, admin_enabled=False, admin_username=None, admin_password=None,
-                 *args, **kwargs):
+                 auth_token_cache_size=DEFAULT_TOKEN_CACHE_SIZE, auth_token_cache_ttl=DEFAULT_TOKEN_CACHE_TTL, shared_store=None,
+                 metrics_enabled=False, search_enabled=False, events_enabled=False, *args, **kwargs):
 
         # pass on flask configuration arguments
         super().__init__(__name__, *args, **kwargs)
@@ -31,8 +57,22 @@ class SALServer(Flask):
         # validate server configuration
         self._validate_persistence(persistence_provider)
         self._validate_auth(authentication_provider, authorisation_provider, auth_token_secret, auth_token_lifetime)
+        self._validate_token_cache(auth_token_cache_size, auth_token_cache_ttl)
+        self._validate_shared_store(shared_store)
         self._validate_admin(admin_enabled, admin_username, admin_password)
 
+        # request metrics, the index and events operate on the timed proxy
+        registry = metrics.Metrics() if metrics_enabled else None
+        if registry is not None:
+            persistence_provider = metrics.instrument(persistence_provider, registry)
+
+        # leaf metadata index and change events, updated by a proxy observing the writes
+        index = MetadataIndex(persistence_provider) if search_enabled else None
+        events = EventBus(persistence_provider) if events_enabled else None
+        observers = [observer for observer in (index, events) if observer is not None]
+        if observers:
+            persistence_provider = ObservedPersistence(persistence_provider, observers)
+
         # add to flask configuration object
         self.config['SAL'] = {
             'PERSISTENCE': persistence_provider,
@@ -40,9 +80,14 @@ class SALServer(Flask):
             'AUTHORISATION': authorisation_provider,
             'TOKEN_SECRET': auth_token_secret,
             'TOKEN_LIFETIME': auth_token_lifetime,
+            'TOKEN_CACHE': self._token_cache(auth_token_cache_size, auth_token_cache_ttl, shared_store, auth_token_secret),
+            'SHARED_STORE': shared_store,
             'ADMIN_USER_ENABLED': bool(admin_enabled),
             'ADMIN_USERNAME': admin_username,
             'ADMIN_PASSWORD': admin_password,
+            'METRICS': registry,
+            'INDEX': index,
+            'EVENTS': events,
             'API_VERSION': API_VERSION
         }
 
@@ -88,12 +133,19 @@ class SALServer(Flask):
         # build api
         api = Api(self, errors=error_map)
         api.add_resource(ServerInfo, '/')
+        api.add_resource(ServerMetrics, '/metrics', '/metrics/')
         api.add_resource(DataTree, '/data', '/data/', '/data/<path:path>')
+        api.add_resource(DataBatch, '/batch', '/batch/')
+        api.add_resource(DataSearch, '/search', '/search/')
+        api.add_resource(EventStream, '/events', '/events/')
         api.add_resource(Authenticator, '/auth', '/auth/')
 
         # todo: enable when permission system is implemented
         # api.add_resource(PermissionsTree, '/permission', '/permission/', '/permission/<path:path>')
 
+        if registry is not None:
+            metrics.register(self, api, registry)
+
         self._print_welcome()
 
     @staticmethod
@@ -134,6 +186,27 @@ class SALServer(Flask):
             if not authentication_provider:
                 raise ValueError('An authentication provider is required if authorisation is required.')
 
+    @staticmethod
+    def _validate_token_cache(auth_token_cache_size, auth_token_cache_ttl):
+        """
+        Validates the token cache settings.
+        """
+
+        if auth_token_cache_size is None or auth_token_cache_size < 0:
+            raise ValueError('Authentication token cache size must be zero or a positive integer.')
+
+        if auth_token_cache_ttl is None or auth_token_cache_ttl < 0:
+            raise ValueError('Authentication token cache ttl must be zero or a positive number of seconds.')
+
+    @staticmethod
+    def _validate_shared_store(shared_store):
+        """
+        Validates the shared store settings.
+        """
+
+        if shared_store is not None and not isinstance(shared_store, SharedStore):
+            raise TypeError('The shared store must be a subclass of SharedStore.')
+
     @staticmethod
     def _validate_admin(admin_enabled, admin_username, admin_password):
         """
@@ -148,6 +221,18 @@ class SALServer(Flask):
             if not admin_password:
                 raise ValueError('Admin account is enabled but no password has been set.')
 
+    @staticmethod
+    def _token_cache(size, ttl, shared_store, secret):
+        """
+        Returns the verified token cache or None if disabled.
+
+        Verified tokens are only shared if a token secret is available to authenticate the shared entries.
+        """
+
+        if not size:
+            return None
+        return TokenCache(size, ttl, shared_store if secret else None, secret)
+
     def _print_welcome(self):
         """
         Displays the server welcome text.
@@ -158,6 +243,7 @@ class SALServer(Flask):
         authentication = cfg['AUTHENTICATION']
         authorisation = cfg['AUTHORISATION']
         admin_enabled = cfg['ADMIN_USER_ENABLED']
+        shared_store = cfg['SHARED_STORE']
 
         s = '\nSimple Access Layer (SAL) Server v{}\n' \
             '{}\n\n' \
@@ -166,6 +252,7 @@ class SALServer(Flask):
             ' * Persistence handler: {}\n' \
             ' * Authentication handler: {}\n' \
             ' * Authorisation handler: {}\n' \
+            ' * Shared store: {}\n' \
             ' * Administration user account: {}{}\n'
 
         underline = '-' * (34 + len(RELEASE_VERSION))
@@ -182,6 +269,11 @@ class SALServer(Flask):
         else:
             authorisation_name = 'None'
 
+        if shared_store:
+            shared_store_name = '{} (v{})'.format(shared_store.NAME, shared_store.VERSION)
+        else:
+            shared_store_name = 'None'
+
         if admin_enabled:
             admin_user_state = 'Enabled'
             admin_user_warn = ' - WARNING!'
@@ -191,12 +283,15 @@ class SALServer(Flask):
 
         print(s.format(
             RELEASE_VERSION, underline, API_VERSION,
-            persistence_name, authentication_name, authorisation_name,
+            persistence_name, authentication_name, authorisation_name, shared_store_name,
             admin_user_state, admin_user_warn
         ))
 
     def __call__(self, environ, start_response):
 
+        if self.config['SAL']['METRICS'] is not None:
+            metrics.mark_start(environ)
+
         # reverse proxy handling
         script_name = environ.get('HTTP_X_SCRIPT_NAME', '')
         if script_name and script_name != '/':
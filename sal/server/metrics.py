@@ -0,0 +1,308 @@
+import time
+import threading
+from contextlib import contextmanager
+from functools import wraps
+
+from flask import g, request, current_app, has_request_context
+from flask_restful.representations.json import output_json
+
+from sal.server.proxy import ProviderProxy
+
+"""
+Request metrics for the SAL server.
+
+The server records the duration of each request, the time spent in each
+phase of the request (argument parsing, persistence provider, serialisation
+and encoding), the time spent in each persistence provider operation and
+the request and response payload sizes. The metrics are reported in the
+Prometheus text exposition format by the /metrics endpoint.
+
+Metrics are held per process, each worker of a multi-process deployment
+reports its own metrics. Metrics are disabled by default, the /metrics
+endpoint is not authenticated.
+"""
+
+# histogram bucket upper bounds in seconds
+DEFAULT_BUCKETS = (0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0)
+
+# content type of the metrics report
+CONTENT_TYPE = 'text/plain; version=0.0.4; charset=utf-8'
+
+# persistence provider operations timed by InstrumentedPersistence
+PROVIDER_OPERATIONS = ('list', 'list_tree', 'get', 'get_many', 'get_selection', 'get_versioned', 'put', 'put_stream', 'put_many', 'copy', 'delete')
+
+# WSGI environment key holding the time the request was received
+_ENVIRON_START = 'sal.request_start'
+
+# metric descriptions: name -> (type, help)
+_METRICS = {
+    'sal_request_seconds': ('histogram', 'Request duration by endpoint, method and status.'),
+    'sal_request_phase_seconds': ('histogram', 'Time spent in each phase of a request.'),
+    'sal_provider_seconds': ('histogram', 'Persistence provider operation duration.'),
+    'sal_provider_errors_total': ('counter', 'Persistence provider operations that raised an exception.'),
+    'sal_request_bytes_total': ('counter', 'Request payload bytes received.'),
+    'sal_response_bytes_total': ('counter', 'Response payload bytes sent, excluding streamed responses.'),
+}
+
+
+class Metrics:
+    """
+    A thread-safe registry of request metrics.
+
+    Histograms and counters are identified by a metric name and a tuple of
+    (label, value) pairs. The set of label values should be bounded, for
+    instance endpoint names rather than request paths.
+
+    :param buckets: The histogram bucket upper bounds in seconds (default=DEFAULT_BUCKETS).
+    """
+
+    def __init__(self, buckets=DEFAULT_BUCKETS):
+
+        self.buckets = tuple(sorted(buckets))
+        self._histograms = {}
+        self._counters = {}
+        self._lock = threading.Lock()
+
+    def observe(self, name, labels, value):
+        """
+        Adds a value to a histogram.
+
+        :param name: The metric name.
+        :param labels: A tuple of (label, value) pairs.
+        :param value: The observed value.
+        """
+
+        with self._lock:
+            histogram = self._histograms.setdefault(name, {}).get(labels)
+            if histogram is None:
+                histogram = self._histograms[name][labels] = [[0] * len(self.buckets), 0, 0.0]
+
+            counts = histogram[0]
+            for index, bound in enumerate(self.buckets):
+                if value <= bound:
+                    counts[index] += 1
+                    break
+            histogram[1] += 1
+            histogram[2] += value
+
+    def increment(self, name, labels, amount=1):
+        """
+        Increments a counter.
+
+        :param name: The metric name.
+        :param labels: A tuple of (label, value) pairs.
+        :param amount: The increment (default=1).
+        """
+
+        with self._lock:
+            counters = self._counters.setdefault(name, {})
+            counters[labels] = counters.get(labels, 0) + amount
+
+    @contextmanager
+    def timer(self, name, labels):
+        """
+        Context manager that records the duration of the enclosed block in a histogram.
+
+        :param name: The metric name.
+        :param labels: A tuple of (label, value) pairs.
+        """
+
+        start = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.observe(name, labels, time.perf_counter() - start)
+
+    def render(self):
+        """
+        Returns the metrics in the Prometheus text exposition format.
+
+        :return: The metrics report string.
+        """
+
+        with self._lock:
+            histograms = {name: {labels: (list(h[0]), h[1], h[2]) for labels, h in series.items()} for name, series in self._histograms.items()}
+            counters = {name: dict(series) for name, series in self._counters.items()}
+
+        lines = []
+        for name, (kind, description) in _METRICS.items():
+            lines.append('# HELP {} {}'.format(name, description))
+            lines.append('# TYPE {} {}'.format(name, kind))
+
+            if kind == 'histogram':
+                for labels, (counts, count, total) in sorted(histograms.get(name, {}).items()):
+                    cumulative = 0
+                    for bound, bucket in zip(self.buckets, counts):
+                        cumulative += bucket
+                        lines.append('{}_bucket{} {}'.format(name, _labels(labels + (('le', repr(float(bound))),)), cumulative))
+                    lines.append('{}_bucket{} {}'.format(name, _labels(labels + (('le', '+Inf'),)), count))
+                    lines.append('{}_sum{} {!r}'.format(name, _labels(labels), total))
+                    lines.append('{}_count{} {}'.format(name, _labels(labels), count))
+            else:
+                for labels, value in sorted(counters.get(name, {}).items()):
+                    lines.append('{}{} {}'.format(name, _labels(labels), value))
+
+        return '\n'.join(lines) + '\n'
+
+
+@contextmanager
+def phase(name):
+    """
+    Context manager that records the time spent in a phase of the current request.
+
+    Does nothing if metrics are disabled or there is no active request.
+
+    :param name: The phase name e.g. 'serialise'.
+    """
+
+    metrics = _current_metrics()
+    if metrics is None:
+        yield
+        return
+
+    with metrics.timer('sal_request_phase_seconds', (('endpoint', _endpoint()), ('phase', name))):
+        yield
+
+
+class InstrumentedPersistence(ProviderProxy):
+    """
+    A persistence provider proxy that records the duration of the provider operations.
+
+    The operations listed in PROVIDER_OPERATIONS are timed, all other
+    attributes are those of the provider. Operations that raise an exception
+    are also counted by exception name. The provider itself is not modified.
+
+    Only the outermost operation is recorded if an operation calls back into
+    the proxy from the same thread, so the time of a call is never counted
+    twice.
+
+    :param provider: A PersistenceProvider instance.
+    :param metrics: A Metrics instance.
+    """
+
+    def __init__(self, provider, metrics):
+
+        super().__init__(provider)
+        self.metrics = metrics
+        self._local = threading.local()
+
+        for operation in PROVIDER_OPERATIONS:
+            method = getattr(provider, operation, None)
+            if method is not None:
+                setattr(self, operation, self._timed(method, operation))
+
+    def _timed(self, method, operation):
+        """
+        Wraps a provider method to record its duration.
+        """
+
+        labels = (('operation', operation),)
+
+        @wraps(method)
+        def wrapper(*args, **kwargs):
+
+            # nested operations are part of the enclosing operation
+            if getattr(self._local, 'active', False):
+                return method(*args, **kwargs)
+
+            self._local.active = True
+            try:
+                with self.metrics.timer('sal_provider_seconds', labels):
+                    return method(*args, **kwargs)
+            except Exception as e:
+                self.metrics.increment('sal_provider_errors_total', labels + (('exception', e.__class__.__name__),))
+                raise
+            finally:
+                self._local.active = False
+
+        return wrapper
+
+
+def instrument(provider, metrics):
+    """
+    Records the duration of the persistence provider operations.
+
+    :param provider: A PersistenceProvider instance.
+    :param metrics: A Metrics instance.
+    :return: An InstrumentedPersistence proxy of the provider.
+    """
+
+    return InstrumentedPersistence(provider, metrics)
+
+
+def register(app, api, metrics):
+    """
+    Adds the request timing hooks to the server application.
+
+    The duration of each request is measured from the time the request is
+    received by the server application, so includes request routing. The
+    JSON response representation is replaced by one that times encoding.
+
+    :param app: The SALServer instance.
+    :param api: The flask_restful Api instance.
+    :param metrics: A Metrics instance.
+    """
+
+    @app.before_request
+    def start_request():
+        g.sal_request_start = request.environ.get(_ENVIRON_START, time.perf_counter())
+        metrics.observe('sal_request_phase_seconds', (('endpoint', _endpoint()), ('phase', 'dispatch')), time.perf_counter() - g.sal_request_start)
+
+    @app.after_request
+    def end_request(response):
+        endpoint = _endpoint()
+        start = g.get('sal_request_start')
+        if start is not None:
+            labels = (('endpoint', endpoint), ('method', request.method), ('status', str(response.status_code)))
+            metrics.observe('sal_request_seconds', labels, time.perf_counter() - start)
+
+        if request.content_length:
+            metrics.increment('sal_request_bytes_total', (('endpoint', endpoint),), request.content_length)
+
+        if not response.is_streamed and response.content_length:
+            metrics.increment('sal_response_bytes_total', (('endpoint', endpoint),), response.content_length)
+        return response
+
+    @api.representation('application/json')
+    def timed_output_json(data, code, headers=None):
+        with phase('encode'):
+            return output_json(data, code, headers)
+
+
+def mark_start(environ):
+    """
+    Records the time a request was received in the WSGI environment.
+
+    :param environ: The WSGI environment dictionary.
+    """
+
+    environ[_ENVIRON_START] = time.perf_counter()
+
+
+def _current_metrics():
+    """
+    Returns the metrics registry of the active request or None.
+    """
+
+    if not has_request_context():
+        return None
+    return current_app.config['SAL'].get('METRICS')
+
+
+def _endpoint():
+    """
+    Returns the endpoint name of the active request.
+    """
+
+    return request.endpoint or 'unmatched'
+
+
+def _labels(labels):
+    """
+    Formats a label set.
+    """
+
+    if not labels:
+        return ''
+    items = ('{}="{}"'.format(key, str(value).replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')) for key, value in labels)
+    return '{' + ','.join(items) + '}'
@@ -1 +1,14 @@
-from .ldap import LDAPAuthenticator, LDAPAuthoriser
+from .filesystem import FilesystemPersistence
+from .memory import MemoryPersistence, CachedPersistence, MemoryStore
+
+# the LDAP providers require the optional ldap3 package
+try:
+    from .ldap import LDAPAuthenticator, LDAPAuthoriser
+except ImportError:
+    pass
+
+# the redis store requires the optional redis package
+try:
+    from .redis import RedisStore
+except ImportError:
+    pass
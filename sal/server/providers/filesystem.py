@@ -0,0 +1,749 @@
+import os
+import json
+import mmap
+import fcntl
+import hashlib
+import tempfile
+import threading
+from contextlib import contextmanager
+
+import numpy as np
+
+from sal.core.exception import InvalidPath, NodeNotFound, InvalidRequest, InternalError, SALException
+from sal.core.object import Branch, DataObject, BranchReport, LeafReport, ObjectReport
+from sal.core.path import decompose
+from sal.core.serialise import serialise, deserialise
+from sal.core.time import new_timestamp, encode_timestamp
+from sal.server.interface import PersistenceProvider
+
+"""
+Filesystem Persistence Provider
+
+Stores a fully revisioned data tree in a directory on a local or shared
+filesystem. The directory is laid out as follows:
+
+    <root>/revision         the head revision number of the tree
+    <root>/lock             lock file used to serialise writes
+    <root>/journal          the node directories modified by an uncommitted revision
+    <root>/staging/         partially written blobs
+    <root>/blobs/           the content addressed blob store
+    <root>/tree/            the root node directory
+
+Each node directory contains:
+
+    history.json            the node history, one entry per revision in which the node was modified
+    children/<name>/        the child node directories
+
+The revision number is a global property of the tree, every write operation
+creates a new revision. Nodes are never removed from storage, deleting a node
+appends a deletion entry to the node history so earlier revisions remain
+available.
+
+Data objects are held in a content addressed blob store. Each array buffer
+of a serialised object (see sal.core.serialise) is stored as a blob named by
+the SHA-256 hash of its content. The object document, listing the hashes of
+its buffers, is stored as a manifest blob referenced by the leaf history
+entry. The summary of each object is generated when the object is written
+and stored as a separate blob, so summary requests do not load the object.
+Identical arrays are therefore stored once, however many objects,
+revisions or copies hold them. Re-writing an object with unchanged arrays
+only stores the changed arrays and a copy of a subtree only duplicates the
+node history entries, no data is copied. Blobs are immutable, so copies
+never affect one another. Blobs are never removed as the full history of the
+tree is retained.
+
+Objects are read by memory mapping the array blobs, the decoded arrays are
+views of the mapped files so array data is only read from storage when
+accessed.
+
+Write operations hold an exclusive lock on the tree, reads do not require a
+lock. Files are replaced atomically so readers never see partial writes.
+Each node directory is recorded in the journal before its history is
+modified, the journal is removed once the head revision is written. If a
+writer dies before the head revision is written, the next writer removes the
+history entries newer than the head from the journaled nodes. Readers ignore
+history entries newer than the head.
+Blobs are written before the lock is acquired, so large writes do not block
+other writers.
+"""
+
+# node entry types recorded in the node history
+_BRANCH = 'branch'
+_LEAF = 'leaf'
+_DELETED = 'deleted'
+
+_HISTORY_FILE = 'history.json'
+_CHILDREN_DIR = 'children'
+
+# chunk size used when hashing and writing streamed buffers
+_STREAM_CHUNK_SIZE = 8 * 1024 * 1024
+
+
+class FilesystemPersistence(PersistenceProvider):
+    """
+    A persistence provider that stores the data tree on a filesystem.
+
+    The tree is created in the supplied directory if it does not already
+    exist. The SAL server may be run with multiple processes and threads
+    sharing the same directory, provided the filesystem supports POSIX
+    advisory locks.
+
+    :param path: The data tree directory.
+    :param description: The root node description used when creating a new tree (default='Root').
+    """
+
+    NAME = 'Filesystem Persistence'
+    VERSION = '1.0.0'
+
+    def __init__(self, path, description='Root'):
+
+        self.path = os.path.abspath(path)
+        self._revision_file = os.path.join(self.path, 'revision')
+        self._lock_file = os.path.join(self.path, 'lock')
+        self._journal_file = os.path.join(self.path, 'journal')
+        self._staging = os.path.join(self.path, 'staging')
+        self._blobs = os.path.join(self.path, 'blobs')
+        self._tree = os.path.join(self.path, 'tree')
+
+        # serialises writes between threads, the lock file serialises writes between processes
+        self._thread_lock = threading.Lock()
+
+        os.makedirs(self._staging, exist_ok=True)
+        os.makedirs(self._blobs, exist_ok=True)
+        os.makedirs(self._tree, exist_ok=True)
+
+        # initialise an empty tree with a root branch in revision 1
+        with self._lock():
+            if not os.path.exists(self._revision_file):
+                self._append(self._tree, self._branch_entry(1, Branch(description)))
+                self._write_head(1)
+
+    def list(self, path, group=None):
+
+        segments, revision = self._resolve(path)
+        head = self._head()
+
+        directory = self._node_dir(segments)
+        history = self._history(directory)
+        entry = self._node(history, revision)
+        modified = [item['revision'] for item in history if item['type'] != _DELETED and item['revision'] <= head]
+
+        if entry['type'] == _LEAF:
+            obj = entry['object']
+            return LeafReport(
+                entry['description'], obj['class'], obj['group'], obj['version'], entry['timestamp'],
+                revision_current=revision, revision_latest=head, revision_modified=modified
+            )
+
+        branches = []
+        leaves = []
+        for name, child in self._children(directory, revision):
+            if child['type'] == _BRANCH:
+                branches.append(name)
+            else:
+                obj = child['object']
+                leaves.append((name, ObjectReport(obj['class'], obj['group'], obj['version'])))
+
+        return BranchReport(
+            entry['description'], branches, leaves, entry['timestamp'],
+            revision_current=revision, revision_latest=head, revision_modified=modified
+        )
+
+    def list_tree(self, path, depth=None, group=None):
+
+        # resolve the revision once so the subtree is described at a single revision
+        segments, revision = self._resolve(path)
+        return super().list_tree(self._format_path(segments, revision), depth, group)
+
+    def get(self, path, summary=False, group=None):
+
+        segments, revision = self._resolve(path)
+
+        directory = self._node_dir(segments)
+        entry = self._node(self._history(directory), revision)
+        return self._read(entry, summary)
+
+    def get_versioned(self, path, summary=False, selection=None, group=None):
+
+        # the head and node history are read once for both the object and its revisions
+        segments, revision = self._resolve(path)
+
+        history = self._history(self._node_dir(segments))
+        entry = self._node(history, revision)
+        modified = self._last_modified([item['revision'] for item in history if item['type'] != _DELETED], revision)
+
+        obj = self._read(entry, summary and selection is None)
+        if selection is not None:
+            obj = self._select(obj, selection)
+        return obj, revision, modified
+
+    def _read(self, entry, summary):
+        """
+        Returns the object held by a node history entry.
+        """
+
+        if entry['type'] == _BRANCH:
+            return Branch(entry['description'])
+
+        # the stored summary avoids loading the object, entries written by earlier versions have no summary
+        if summary and 'summary' in entry:
+            return self._load_summary(entry['summary'])
+
+        obj = self._load(entry['manifest'])
+        return obj.summary() if summary else obj
+
+    def put(self, path, content, group=None):
+        self._commit([self._prepare(path, content)])
+
+    def put_many(self, items, group=None):
+        """
+        Creates/updates the nodes of a list of (path, content) items in order.
+
+        The array data of all the items is written to the blob store before
+        the tree is locked, the nodes are then written in a single revision.
+        If any item fails, the node history entries already written are
+        removed and the head revision is unchanged. Unreferenced blobs are
+        harmless, they are reused if the same data is written again.
+        """
+
+        self._commit([self._prepare(path, content) for path, content in items])
+
+    def put_stream(self, path, stream, group=None):
+        """
+        Creates/updates node data at the specific path from a binary stream.
+
+        The array buffers are written to the blob store as they are received.
+        The stored object is then memory mapped and validated before the node
+        is updated. Compressed arrays are stored compressed.
+        """
+
+        segments = self._writable(path)
+
+        # branches carry no array data
+        if stream.document.get('type') == 'branch':
+            return super().put_stream(path, stream, group)
+
+        hashes = [self._store_stream(reader) for reader in stream.buffers()]
+        manifest = self._store_manifest(stream.document, hashes)
+        try:
+            obj = self._load(manifest)
+        except SALException:
+            raise InvalidRequest('Could not de-serialise content.')
+
+        if not isinstance(obj, DataObject):
+            raise InvalidRequest('Content does not describe a Branch or DataObject.')
+
+        self._commit([(segments, obj, (manifest, self._store_summary(obj)))])
+
+    def delete(self, path, group=None):
+
+        segments = self._writable(path)
+        if not segments:
+            raise InvalidRequest('The root node cannot be deleted.')
+
+        with self._transaction() as (revision, journal):
+            head = revision - 1
+            directory = self._node_dir(segments)
+            self._node(self._history(directory), head)
+            self._delete_subtree(directory, head, revision, journal)
+
+    def copy(self, target, source, group=None):
+
+        target_segments = self._writable(target)
+        if not target_segments:
+            raise InvalidRequest('The root node cannot be replaced by a copy.')
+
+        with self._transaction() as (revision, journal):
+            head = revision - 1
+            source_segments, source_revision = self._resolve(source, head)
+            source_directory = self._node_dir(source_segments)
+            self._node(self._history(source_directory), source_revision)
+            self._check_parent(target_segments, head)
+
+            # snapshot the source before modifying the target, the target may lie inside the source subtree
+            nodes = list(self._walk(source_directory, source_revision))
+
+            target_directory = self._node_dir(target_segments)
+            if self._state(self._history(target_directory), head):
+                self._delete_subtree(target_directory, head, revision, journal)
+
+            # leaf entries reference immutable blobs, only the node history is copied
+            for relative, _, entry in nodes:
+                destination = os.path.join(target_directory, *[os.path.join(_CHILDREN_DIR, name) for name in relative])
+                self._append(destination, dict(entry, revision=revision, timestamp=encode_timestamp(new_timestamp())), journal)
+
+    def _prepare(self, path, content):
+        """
+        Validates a write and stores any array data.
+
+        Returns a (segments, content, stored) tuple, stored is None for
+        branches and a (manifest hash, summary hash) tuple for data objects.
+        """
+
+        segments = self._writable(path)
+
+        if isinstance(content, Branch):
+            return segments, content, None
+
+        if isinstance(content, DataObject):
+            buffers = []
+            document = serialise(content, buffers)
+            hashes = [self._store_blob(buffer) for buffer in buffers]
+            return segments, content, (self._store_manifest(document, hashes), self._store_summary(content))
+
+        raise InvalidRequest('Content must be a Branch or DataObject.')
+
+    def _commit(self, writes):
+        """
+        Writes a list of prepared nodes (see _prepare()) in a new revision.
+        """
+
+        if not writes:
+            return
+
+        with self._transaction() as (revision, journal):
+            for segments, content, stored in writes:
+                if stored is None:
+                    self._write_branch(segments, content, revision, journal)
+                else:
+                    self._write_leaf(segments, content, stored[0], stored[1], revision, journal)
+
+    @contextmanager
+    def _transaction(self):
+        """
+        Acquires the tree write lock, yields the pending revision number and the journal.
+
+        The revision becomes visible to readers as a whole once the block
+        completes. If the block raises, the entries written in the revision
+        are removed and the head revision is unchanged. Entries left by a
+        writer that died before writing the head are removed first.
+        """
+
+        with self._lock():
+            if os.path.exists(self._journal_file):
+                self._rollback(self._head() + 1)
+
+            revision = self._head() + 1
+            journal = open(self._journal_file, 'w')
+            try:
+                with journal:
+                    yield revision, journal
+            except BaseException:
+                self._rollback(revision)
+                raise
+
+            self._write_head(revision)
+            os.remove(self._journal_file)
+
+    def _write_branch(self, segments, branch, revision, journal):
+        """
+        Creates/updates a branch node in a pending revision.
+        """
+
+        self._check_parent(segments, revision)
+
+        # updating a branch leaves the descendants untouched
+        self._append(self._node_dir(segments), self._branch_entry(revision, branch), journal)
+
+    def _write_leaf(self, segments, obj, manifest, summary, revision, journal):
+        """
+        Creates/updates a leaf node in a pending revision from a stored object manifest and summary.
+        """
+
+        self._check_parent(segments, revision)
+
+        if not segments:
+            raise InvalidRequest('The root node must be a branch.')
+
+        # a leaf replacing a branch removes the branch descendants
+        directory = self._node_dir(segments)
+        existing = self._state(self._history(directory), revision)
+        if existing and existing['type'] == _BRANCH:
+            self._delete_subtree(directory, revision, revision, journal)
+
+        self._append(directory, {
+            'revision': revision,
+            'type': _LEAF,
+            'timestamp': encode_timestamp(new_timestamp()),
+            'description': obj.description,
+            'object': {'class': obj.CLASS, 'group': obj.GROUP, 'version': obj.VERSION},
+            'manifest': manifest,
+            'summary': summary
+        }, journal)
+
+    def _rollback(self, revision):
+        """
+        Removes the entries of an abandoned revision from the journaled node histories, then removes the journal.
+        """
+
+        try:
+            with open(self._journal_file, 'r') as f:
+                lines = f.readlines()
+        except OSError:
+            raise InternalError('The tree journal could not be read.')
+
+        # a final line without a newline was being recorded when the writer died, its node is unmodified
+        directories = dict.fromkeys(json.loads(line) for line in lines if line.endswith('\n'))
+
+        for directory in directories:
+            history = self._history(directory)
+            retained = [item for item in history if item['revision'] < revision]
+            if len(retained) != len(history):
+                self._write_atomic(os.path.join(directory, _HISTORY_FILE), json.dumps(retained).encode('utf-8'))
+
+        os.remove(self._journal_file)
+
+    def _delete_subtree(self, directory, head, revision, journal=None):
+        """
+        Records the deletion of a node and all its descendants in the specified revision.
+        """
+
+        for _, node_directory, _ in list(self._walk(directory, head)):
+            self._append(node_directory, {'revision': revision, 'type': _DELETED}, journal)
+
+    def _walk(self, directory, revision, relative=()):
+        """
+        Generates a (relative segments, directory, entry) tuple for a node and its descendants at a revision.
+        """
+
+        entry = self._state(self._history(directory), revision)
+        if not entry:
+            return
+
+        yield list(relative), directory, entry
+        if entry['type'] == _BRANCH:
+            for name, _ in self._children(directory, revision):
+                yield from self._walk(os.path.join(directory, _CHILDREN_DIR, name), revision, relative + (name,))
+
+    def _children(self, directory, revision):
+        """
+        Returns a list of (name, entry) tuples for the child nodes present at a revision.
+        """
+
+        try:
+            names = os.listdir(os.path.join(directory, _CHILDREN_DIR))
+        except FileNotFoundError:
+            return []
+
+        children = []
+        for name in sorted(names):
+            entry = self._state(self._history(os.path.join(directory, _CHILDREN_DIR, name)), revision)
+            if entry:
+                children.append((name, entry))
+        return children
+
+    def _load(self, manifest):
+        """
+        Loads the data object described by a manifest blob.
+
+        The array blobs are memory mapped, uncompressed arrays are views of
+        the mapped files. The mappings are released once the arrays are
+        released.
+        """
+
+        try:
+            with open(self._blob_path(manifest), 'rb') as f:
+                content = json.load(f)
+            buffers = [self._map_blob(item['hash'], item['size']) for item in content['buffers']]
+        except (OSError, ValueError, TypeError, KeyError):
+            raise InternalError('A stored data object could not be read.')
+
+        try:
+            return deserialise(content['document'], buffers)
+        except (ValueError, TypeError, KeyError):
+            raise InternalError('A stored data object is corrupt.')
+
+    def _load_summary(self, digest):
+        """
+        Loads a data summary object from a summary blob.
+        """
+
+        try:
+            with open(self._blob_path(digest), 'rb') as f:
+                document = json.load(f)
+        except (OSError, ValueError):
+            raise InternalError('A stored data summary could not be read.')
+
+        try:
+            return deserialise(document)
+        except (ValueError, TypeError, KeyError):
+            raise InternalError('A stored data summary is corrupt.')
+
+    def _store_summary(self, obj):
+        """
+        Stores the summary of a data object, returns the summary blob hash.
+        """
+
+        document = serialise(obj.summary())
+        return self._store_blob(json.dumps(document, sort_keys=True).encode('utf-8'))[0]
+
+    def _map_blob(self, digest, size):
+        """
+        Returns a read-only memory map of a blob.
+        """
+
+        # zero length files cannot be mapped
+        if not size:
+            return b''
+
+        with open(self._blob_path(digest), 'rb') as f:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(data) != size:
+            raise InternalError('A stored data object is corrupt.')
+        return data
+
+    def _store_manifest(self, document, hashes):
+        """
+        Stores an object manifest, returns the manifest hash.
+
+        The manifest holds the object document and the hash and size of each
+        array buffer referenced by the document.
+        """
+
+        buffers = [{'hash': digest, 'size': size} for digest, size in hashes]
+        content = json.dumps({'document': document, 'buffers': buffers}, sort_keys=True).encode('utf-8')
+        return self._store_blob(content)[0]
+
+    def _store_blob(self, buffer):
+        """
+        Stores a bytes-like object in the blob store, returns a (hash, size) tuple.
+
+        The write is skipped if an identical blob is already stored.
+        """
+
+        view = _byte_view(buffer)
+        digest = hashlib.sha256(view).hexdigest()
+        if not os.path.exists(self._blob_path(digest)):
+            self._publish_blob(digest, self._stage([view]))
+        return digest, view.nbytes
+
+    def _store_stream(self, reader):
+        """
+        Stores a streamed envelope buffer in the blob store, returns a (hash, size) tuple.
+
+        The buffer is hashed as it is written to a staging file, so the
+        buffer is never held in memory.
+        """
+
+        hasher = hashlib.sha256()
+
+        def chunks():
+            for chunk in reader.chunks(_STREAM_CHUNK_SIZE):
+                hasher.update(chunk)
+                yield chunk
+
+        staged = self._stage(chunks())
+        digest = hasher.hexdigest()
+        if os.path.exists(self._blob_path(digest)):
+            os.remove(staged)
+        else:
+            self._publish_blob(digest, staged)
+        return digest, reader.nbytes
+
+    def _publish_blob(self, digest, staged):
+        """
+        Moves a staged file into the blob store.
+
+        Concurrent writers of the same blob write identical content, so the
+        last replacement wins without affecting readers.
+        """
+
+        filename = self._blob_path(digest)
+        os.makedirs(os.path.dirname(filename), exist_ok=True)
+        os.replace(staged, filename)
+
+    def _blob_path(self, digest):
+        """
+        Returns the path of a blob, blobs are spread over sub-directories by hash prefix.
+        """
+
+        return os.path.join(self._blobs, digest[:2], digest)
+
+    def _stage(self, chunks):
+        """
+        Writes a sequence of chunks to a new staging file, returns the file path.
+        """
+
+        handle, staged = tempfile.mkstemp(dir=self._staging)
+        try:
+            with os.fdopen(handle, 'wb') as f:
+                for chunk in chunks:
+                    f.write(chunk)
+        except BaseException:
+            os.remove(staged)
+            raise
+        return staged
+
+    def _writable(self, path):
+        """
+        Validates a path for a write operation, returns the path segments.
+        """
+
+        segments, revision, absolute = decompose(path)
+        if not absolute:
+            raise InvalidPath('The path must be an absolute path.')
+
+        if revision:
+            raise InvalidPath('Data may only be written to the head revision.')
+
+        return segments
+
+    def _resolve(self, path, head=None):
+        """
+        Validates a path for a read operation, returns the path segments and resolved revision.
+        """
+
+        segments, revision, absolute = decompose(path)
+        if not absolute:
+            raise InvalidPath('The path must be an absolute path.')
+
+        head = self._head() if head is None else head
+        if revision > head:
+            raise NodeNotFound('The requested revision does not exist.')
+        return segments, revision or head
+
+    def _check_parent(self, segments, revision):
+        """
+        Checks the parent of a node exists and is a branch.
+        """
+
+        if not segments:
+            return
+
+        entry = self._state(self._history(self._node_dir(segments[:-1])), revision)
+        if not entry or entry['type'] != _BRANCH:
+            raise NodeNotFound('The parent branch of the node does not exist.')
+
+    def _node(self, history, revision):
+        """
+        Returns the node entry at a revision, raises NodeNotFound if the node does not exist.
+        """
+
+        entry = self._state(history, revision)
+        if not entry:
+            raise NodeNotFound
+        return entry
+
+    @staticmethod
+    def _state(history, revision):
+        """
+        Returns the node entry at a revision or None if the node does not exist.
+        """
+
+        for entry in reversed(history):
+            if entry['revision'] <= revision:
+                return None if entry['type'] == _DELETED else entry
+        return None
+
+    def _node_dir(self, segments):
+        """
+        Returns the directory of a node.
+        """
+
+        return os.path.join(self._tree, *[os.path.join(_CHILDREN_DIR, name) for name in segments])
+
+    @staticmethod
+    def _history(directory):
+        """
+        Reads the history of a node, the history is empty if the node has never existed.
+        """
+
+        try:
+            with open(os.path.join(directory, _HISTORY_FILE), 'r') as f:
+                return json.load(f)
+        except FileNotFoundError:
+            return []
+        except (OSError, ValueError):
+            raise InternalError('A node history could not be read.')
+
+    def _append(self, directory, entry, journal=None):
+        """
+        Appends an entry to a node history, an existing entry for the same revision is replaced.
+
+        If a journal is supplied, the node directory is recorded in the
+        journal before the history is modified.
+        """
+
+        if journal is not None:
+            journal.write(json.dumps(directory) + '\n')
+            journal.flush()
+
+        history = self._history(directory)
+        if history and history[-1]['revision'] == entry['revision']:
+            history.pop()
+        history.append(entry)
+
+        os.makedirs(directory, exist_ok=True)
+        self._write_atomic(os.path.join(directory, _HISTORY_FILE), json.dumps(history).encode('utf-8'))
+
+    @staticmethod
+    def _branch_entry(revision, branch):
+        return {
+            'revision': revision,
+            'type': _BRANCH,
+            'timestamp': encode_timestamp(new_timestamp()),
+            'description': branch.description
+        }
+
+    def _head(self):
+        """
+        Returns the head revision of the tree.
+        """
+
+        try:
+            with open(self._revision_file, 'r') as f:
+                return int(f.read())
+        except (OSError, ValueError):
+            raise InternalError('The tree revision could not be read.')
+
+    def _write_head(self, revision):
+        """
+        Sets the head revision, this makes the changes made in the revision visible to readers.
+        """
+
+        self._write_atomic(self._revision_file, str(revision).encode('utf-8'))
+
+    @staticmethod
+    def _write_atomic(filename, data):
+        """
+        Replaces the contents of a file atomically.
+        """
+
+        handle, temporary = tempfile.mkstemp(dir=os.path.dirname(filename), suffix='.tmp')
+        try:
+            with os.fdopen(handle, 'wb') as f:
+                f.write(data)
+            os.replace(temporary, filename)
+        except BaseException:
+            if os.path.exists(temporary):
+                os.remove(temporary)
+            raise
+
+    @contextmanager
+    def _lock(self):
+        """
+        Acquires the exclusive tree write lock.
+        """
+
+        with self._thread_lock:
+            with open(self._lock_file, 'a') as f:
+                fcntl.flock(f, fcntl.LOCK_EX)
+                try:
+                    yield
+                finally:
+                    fcntl.flock(f, fcntl.LOCK_UN)
+
+    @staticmethod
+    def _format_path(segments, revision):
+        return '/{}:{}'.format('/'.join(segments), revision)
+
+
+def _byte_view(buffer):
+    """
+    Returns a flat, unsigned byte memoryview of a buffer without copying.
+    """
+
+    if isinstance(buffer, np.ndarray):
+        return memoryview(buffer.reshape(-1).view(np.uint8))
+    return memoryview(buffer).cast('B')
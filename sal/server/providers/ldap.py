@@ -1,3 +1,6 @@
+import threading
+from collections import deque
+
 from sal.server.interface import AuthenticationProvider, AuthorisationProvider
 
 """
@@ -8,32 +11,114 @@ Requires ldap3 package.
 
 try:
     import ldap3
+    from ldap3.core.exceptions import LDAPException
 except ImportError:
     raise ImportError('Requires ldap3 package version >= 2.5.')
 
 
 class LDAPAuthenticator(AuthenticationProvider):
+    """
+    Authenticates users by binding to an LDAP server with their credentials.
+
+    Connections to the LDAP server are reused between logins, each login
+    rebinds an idle connection as the user. At most pool_size binds are
+    performed concurrently, further logins wait up to timeout seconds for a
+    connection before failing. This limits the load a burst of logins
+    places on the LDAP server.
+
+    :param server: The LDAP server host or URL.
+    :param base_dn: The base DN of the user entries.
+    :param user_attribute: The attribute holding the user name e.g. 'uid'.
+    :param pool_size: The maximum number of concurrent binds and pooled connections (default=8).
+    :param timeout: The time in seconds to wait for a connection (default=10).
+    """
 
     NAME = 'LDAP Authenticator'
-    VERSION = '1.0.0'
+    VERSION = '1.1.0'
+
+    def __init__(self, server, base_dn, user_attribute, pool_size=8, timeout=10):
 
-    def __init__(self, server, base_dn, user_attribute):
+        if pool_size < 1:
+            raise ValueError('The LDAP connection pool size must be at least 1.')
 
         # validate contents to prevent arbitrary execution of LDAP call
         self.server = server
         self.base_dn = base_dn
         self.user_attribute = user_attribute
+        self.pool_size = pool_size
+        self.timeout = timeout
+
+        self._server = ldap3.Server(server, connect_timeout=timeout)
+        self._connections = deque()
+        self._lock = threading.Lock()
+        self._binds = threading.BoundedSemaphore(pool_size)
 
     def authenticate(self, username, password):
 
+        # an empty password requests an unauthenticated bind, which always succeeds
+        if not username or not password:
+            return False
+
         # sanitise username to prevent injection and construct dn filter
         username = ldap3.utils.dn.escape_rdn(username)
         user_dn = '{}={},{}'.format(self.user_attribute, username, self.base_dn)
 
-        # try to connect to the ldap server with the users username/password
-        server = ldap3.Server(self.server)
-        connection = ldap3.Connection(server, user_dn, password, version=3, authentication=ldap3.SIMPLE)
-        return connection.bind()
+        # try to bind to the ldap server with the users username/password
+        if not self._binds.acquire(timeout=self.timeout):
+            return False
+
+        try:
+            connection = self._acquire()
+            try:
+                bound = connection.rebind(user_dn, password, authentication=ldap3.SIMPLE)
+            except LDAPException:
+                # the connection state is unknown, do not return it to the pool
+                self._close(connection)
+                return False
+
+            self._release(connection)
+            return bool(bound)
+
+        finally:
+            self._binds.release()
+
+    def _acquire(self):
+        """
+        Returns an idle pooled connection or opens a new connection.
+        """
+
+        with self._lock:
+            if self._connections:
+                return self._connections.pop()
+
+        connection = ldap3.Connection(self._server, version=3, receive_timeout=self.timeout)
+        connection.open()
+        return connection
+
+    def _release(self, connection):
+        """
+        Returns a connection to the pool.
+        """
+
+        if connection.closed:
+            return
+
+        with self._lock:
+            if len(self._connections) < self.pool_size:
+                self._connections.append(connection)
+                return
+        self._close(connection)
+
+    @staticmethod
+    def _close(connection):
+        """
+        Closes a connection, ignoring errors.
+        """
+
+        try:
+            connection.unbind()
+        except LDAPException:
+            pass
 
 
 class LDAPAuthoriser(AuthorisationProvider):
@@ -42,4 +127,4 @@ class LDAPAuthoriser(AuthorisationProvider):
     VERSION = '1.0.0'
 
     # todo: implement me
-    pass
\ No newline at end of file
+    pass
@@ -0,0 +1,835 @@
+import copy
+import time
+import threading
+from collections import OrderedDict
+
+import numpy as np
+
+from sal.core.exception import InvalidPath, NodeNotFound, InvalidRequest, SALException
+from sal.core.object import Branch, DataObject, BranchReport, LeafReport, ObjectReport
+from sal.core.path import decompose
+from sal.core.serialise import serialise, deserialise, encode_binary, decode_binary
+from sal.core.time import new_timestamp, encode_timestamp
+from sal.server.interface import PersistenceProvider, SharedStore
+
+"""
+In-memory Persistence Providers
+
+MemoryPersistence holds a fully revisioned data tree in memory. It has the
+same behaviour as the filesystem persistence provider and is intended for
+testing, benchmarking and short lived deployments.
+
+CachedPersistence wraps another persistence provider and holds recently
+accessed objects in memory, so repeated requests for the same objects are
+not served by the wrapped provider. A SharedStore may be added as a second
+cache level shared by several server processes.
+
+MemoryStore is a SharedStore held in the memory of a single process. It is
+intended for testing and single process deployments.
+"""
+
+# node entry types recorded in the node history
+_BRANCH = 'branch'
+_LEAF = 'leaf'
+_DELETED = 'deleted'
+
+# default cache size in bytes
+_DEFAULT_CACHE_SIZE = 256 * 1024 * 1024
+
+# size charged for each cached object in addition to its array data
+_ENTRY_OVERHEAD = 1024
+
+# default time in seconds objects are held by a shared store
+_DEFAULT_SHARED_TTL = 3600
+
+# default maximum array size in bytes of the objects placed in a shared store
+_DEFAULT_SHARED_MAX_SIZE = 16 * 1024 * 1024
+
+
+class _Node:
+    """
+    A tree node, holds the node history and the child nodes.
+    """
+
+    __slots__ = ('history', 'children')
+
+    def __init__(self):
+        self.history = []
+        self.children = {}
+
+
+class MemoryPersistence(PersistenceProvider):
+    """
+    A persistence provider that holds a revisioned data tree in memory.
+
+    Each write creates a new tree revision, the full history of the tree is
+    retained. Objects are copied when written and their summaries generated,
+    the objects returned by get() are shared between requests and must not
+    be modified.
+
+    The provider may be shared between threads. The tree is lost when the
+    provider is released.
+
+    :param description: The root node description (default='Root').
+    """
+
+    NAME = 'Memory Persistence'
+    VERSION = '1.0.0'
+
+    def __init__(self, description='Root'):
+
+        self._lock = threading.RLock()
+        self._root = _Node()
+        self._root.history.append(self._branch_entry(1, Branch(description)))
+        self._revision = 1
+
+    def list(self, path, group=None):
+
+        with self._lock:
+            segments, revision = self._resolve(path)
+            node = self._find(segments)
+            entry = self._node(node, revision)
+            modified = [item['revision'] for item in node.history if item['type'] != _DELETED]
+
+            if entry['type'] == _LEAF:
+                obj = entry['object']
+                return LeafReport(
+                    entry['description'], obj.CLASS, obj.GROUP, obj.VERSION, entry['timestamp'],
+                    revision_current=revision, revision_latest=self._revision, revision_modified=modified
+                )
+
+            branches = []
+            leaves = []
+            for name, child in self._children(node, revision):
+                if child['type'] == _BRANCH:
+                    branches.append(name)
+                else:
+                    obj = child['object']
+                    leaves.append((name, ObjectReport(obj.CLASS, obj.GROUP, obj.VERSION)))
+
+            return BranchReport(
+                entry['description'], branches, leaves, entry['timestamp'],
+                revision_current=revision, revision_latest=self._revision, revision_modified=modified
+            )
+
+    def list_tree(self, path, depth=None, group=None):
+
+        # resolve the revision once so the subtree is described at a single revision
+        with self._lock:
+            segments, revision = self._resolve(path)
+        return super().list_tree('/{}:{}'.format('/'.join(segments), revision), depth, group)
+
+    def get(self, path, summary=False, group=None):
+
+        with self._lock:
+            segments, revision = self._resolve(path)
+            entry = self._node(self._find(segments), revision)
+
+        return self._read(entry, summary)
+
+    def get_versioned(self, path, summary=False, selection=None, group=None):
+
+        with self._lock:
+            segments, revision = self._resolve(path)
+            node = self._find(segments)
+            entry = self._node(node, revision)
+            modified = self._last_modified([item['revision'] for item in node.history if item['type'] != _DELETED], revision)
+
+        obj = self._read(entry, summary and selection is None)
+        if selection is not None:
+            obj = self._select(obj, selection)
+        return obj, revision, modified
+
+    @staticmethod
+    def _read(entry, summary):
+        """
+        Returns the object held by a node entry.
+        """
+
+        if entry['type'] == _BRANCH:
+            return Branch(entry['description'])
+
+        return entry['summary'] if summary else entry['object']
+
+    def put(self, path, content, group=None):
+        self._commit([self._prepare(path, content)])
+
+    def put_many(self, items, group=None):
+        """
+        Creates/updates the nodes of a list of (path, content) items in order.
+
+        The items are written in a single revision. If any item fails, the
+        items already written are removed and the head revision is unchanged.
+        """
+
+        self._commit([self._prepare(path, content) for path, content in items])
+
+    def _commit(self, writes):
+        """
+        Writes a list of prepared nodes (see _prepare()) in a new revision.
+        """
+
+        if not writes:
+            return
+
+        with self._lock:
+            revision = self._revision + 1
+            journal = []
+            try:
+                for segments, content in writes:
+                    self._write(segments, content, revision, journal)
+            except BaseException:
+                self._rollback(journal, revision)
+                raise
+            self._revision = revision
+
+    def _prepare(self, path, content):
+        """
+        Validates a write, returns the path segments and the content to store.
+        """
+
+        segments = self._writable(path)
+
+        if isinstance(content, Branch):
+            return segments, content
+
+        if isinstance(content, DataObject):
+            if not segments:
+                raise InvalidRequest('The root node must be a branch.')
+
+            # the stored object must not change if the caller modifies the supplied object
+            return segments, copy.deepcopy(content)
+
+        raise InvalidRequest('Content must be a Branch or DataObject.')
+
+    def _write(self, segments, content, revision, journal):
+        """
+        Writes a branch or leaf node in a pending revision.
+
+        The node state includes the changes already made in the pending
+        revision. The nodes modified are added to the journal.
+        """
+
+        self._check_parent(segments, revision)
+        node = self._find(segments, create=True)
+
+        if isinstance(content, Branch):
+            self._append(node, self._branch_entry(revision, content), journal)
+            return
+
+        # a leaf replacing a branch removes the branch descendants
+        existing = self._state(node, revision)
+        if existing and existing['type'] == _BRANCH:
+            self._delete_subtree(node, revision, revision, journal)
+
+        self._append(node, {
+            'revision': revision,
+            'type': _LEAF,
+            'timestamp': encode_timestamp(new_timestamp()),
+            'description': content.description,
+            'object': content,
+            'summary': content.summary()
+        }, journal)
+
+    @staticmethod
+    def _rollback(journal, revision):
+        """
+        Removes the entries of an abandoned revision from the journaled nodes.
+        """
+
+        for node in journal:
+            if node.history and node.history[-1]['revision'] == revision:
+                node.history.pop()
+
+    def delete(self, path, group=None):
+
+        segments = self._writable(path)
+        if not segments:
+            raise InvalidRequest('The root node cannot be deleted.')
+
+        with self._lock:
+            head = self._revision
+            revision = head + 1
+            journal = []
+            try:
+                node = self._find(segments)
+                self._node(node, head)
+                self._delete_subtree(node, head, revision, journal)
+            except BaseException:
+                self._rollback(journal, revision)
+                raise
+            self._revision = revision
+
+    def copy(self, target, source, group=None):
+
+        target_segments = self._writable(target)
+        if not target_segments:
+            raise InvalidRequest('The root node cannot be replaced by a copy.')
+
+        with self._lock:
+            head = self._revision
+            revision = head + 1
+            journal = []
+            try:
+                source_segments, source_revision = self._resolve(source)
+                source_node = self._find(source_segments)
+                self._node(source_node, source_revision)
+                self._check_parent(target_segments, head)
+
+                # snapshot the source before modifying the target, the target may lie inside the source subtree
+                nodes = list(self._walk(source_node, source_revision))
+
+                target_node = self._find(target_segments, create=True)
+                if self._state(target_node, head):
+                    self._delete_subtree(target_node, head, revision, journal)
+
+                # stored objects are never modified, so copies share them
+                for relative, _, entry in nodes:
+                    node = target_node
+                    for name in relative:
+                        node = node.children.setdefault(name, _Node())
+                    self._append(node, dict(entry, revision=revision, timestamp=encode_timestamp(new_timestamp())), journal)
+            except BaseException:
+                self._rollback(journal, revision)
+                raise
+            self._revision = revision
+
+    def _delete_subtree(self, node, head, revision, journal=None):
+        """
+        Records the deletion of a node and all its descendants in the specified revision.
+        """
+
+        for _, descendant, _ in list(self._walk(node, head)):
+            self._append(descendant, {'revision': revision, 'type': _DELETED}, journal)
+
+    def _walk(self, node, revision, relative=()):
+        """
+        Generates a (relative segments, node, entry) tuple for a node and its descendants at a revision.
+        """
+
+        entry = self._state(node, revision)
+        if not entry:
+            return
+
+        yield list(relative), node, entry
+        if entry['type'] == _BRANCH:
+            for name in sorted(node.children):
+                yield from self._walk(node.children[name], revision, relative + (name,))
+
+    def _children(self, node, revision):
+        """
+        Returns a list of (name, entry) tuples for the child nodes present at a revision.
+        """
+
+        children = []
+        for name in sorted(node.children):
+            entry = self._state(node.children[name], revision)
+            if entry:
+                children.append((name, entry))
+        return children
+
+    def _find(self, segments, create=False):
+        """
+        Returns the node for a path, nodes that have never existed are created if requested.
+        """
+
+        node = self._root
+        for name in segments:
+            child = node.children.get(name)
+            if child is None:
+                if not create:
+                    raise NodeNotFound
+                child = node.children[name] = _Node()
+            node = child
+        return node
+
+    @staticmethod
+    def _writable(path):
+        """
+        Validates a path for a write operation, returns the path segments.
+        """
+
+        segments, revision, absolute = decompose(path)
+        if not absolute:
+            raise InvalidPath('The path must be an absolute path.')
+
+        if revision:
+            raise InvalidPath('Data may only be written to the head revision.')
+
+        return segments
+
+    def _resolve(self, path):
+        """
+        Validates a path for a read operation, returns the path segments and resolved revision.
+        """
+
+        segments, revision, absolute = decompose(path)
+        if not absolute:
+            raise InvalidPath('The path must be an absolute path.')
+
+        if revision > self._revision:
+            raise NodeNotFound('The requested revision does not exist.')
+        return segments, revision or self._revision
+
+    def _check_parent(self, segments, revision):
+        """
+        Checks the parent of a node exists and is a branch.
+        """
+
+        if not segments:
+            return
+
+        try:
+            entry = self._state(self._find(segments[:-1]), revision)
+        except NodeNotFound:
+            entry = None
+
+        if not entry or entry['type'] != _BRANCH:
+            raise NodeNotFound('The parent branch of the node does not exist.')
+
+    def _node(self, node, revision):
+        """
+        Returns the node entry at a revision, raises NodeNotFound if the node does not exist.
+        """
+
+        entry = self._state(node, revision)
+        if not entry:
+            raise NodeNotFound
+        return entry
+
+    @staticmethod
+    def _state(node, revision):
+        """
+        Returns the node entry at a revision or None if the node does not exist.
+        """
+
+        for entry in reversed(node.history):
+            if entry['revision'] <= revision:
+                return None if entry['type'] == _DELETED else entry
+        return None
+
+    @staticmethod
+    def _append(node, entry, journal=None):
+        """
+        Appends an entry to a node history, an existing entry for the same revision is replaced.
+
+        If a journal list is supplied, the node is added to the journal.
+        """
+
+        if node.history and node.history[-1]['revision'] == entry['revision']:
+            node.history.pop()
+        node.history.append(entry)
+
+        if journal is not None:
+            journal.append(node)
+
+    @staticmethod
+    def _branch_entry(revision, branch):
+        return {
+            'revision': revision,
+            'type': _BRANCH,
+            'timestamp': encode_timestamp(new_timestamp()),
+            'description': branch.description
+        }
+
+
+class CachedPersistence(PersistenceProvider):
+    """
+    A read-through memory cache in front of another persistence provider.
+
+    The objects returned by get() and get_many() are held in a least
+    recently used cache. The cache size is limited by the total size of the
+    array data held by the cached objects. Objects larger than the cache are
+    not cached. Data selections of cached objects are performed in memory.
+
+    Objects requested at an explicit revision never change, so remain cached
+    until evicted. Objects requested at the head revision are discarded when
+    the node, or an ancestor of the node, is modified via this provider. If
+    other processes write to the wrapped provider, for instance several
+    server processes sharing a filesystem tree, head_ttl should be set to
+    limit the time a head revision object is served after it has been
+    replaced. The SAL server data and batch endpoints resolve the head
+    revision before requesting objects, so are not affected.
+
+    The objects returned by get() are shared between requests and must not
+    be modified.
+
+    If a SharedStore is supplied, objects requested at an explicit revision
+    are also held in the shared store, serialised as binary envelopes, so
+    an object read by one server process is available to every process
+    sharing the store. As these objects never change, the shared store
+    requires no invalidation. Objects with more than shared_max_size bytes
+    of array data are not placed in the shared store, they are typically
+    cheaper to read from the wrapped provider than to transfer.
+
+    :param provider: The wrapped PersistenceProvider instance.
+    :param size: The maximum total array size of the cached objects in bytes (default=256MB).
+    :param head_ttl: The maximum age in seconds of cached head revision objects or None for no limit (default=None).
+    :param shared: A SharedStore instance or None (default=None).
+    :param shared_ttl: The time in seconds objects are held by the shared store (default=3600).
+    :param shared_max_size: The maximum array size in bytes of the objects placed in the shared store (default=16MB).
+    """
+
+    NAME = 'Cached Persistence'
+    VERSION = '1.0.0'
+
+    def __init__(self, provider, size=_DEFAULT_CACHE_SIZE, head_ttl=None, shared=None,
+                 shared_ttl=_DEFAULT_SHARED_TTL, shared_max_size=_DEFAULT_SHARED_MAX_SIZE):
+
+        if not isinstance(provider, PersistenceProvider):
+            raise TypeError('The wrapped provider must be a subclass of PersistenceProvider.')
+
+        if shared is not None and not isinstance(shared, SharedStore):
+            raise TypeError('The shared store must be a subclass of SharedStore.')
+
+        if size < 0:
+            raise ValueError('The cache size cannot be negative.')
+
+        self.provider = provider
+        self.size = size
+        self.head_ttl = head_ttl
+        self.shared = shared
+        self.shared_ttl = shared_ttl
+        self.shared_max_size = shared_max_size
+        self.NAME = '{} ({})'.format(self.NAME, provider.NAME)
+
+        # entries are keyed by (segments, revision, summary), values are (object, size, time) tuples
+        self._items = OrderedDict()
+        self._used = 0
+        self._lock = threading.Lock()
+
+        # incremented on every write, objects read before a write are not cached after it
+        self._generation = 0
+
+        self.hits = 0
+        self.misses = 0
+
+    def list(self, path, group=None):
+        return self.provider.list(path, group)
+
+    def list_tree(self, path, depth=None, group=None):
+        return self.provider.list_tree(path, depth, group)
+
+    def get(self, path, summary=False, group=None):
+
+        key = self._key(path, summary)
+        obj = self._lookup(key)
+        if obj is not None:
+            return obj
+
+        generation = self._generation
+        obj = self._shared_lookup([key])[0]
+        if obj is None:
+            obj = self.provider.get(path, summary, group)
+            self._shared_store(key, obj)
+        self._store(key, obj, generation)
+        return obj
+
+    def get_many(self, paths, summary=False, group=None):
+
+        results = [None] * len(paths)
+        missing = []
+        for index, path in enumerate(paths):
+            try:
+                key = self._key(path, summary)
+            except SALException as e:
+                results[index] = e
+                continue
+
+            obj = self._lookup(key)
+            if obj is None:
+                missing.append((index, path, key))
+            else:
+                results[index] = obj
+
+        # consult the shared store, then obtain the remaining objects in a single request
+        if missing:
+            generation = self._generation
+            for item, obj in zip(list(missing), self._shared_lookup([key for _, _, key in missing])):
+                if obj is not None:
+                    index, _, key = item
+                    results[index] = obj
+                    self._store(key, obj, generation)
+                    missing.remove(item)
+
+        if missing:
+            objects = self.provider.get_many([path for _, path, _ in missing], summary, group)
+            for (index, _, key), obj in zip(missing, objects):
+                results[index] = obj
+                if not isinstance(obj, Exception):
+                    self._shared_store(key, obj)
+                    self._store(key, obj, generation)
+
+        return results
+
+    def get_selection(self, path, selection, group=None):
+
+        # select from the cached object, otherwise the wrapped provider may read only the selected data
+        if self._lookup(self._key(path, False)) is not None:
+            return super().get_selection(path, selection, group)
+        return self.provider.get_selection(path, selection, group)
+
+    def put(self, path, content, group=None):
+        try:
+            self.provider.put(path, content, group)
+        finally:
+            self._invalidate(path)
+
+    def put_stream(self, path, stream, group=None):
+        try:
+            self.provider.put_stream(path, stream, group)
+        finally:
+            self._invalidate(path)
+
+    def put_many(self, items, group=None):
+        items = list(items)
+        try:
+            self.provider.put_many(items, group)
+        finally:
+            for path, _ in items:
+                self._invalidate(path)
+
+    def delete(self, path, group=None):
+        try:
+            self.provider.delete(path, group)
+        finally:
+            self._invalidate(path)
+
+    def copy(self, target, source, group=None):
+        try:
+            self.provider.copy(target, source, group)
+        finally:
+            self._invalidate(target)
+
+    def clear(self):
+        """
+        Removes all objects from the cache.
+        """
+
+        with self._lock:
+            self._generation += 1
+            self._items.clear()
+            self._used = 0
+
+    def _key(self, path, summary):
+        """
+        Returns the cache key of a request.
+        """
+
+        segments, revision, absolute = decompose(path)
+        if not absolute:
+            raise InvalidPath('The path must be an absolute path.')
+        return tuple(segments), revision, bool(summary)
+
+    def _lookup(self, key):
+        """
+        Returns a cached object or None.
+        """
+
+        with self._lock:
+            item = self._items.get(key)
+            if item is not None:
+                obj, _, created = item
+                _, revision, _ = key
+                if not revision and self.head_ttl is not None and _now() - created > self.head_ttl:
+                    self._discard(key)
+                else:
+                    self._items.move_to_end(key)
+                    self.hits += 1
+                    return obj
+
+            self.misses += 1
+            return None
+
+    def _store(self, key, obj, generation):
+        """
+        Adds an object to the cache, unless a write occurred after it was read.
+        """
+
+        size = _object_size(obj)
+        if size > self.size:
+            return
+
+        with self._lock:
+            if generation != self._generation:
+                return
+
+            if key in self._items:
+                self._discard(key)
+
+            self._items[key] = (obj, size, _now())
+            self._used += size
+
+            while self._used > self.size:
+                _, (_, evicted, _) = self._items.popitem(last=False)
+                self._used -= evicted
+
+    def _shared_lookup(self, keys):
+        """
+        Returns the objects held by the shared store for a list of keys, None for each object not held.
+        """
+
+        objects = [None] * len(keys)
+        if self.shared is None:
+            return objects
+
+        # only explicit revisions are shared
+        requested = [(index, self._shared_key(key)) for index, key in enumerate(keys) if key[1]]
+        if not requested:
+            return objects
+
+        values = self.shared.get_many([shared_key for _, shared_key in requested])
+        for (index, _), value in zip(requested, values):
+            if value is None:
+                continue
+            try:
+                document, buffers = decode_binary(bytearray(value))
+                objects[index] = deserialise(document, buffers, adopt=True)
+            except (SALException, ValueError, TypeError, KeyError):
+                # a corrupt value is replaced when the object is next read from the provider
+                continue
+        return objects
+
+    def _shared_store(self, key, obj):
+        """
+        Places an explicit revision object in the shared store.
+        """
+
+        if self.shared is None or not key[1] or _object_size(obj) > self.shared_max_size:
+            return
+
+        # workers that do not support the columnar encoding treat the value as a miss
+        buffers = []
+        document = serialise(obj, buffers, columnar=True)
+        self.shared.set(self._shared_key(key), encode_binary(document, buffers), self.shared_ttl)
+
+    @staticmethod
+    def _shared_key(key):
+        """
+        Returns the shared store key of a cache entry.
+        """
+
+        segments, revision, summary = key
+        return 'object:/{}:{}:{}'.format('/'.join(segments), revision, 'summary' if summary else 'full')
+
+    def _invalidate(self, path):
+        """
+        Discards the cached head revision objects of a node and its descendants.
+        """
+
+        try:
+            segments, _, _ = decompose(path)
+        except SALException:
+            return
+
+        prefix = tuple(segments)
+        with self._lock:
+            self._generation += 1
+            for key in [key for key in self._items if not key[1] and key[0][:len(prefix)] == prefix]:
+                self._discard(key)
+
+    def _discard(self, key):
+        """
+        Removes a cache entry, the cache lock must be held.
+        """
+
+        _, size, _ = self._items.pop(key)
+        self._used -= size
+
+
+class MemoryStore(SharedStore):
+    """
+    A shared store held in the memory of the current process.
+
+    The store is only shared by the threads of a single process. It is
+    intended for testing and for single process deployments, multi-process
+    deployments require a store backed by an external service such as
+    RedisStore. The least recently used values are evicted once the total
+    size of the held values exceeds the size limit.
+
+    :param size: The maximum total size of the held values in bytes (default=256MB).
+    """
+
+    NAME = 'Memory Store'
+    VERSION = '1.0.0'
+
+    def __init__(self, size=_DEFAULT_CACHE_SIZE):
+
+        if size < 0:
+            raise ValueError('The store size cannot be negative.')
+
+        self.size = size
+
+        # values are (value, expiry time or None) tuples
+        self._items = OrderedDict()
+        self._used = 0
+        self._lock = threading.Lock()
+
+    def get(self, key):
+
+        with self._lock:
+            item = self._items.get(key)
+            if item is None:
+                return None
+
+            value, expires = item
+            if expires is not None and _now() >= expires:
+                self._discard(key)
+                return None
+
+            self._items.move_to_end(key)
+            return value
+
+    def set(self, key, value, ttl=None):
+
+        value = bytes(value)
+        if len(value) > self.size:
+            return
+
+        with self._lock:
+            if key in self._items:
+                self._discard(key)
+
+            self._items[key] = (value, _now() + ttl if ttl is not None else None)
+            self._used += len(value)
+
+            while self._used > self.size:
+                _, (evicted, _) = self._items.popitem(last=False)
+                self._used -= len(evicted)
+
+    def delete(self, key):
+
+        with self._lock:
+            if key in self._items:
+                self._discard(key)
+
+    def _discard(self, key):
+        """
+        Removes a value, the store lock must be held.
+        """
+
+        value, _ = self._items.pop(key)
+        self._used -= len(value)
+
+
+def _object_size(obj):
+    """
+    Returns the size charged to the cache for an object, the size of its array data plus a fixed overhead.
+    """
+
+    def count(d):
+        total = 0
+        for value in d.values():
+            if isinstance(value, dict):
+                total += count(value)
+            elif isinstance(value, np.ndarray):
+                total += value.nbytes
+        return total
+
+    if isinstance(obj, Branch):
+        return _ENTRY_OVERHEAD
+    return _ENTRY_OVERHEAD + count(obj.to_dict())
+
+
+def _now():
+    return time.monotonic()
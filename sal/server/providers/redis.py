@@ -0,0 +1,72 @@
+from sal.server.interface import SharedStore
+
+"""
+Redis Shared Store
+
+Requires redis package.
+"""
+
+try:
+    import redis
+except ImportError:
+    raise ImportError('Requires redis package version >= 3.0.')
+
+
+class RedisStore(SharedStore):
+    """
+    A shared store backed by a Redis server.
+
+    The store may be shared by the server processes of a deployment on any
+    number of hosts. Keys are prefixed so that several deployments may share
+    a Redis server, deployments serving different data trees must use
+    different prefixes. The Redis server should be configured with an
+    eviction policy (e.g. maxmemory-policy allkeys-lru) so it behaves as a
+    cache.
+
+    If the Redis server cannot be reached, lookups miss and values are not
+    stored, requests are then served without the shared store.
+
+    :param url: The Redis server URL e.g. 'redis://cache.domain.local:6379/0'.
+    :param prefix: The key prefix (default='sal:').
+    :param timeout: The socket timeout in seconds (default=1).
+    :param pool_size: The maximum number of pooled connections per process (default=16).
+    """
+
+    NAME = 'Redis Store'
+    VERSION = '1.0.0'
+
+    def __init__(self, url, prefix='sal:', timeout=1, pool_size=16):
+
+        self.url = url
+        self.prefix = prefix
+
+        pool = redis.ConnectionPool.from_url(
+            url, socket_timeout=timeout, socket_connect_timeout=timeout, max_connections=pool_size
+        )
+        self._redis = redis.Redis(connection_pool=pool)
+
+    def get(self, key):
+        try:
+            return self._redis.get(self.prefix + key)
+        except redis.RedisError:
+            return None
+
+    def get_many(self, keys):
+        if not keys:
+            return []
+        try:
+            return self._redis.mget([self.prefix + key for key in keys])
+        except redis.RedisError:
+            return [None] * len(keys)
+
+    def set(self, key, value, ttl=None):
+        try:
+            self._redis.set(self.prefix + key, bytes(value), ex=max(1, int(ttl)) if ttl is not None else None)
+        except redis.RedisError:
+            pass
+
+    def delete(self, key):
+        try:
+            self._redis.delete(self.prefix + key)
+        except redis.RedisError:
+            pass
@@ -0,0 +1,158 @@
+import threading
+from functools import wraps
+
+from sal.core.path import Path
+from sal.core.exception import NodeNotFound
+
+"""
+Persistence provider proxies for the SAL server.
+
+The server features that observe or time the persistence provider (metrics,
+the metadata index and change events) wrap the provider in a proxy, the
+provider supplied to the server is never modified. A proxy defines the
+operations it wraps, all other attributes are those of the wrapped provider.
+"""
+
+# persistence provider operations that modify the tree: operation -> function returning the written paths
+WRITE_OPERATIONS = {
+    'put': lambda path, *args, **kwargs: [path],
+    'put_stream': lambda path, *args, **kwargs: [path],
+    'put_many': lambda items, *args, **kwargs: [path for path, _ in items],
+    'copy': lambda target, *args, **kwargs: [target],
+    'delete': lambda path, *args, **kwargs: [path]
+}
+
+
+class ProviderProxy:
+    """
+    Base class for persistence provider proxies.
+
+    Subclasses place the wrapped operations on the proxy instance, attributes
+    not held by the proxy are looked up on the provider.
+
+    :param provider: A PersistenceProvider instance.
+    """
+
+    def __init__(self, provider):
+        self.provider = provider
+
+    def __getattr__(self, name):
+
+        # only called for attributes not held by the proxy
+        return getattr(self.provider, name)
+
+
+class Write:
+    """
+    A successful write made through an ObservedPersistence proxy.
+
+    The reports of the written nodes and the head revision following the
+    write are read from the provider on first use and shared by the
+    observers. The head revision is taken from the report of a written node,
+    the parent of a deleted node is listed if no written node remains.
+
+    :param provider: The PersistenceProvider that made the write.
+    :param operation: The write operation name e.g. 'put_many'.
+    :param paths: A list of normalised node path strings.
+    """
+
+    def __init__(self, provider, operation, paths):
+
+        self.provider = provider
+        self.operation = operation
+        self.paths = paths
+        self._reports = {}
+        self._revision = None
+
+    def report(self, path):
+        """
+        Returns the report of a written node at the head revision or None if the node does not exist.
+
+        :param path: One of the written paths.
+        :return: A BranchReport, LeafReport or None.
+        """
+
+        if path not in self._reports:
+            try:
+                self._reports[path] = self.provider.list(path)
+            except NodeNotFound:
+                self._reports[path] = None
+        return self._reports[path]
+
+    @property
+    def revision(self):
+        """
+        The head revision following the write.
+        """
+
+        if self._revision is None:
+            for path in self.paths:
+                report = self.report(path)
+                if report is not None:
+                    self._revision = report.revision_latest
+                    break
+            else:
+                parent = '/' + '/'.join(Path(self.paths[0]).segments[:-1])
+                self._revision = self.provider.list(parent).revision_latest
+        return self._revision
+
+
+class ObservedPersistence(ProviderProxy):
+    """
+    A persistence provider proxy that notifies observers of the writes made through it.
+
+    Once a write operation succeeds, each observer's written() method is
+    called with a Write describing it. Observers must not raise, an
+    exception raised by an observer is discarded as the write has already
+    succeeded. If a write operation calls back into the proxy from the same
+    thread, only the outermost operation is reported.
+
+    :param provider: A PersistenceProvider instance.
+    :param observers: A list of observer objects.
+    """
+
+    def __init__(self, provider, observers):
+
+        super().__init__(provider)
+        self.observers = list(observers)
+        self._local = threading.local()
+
+        for operation, paths in WRITE_OPERATIONS.items():
+            method = getattr(provider, operation, None)
+            if method is not None:
+                setattr(self, operation, self._observed(method, operation, paths))
+
+    def _observed(self, method, operation, paths):
+        """
+        Wraps a provider write operation to notify the observers.
+        """
+
+        @wraps(method)
+        def wrapper(*args, **kwargs):
+
+            # writes made by nested calls are reported by the outermost call
+            if getattr(self._local, 'active', False):
+                return method(*args, **kwargs)
+
+            self._local.active = True
+            try:
+                result = method(*args, **kwargs)
+            finally:
+                self._local.active = False
+
+            try:
+                written = [str(Path(path)) for path in paths(*args, **kwargs)]
+            except Exception:
+                return result
+
+            if written:
+                write = Write(self.provider, operation, written)
+                for observer in self.observers:
+                    try:
+                        observer.written(write)
+                    except Exception:
+                        # never fail a write that has succeeded
+                        pass
+            return result
+
+        return wrapper
@@ -1,4 +1,8 @@
 from .root import *
+from .metrics import *
 from .authenticator import *
 from .data import *
+from .batch import *
+from .search import *
+from .events import *
 from .permission import *
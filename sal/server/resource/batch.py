@@ -0,0 +1,187 @@
+from flask_restful import Resource, request, current_app
+
+from sal.core.serialise import serialise, deserialise, EnvelopeReader, BINARY_MIME_TYPE
+from sal.core.object import Branch, DataObject
+from sal.core.path import Path
+from sal.core.exception import SALException, InvalidRequest, InvalidPath, InternalError
+from sal.server.auth import authenticated_endpoint
+from sal.server.resource.data import accepts_binary, accepts_columnar, requested_compression, object_response
+from sal.server.metrics import phase
+
+# maximum number of paths accepted by a single batch get request
+MAX_BATCH_SIZE = 1000
+
+# maximum number of nodes written by a single batch put request
+MAX_BATCH_PUT_SIZE = 10000
+
+
+class DataBatch(Resource):
+
+    decorators = [authenticated_endpoint]
+
+    def __init__(self):
+        self.persistence_provider = current_app.config['SAL']['PERSISTENCE']
+        self.authorisation_provider = current_app.config['SAL']['AUTHORISATION']
+
+    def post(self, user=None):
+        """
+        Batch get operation:
+
+            POST http://<hostpath>/batch
+
+            {"operation": "get", "summary": <true/false>, "paths": [<path>, ...]}
+
+        Returns the objects for all the paths in a single response. Each path
+        may include a revision, paths without a revision are read at the head
+        revision at the time of the request. The result for each path is
+        reported individually, a failure to obtain one path does not fail the
+        request.
+
+        Objects are returned as JSON unless the client accepts the binary
+        transport content type, in which case a binary envelope is returned.
+
+        Batch put operation:
+
+            POST http://<hostpath>/batch
+
+            {"operation": "put", "items": [{"path": <path>, "object": <object>}, ...]}
+
+        Writes the branch and leaf objects in order, in a single revision
+        where supported by the persistence provider. The request fails as a
+        whole if any item cannot be written. The request may be sent as a
+        binary envelope, the objects share the envelope buffers.
+        """
+
+        # todo: requests groups for user from authorisation provider and pass to persistence layer
+
+        buffers = None
+        if request.mimetype == BINARY_MIME_TYPE:
+            try:
+                reader = EnvelopeReader(request.stream)
+                content = reader.document
+                buffers = reader.read_buffers()
+            except InternalError:
+                raise InvalidRequest('Could not de-serialise content.')
+        else:
+            content = request.get_json(silent=True)
+
+        if not isinstance(content, dict):
+            raise InvalidRequest('The batch request must be a JSON object.')
+
+        operation = content.get('operation', 'get')
+        if operation == 'put':
+            return self._put(content, buffers)
+
+        if operation != 'get':
+            raise InvalidRequest('Unsupported batch operation \'{}\'.'.format(operation))
+
+        summary = content.get('summary', False)
+        if not isinstance(summary, bool):
+            raise InvalidRequest('The summary attribute must be a boolean.')
+
+        paths = content.get('paths')
+        if not isinstance(paths, list) or not all(isinstance(path, str) for path in paths):
+            raise InvalidRequest('The paths attribute must be a list of path strings.')
+
+        if len(paths) > MAX_BATCH_SIZE:
+            raise InvalidRequest('A batch request may contain at most {} paths.'.format(MAX_BATCH_SIZE))
+
+        # normalise paths, invalid paths are reported individually
+        results = [None] * len(paths)
+        requested = []
+        for index, path in enumerate(paths):
+            try:
+                node = Path(path)
+                if not node.absolute:
+                    raise InvalidPath('The path must be an absolute path.')
+            except SALException as e:
+                results[index] = e
+                continue
+            requested.append((index, node))
+
+        with phase('provider'):
+
+            # resolve the head revision so caching providers key every object by an explicit revision
+            if any(not node.revision for _, node in requested):
+                head = self.persistence_provider.list('/').revision_latest
+                requested = [(index, node if node.revision else node.at(head)) for index, node in requested]
+
+            objects = self.persistence_provider.get_many([path for _, path in requested], summary)
+        for (index, _), obj in zip(requested, objects):
+            results[index] = obj
+
+        # generate response, all objects share the buffer list
+        buffers = []
+        scheme = requested_compression()
+        columnar = accepts_columnar()
+        with phase('serialise'):
+            response = {
+                'results': [self._encode_result(path, result, buffers, scheme, columnar) for path, result in zip(paths, results)],
+                'request': {'url': request.url}
+            }
+        return object_response(response, buffers, accepts_binary())
+
+    def _put(self, content, buffers):
+        """
+        Handles a batch put operation.
+
+        :param content: The request document.
+        :param buffers: The envelope buffers or None for a JSON request.
+        :return: An empty 204 response.
+        """
+
+        items = content.get('items')
+        if not isinstance(items, list):
+            raise InvalidRequest('The items attribute must be a list of path and object items.')
+
+        if len(items) > MAX_BATCH_PUT_SIZE:
+            raise InvalidRequest('A batch put request may contain at most {} items.'.format(MAX_BATCH_PUT_SIZE))
+
+        writes = []
+        with phase('deserialise'):
+            for index, item in enumerate(items):
+                if not isinstance(item, dict) or not isinstance(item.get('path'), str) or 'object' not in item:
+                    raise InvalidRequest('Batch item {} must contain a path string and an object.'.format(index))
+
+                try:
+                    obj = deserialise(item['object'], buffers, adopt=True)
+                except:
+                    raise InvalidRequest('Could not de-serialise the content of batch item {}.'.format(index))
+
+                if not isinstance(obj, (Branch, DataObject)):
+                    raise InvalidRequest('The content of batch item {} does not describe a Branch or DataObject.'.format(index))
+
+                writes.append((Path(item['path']), obj))
+
+        with phase('provider'):
+            self.persistence_provider.put_many(writes)
+
+        # return no content
+        return '', 204
+
+    @staticmethod
+    def _encode_result(path, result, buffers, scheme, columnar=False):
+        """
+        Encodes the result for a single path.
+
+        :param path: The requested path.
+        :param result: The object or exception returned for the path.
+        :param buffers: A list to populate with binary buffers.
+        :param scheme: The array compression scheme or None.
+        :param columnar: Encode large scalar dictionaries as columns (default=False).
+        :return: A result dictionary.
+        """
+
+        if isinstance(result, Exception):
+            return {
+                'path': path,
+                'error': {
+                    'exception': result.__class__.__name__,
+                    'message': str(result)
+                }
+            }
+
+        return {
+            'path': path,
+            'object': serialise(result, buffers, scheme, columnar=columnar)
+        }
@@ -1,9 +1,32 @@
+import re
+import hashlib
+from urllib.parse import urlencode
+
+import numpy as np
+
+from flask import Response
+from werkzeug.http import quote_etag
 from flask_restful import Resource, request, reqparse, current_app
 
-from sal.core.serialise import serialise, deserialise
+from sal.core.serialise import serialise, deserialise, iter_binary, iter_json, buffer_size, EnvelopeReader
+from sal.core.serialise import BINARY_MIME_TYPE, BINARY_CHUNK_SIZE, DEFER_THRESHOLD, ENCODING_HEADER
 from sal.core.object import Branch, DataObject
-from sal.core.exception import InvalidRequest
+from sal.core.selection import Selection, REDUCTIONS
+from sal.core.exception import InvalidRequest, InternalError
+from sal.core.path import Path
+from sal.core import compression
+from sal.dataclass import Array
 from sal.server.auth import authenticated_endpoint
+from sal.server.metrics import phase
+
+# response header reporting the revision of the returned object
+REVISION_HEADER = 'X-SAL-Revision'
+
+# object responses carrying at least this many bytes of array data are streamed
+STREAM_THRESHOLD = 1024 * 1024
+
+# component keys are '/' separated object dictionary keys e.g. 'dimensions/0/data'
+_COMPONENT_PATTERN = re.compile(r'^[a-z0-9_]+(/[a-z0-9_]+)*$')
 
 
 # query argument validators
@@ -11,14 +34,14 @@ def _object_arg(value):
     """
     Validates the value of the optional object argument.
 
-    :raises ValueError: If value is not None, 'full' or 'summary'.
+    :raises ValueError: If value is not None, 'full', 'summary' or 'skeleton'.
     :param value: Argument value.
     :return: Validated value.
     """
 
-    if value in [None, 'full', 'summary']:
+    if value in [None, 'full', 'summary', 'skeleton']:
         return value
-    raise ValueError('Must be either \'full\' or \'summary\'.')
+    raise ValueError('Must be either \'full\', \'summary\' or \'skeleton\'.')
 
 
 def _revision_arg(value):
@@ -38,10 +61,162 @@ def _revision_arg(value):
     raise ValueError('Must be \'head\' or an integer >= 0.')
 
 
+def _depth_arg(value):
+    """
+    Validates the value of the optional depth argument.
+
+    :raises ValueError: If value is not 'full' or an integer >= 1.
+    :param value: Argument value.
+    :return: Validated value.
+    """
+
+    if value == 'full':
+        return value
+    value = int(value)
+    if value >= 1:
+        return value
+    raise ValueError('Must be \'full\' or an integer >= 1.')
+
+
+def _selection_arg(value):
+    """
+    Validates the value of the optional slice and range arguments.
+
+    :raises ValueError: If the selection string is invalid.
+    :param value: Argument value.
+    :return: Validated value.
+    """
+
+    # the selection is fully validated once the slice and range arguments are combined
+    for item in value.split(','):
+        if len(item.split(':')) > 3:
+            raise ValueError('Must be a comma separated list of start:stop[:step] items.')
+    return value
+
+
+def _component_arg(value):
+    """
+    Validates the value of the optional component argument.
+
+    :raises ValueError: If the component key is invalid.
+    :param value: Argument value.
+    :return: Validated value.
+    """
+
+    if _COMPONENT_PATTERN.match(value):
+        return value
+    raise ValueError('Must be a \'/\' separated list of object keys.')
+
+
+def _bins_arg(value):
+    """
+    Validates the value of the optional bins argument.
+
+    :raises ValueError: If the bins string is invalid.
+    :param value: Argument value.
+    :return: Validated value.
+    """
+
+    for item in value.split(','):
+        item = item.strip()
+        if item and int(item) < 1:
+            raise ValueError('Must be a comma separated list of positive integers.')
+    return value
+
+
+def _reduce_arg(value):
+    """
+    Validates the value of the optional reduce argument.
+
+    :raises ValueError: If value is not 'mean', 'min' or 'max'.
+    :param value: Argument value.
+    :return: Validated value.
+    """
+
+    if value in REDUCTIONS:
+        return value
+    raise ValueError('Must be one of \'{}\'.'.format('\', \''.join(REDUCTIONS)))
+
+
+def accepts_binary():
+    """
+    Returns True if the client prefers the binary transport over JSON.
+    """
+
+    mimetypes = request.accept_mimetypes
+    return mimetypes[BINARY_MIME_TYPE] > mimetypes['application/json']
+
+
+def requested_compression():
+    """
+    Returns the array compression scheme requested by the client.
+
+    Schemes not supported by the server are ignored, the arrays are then
+    sent uncompressed.
+
+    :return: A compression scheme name or None.
+    """
+
+    scheme = request.headers.get(compression.HEADER)
+    if scheme and scheme in compression.available():
+        return scheme
+    return None
+
+
+def accepts_columnar():
+    """
+    Returns True if the client accepts the columnar encoding of large scalar dictionaries.
+
+    The client lists the optional document encodings it accepts in the
+    encoding header, see sal.core.serialise.ENCODINGS.
+    """
+
+    encodings = request.headers.get(ENCODING_HEADER, '')
+    return 'columnar' in [encoding.strip() for encoding in encodings.split(',')]
+
+
+def object_response(document, buffers, binary, headers=None):
+    """
+    Generates the response for a serialised document and its array buffers.
+
+    The document is sent as a binary envelope if binary is True, otherwise
+    as JSON with the arrays base64 encoded. Responses carrying large arrays
+    are streamed, the response body is generated in chunks as it is sent so
+    the encoded response is never held in memory and the first bytes are
+    sent without waiting for the complete response to be encoded.
+
+    :param document: A serialised document (see serialise()).
+    :param buffers: The list of array buffers referenced by the document.
+    :param binary: True to use the binary transport.
+    :param headers: Optional dictionary of response headers (default=None).
+    :return: A Response object.
+    """
+
+    if binary:
+        mimetype = BINARY_MIME_TYPE
+        chunks = (bytes(chunk) for chunk in iter_binary(document, buffers, BINARY_CHUNK_SIZE))
+    else:
+        mimetype = 'application/json'
+        chunks = iter_json(document, buffers)
+
+    if buffer_size(buffers) < STREAM_THRESHOLD:
+        with phase('encode'):
+            content = b''.join(chunks)
+        return Response(content, status=200, mimetype=mimetype, headers=headers)
+
+    return Response(chunks, status=200, mimetype=mimetype, headers=headers)
+
+
 # argument parsers for each method
 get_parser = reqparse.RequestParser()
 get_parser.add_argument('object', type=_object_arg, case_sensitive=False, default=None)
 get_parser.add_argument('revision', type=_revision_arg, case_sensitive=False, default=0)
+get_parser.add_argument('depth', type=_depth_arg, case_sensitive=False, default=None)
+get_parser.add_argument('slice', type=_selection_arg, default=None)
+get_parser.add_argument('range', type=_selection_arg, default=None)
+get_parser.add_argument('bins', type=_bins_arg, default=None)
+get_parser.add_argument('reduce', type=_reduce_arg, case_sensitive=False, default=None)
+get_parser.add_argument('component', type=_component_arg, case_sensitive=False, default=None)
 
 post_parser = reqparse.RequestParser()
 post_parser.add_argument('source', type=str, case_sensitive=False, default=None)
@@ -62,45 +237,216 @@ class DataTree(Resource):
 
             GET http://<hostpath>/data/<path>?[revision=<revision/head>]
 
+        List operation (subtree):
+
+            GET http://<hostpath>/data/<path>?depth=<depth/full>[&revision=<revision/head>]
+
         Get operation:
 
             GET http://<hostpath>/data/<path>?object=<full/summary>[&revision=<revision/head>]
 
+        Get operation (data selection):
+
+            GET http://<hostpath>/data/<path>?object=full&[slice=<slices>][&range=<ranges>][&bins=<bins>[&reduce=<mean/min/max>]][&revision=<revision/head>]
+
+        Get operation (skeleton object):
+
+            GET http://<hostpath>/data/<path>?object=skeleton[&<selection>][&revision=<revision/head>]
+
+        Get operation (object component):
+
+            GET http://<hostpath>/data/<path>?object=full&component=<key>[&<selection>][&revision=<revision/head>]
+
+        A skeleton object omits the large arrays of the object, each omitted
+        array is identified by a component key. A component request returns
+        the array identified by the key as an Array object. The selection, if
+        any, is applied to the object before the component is extracted.
+
+        Objects are returned as JSON unless the client accepts the binary
+        transport content type, in which case a binary envelope is returned.
+        Objects with large arrays are streamed.
+
+        Large arrays are compressed if the client requests a supported
+        compression scheme via the X-SAL-Compression header.
+
+        Object responses carry an ETag identifying the node revision, object
+        type, selection, component, content type and compression. If the
+        ETag matches the request's If-None-Match header, a 304 (not modified)
+        response is returned without the object. The revision of the object
+        is reported by the X-SAL-Revision header.
         """
 
         # todo: requests groups for user from authorisation provider and pass to persistence layer
 
         # parse query string options
-        args = get_parser.parse_args()
-        object_request = args['object']
-        revision = args['revision']
+        with phase('arguments'):
+            args = get_parser.parse_args()
+            object_request = args['object']
+            revision = args['revision']
+            component = args['component']
+
+            if component and object_request != 'full':
+                raise InvalidRequest('A component may only be requested from a full object.')
 
-        # construct node path
-        path = '/{}:{}'.format(path, revision)
+            selection = None
+            selection_args = (args['slice'], args['range'], args['bins'], args['reduce'])
+            if object_request and any(selection_args):
+
+                if object_request == 'summary':
+                    raise InvalidRequest('A data selection cannot be applied to a summary object.')
+
+                try:
+                    selection = Selection.from_query(*selection_args)
+                except (TypeError, ValueError) as e:
+                    raise InvalidRequest('Invalid data selection: {}'.format(e))
+
+            # parse the node path once, the parsed path is passed to the provider
+            node = Path('/{}:{}'.format(path, revision))
 
         if object_request:
 
-            # request object
+            binary = accepts_binary()
+            scheme = requested_compression()
+            columnar = accepts_columnar()
             summary = (object_request == 'summary')
-            obj = self.persistence_provider.get(path, summary)
 
-        else:
+            # the node is only listed ahead of the read if the client may already hold the object
+            if request.if_none_match:
+                with phase('provider'):
+                    report = self.persistence_provider.list(node)
+
+                revision = report.revision_current
+                modified = max((r for r in report.revision_modified if r <= revision), default=revision)
+                etag, headers = self._object_headers(path, revision, modified, object_request, selection, component, binary, scheme, columnar)
+                if request.if_none_match.contains(etag):
+                    return Response(status=304, headers=headers)
+
+                # read the listed revision so the object returned matches the ETag, even if the head moves
+                node = node.at(revision)
+
+            # the object and the revisions identifying it are obtained from a single provider call
+            with phase('provider'):
+                obj, revision, modified = self.persistence_provider.get_versioned(node, summary, selection)
+            _, headers = self._object_headers(path, revision, modified, object_request, selection, component, binary, scheme, columnar)
+
+            if component:
+                obj = self._component(obj, component)
 
-            # request report
-            obj = self.persistence_provider.list(path)
+            # skeletons omit large arrays
+            defer = DEFER_THRESHOLD if object_request == 'skeleton' else None
+
+            # generate response, a binary envelope if preferred by the client
+            buffers = []
+            with phase('serialise'):
+                response = serialise(obj, buffers, scheme, defer, columnar)
+            response["request"] = {"url": request.url}
+            return object_response(response, buffers, binary, headers)
+
+        with phase('provider'):
+            if args['depth']:
+
+                # request subtree report
+                depth = None if args['depth'] == 'full' else args['depth']
+                obj = self.persistence_provider.list_tree(node, depth)
+
+            else:
+
+                # request report
+                obj = self.persistence_provider.list(node)
 
         # generate response
-        response = serialise(obj)
+        with phase('serialise'):
+            response = serialise(obj)
         response["request"] = {"url": request.url}
         return response
 
+    @staticmethod
+    def _component(obj, key):
+        """
+        Returns an object component as an Array object.
+
+        :param obj: The requested object.
+        :param key: The component key.
+        :return: An Array object.
+        """
+
+        if not isinstance(obj, DataObject):
+            raise InvalidRequest('A component may only be requested from a leaf node.')
+
+        item = obj.to_dict()
+        for name in key.split('/'):
+            if not isinstance(item, dict) or name not in item:
+                raise InvalidRequest('The object does not contain the component \'{}\'.'.format(key))
+            item = item[name]
+
+        if not isinstance(item, np.ndarray) or not np.issubdtype(item.dtype, np.number):
+            raise InvalidRequest('The component \'{}\' is not a numerical array.'.format(key))
+
+        return Array(item.shape, item, item.dtype, 'Component \'{}\'.'.format(key), copy=False)
+
+    @classmethod
+    def _object_headers(cls, path, revision, modified, object_request, selection, component, binary, scheme, columnar):
+        """
+        Generates the entity tag and the response headers for an object response.
+
+        :param path: The node path without the revision.
+        :param revision: The revision of the returned object.
+        :param modified: The revision in which the node was last modified, at or before the object revision.
+        :param object_request: The object type, 'full', 'summary' or 'skeleton'.
+        :param selection: A Selection object or None.
+        :param component: The component key or None.
+        :param binary: True if the response uses the binary transport.
+        :param scheme: The array compression scheme or None.
+        :param columnar: True if large scalar dictionaries are encoded as columns.
+        :return: A tuple containing the entity tag string and a dictionary of headers.
+        """
+
+        etag = cls._etag(path, modified, object_request, selection, component, binary, scheme, columnar)
+        headers = {
+            'ETag': quote_etag(etag),
+            'Vary': 'Accept, {}, {}'.format(compression.HEADER, ENCODING_HEADER),
+            REVISION_HEADER: str(revision)
+        }
+        return etag, headers
+
+    @staticmethod
+    def _etag(path, modified, object_request, selection, component, binary, scheme, columnar=False):
+        """
+        Generates the entity tag for an object response.
+
+        The tag is derived from the revision in which the node was last
+        modified, rather than the requested revision, so the tag for the
+        head of a node only changes when the node itself changes.
+
+        :param path: The node path without the revision.
+        :param modified: The revision in which the node was last modified, at or before the requested revision.
+        :param object_request: The object type, 'full', 'summary' or 'skeleton'.
+        :param selection: A Selection object or None.
+        :param component: The component key or None.
+        :param binary: True if the response uses the binary transport.
+        :param scheme: The array compression scheme or None.
+        :param columnar: True if large scalar dictionaries are encoded as columns (default=False).
+        :return: The entity tag string.
+        """
+
+        query = urlencode(sorted(selection.to_query().items())) if selection else ''
+        content_type = BINARY_MIME_TYPE if binary else 'application/json'
+
+        key = '/{}|{}|{}|{}|{}|{}|{}'.format(path, modified, object_request, query, component or '', content_type, scheme or '')
+        if columnar:
+            key += '|columnar'
+        return hashlib.sha1(key.encode('utf-8')).hexdigest()
+
     def post(self, path='', user=None):
         """
         Put operation:
 
             POST http://<hostpath>/data/<path>
 
-            branch and leaf content
+            branch and leaf content (JSON or binary envelope)
+
+        Binary envelopes may be sent with chunked transfer encoding, the
+        envelope is streamed to the persistence provider as it is received.
 
         Copy operation:
 
@@ -116,7 +462,7 @@ class DataTree(Resource):
         source_revision = args['source_revision']
 
         # construct target path
-        target = '/' + path
+        target = Path('/' + path)
 
         if source:
 
@@ -124,21 +470,32 @@ class DataTree(Resource):
             source = '{}:{}'.format(source, source_revision)
             self.persistence_provider.copy(target, source)
 
-        else:
-
-            # new content
-            content = request.json
+        elif request.mimetype == BINARY_MIME_TYPE:
 
+            # new content, streamed to the provider so the envelope is never held in memory as a whole
             try:
-                obj = deserialise(content)
-            except:
+                reader = EnvelopeReader(request.stream)
+            except InternalError:
                 raise InvalidRequest('Could not de-serialise content.')
 
+            with phase('provider'):
+                self.persistence_provider.put_stream(target, reader)
+
+        else:
+
+            # new content
+            with phase('deserialise'):
+                try:
+                    obj = deserialise(request.json)
+                except:
+                    raise InvalidRequest('Could not de-serialise content.')
+
             if not isinstance(obj, (Branch, DataObject)):
                 # invalid content
-                return InvalidRequest('Content does not describe a Branch or DataObject.')
+                raise InvalidRequest('Content does not describe a Branch or DataObject.')
 
-            self.persistence_provider.put(target, obj)
+            with phase('provider'):
+                self.persistence_provider.put(target, obj)
 
         # return no content
         return '', 204
@@ -154,7 +511,7 @@ class DataTree(Resource):
         # todo: requests groups for user from authorisation provider and pass to persistence layer
 
         # request deletion
-        self.persistence_provider.delete('/' + path)
+        self.persistence_provider.delete(Path('/' + path))
 
         # return no content
         return '', 204
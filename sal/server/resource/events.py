@@ -0,0 +1,98 @@
+import json
+
+from flask import Response
+from flask_restful import Resource, request, reqparse, current_app, abort
+
+from sal.core.exception import InvalidRequest
+from sal.server.auth import authenticated_endpoint
+
+EVENT_STREAM_MIME_TYPE = 'text/event-stream'
+
+# seconds between keep-alive comments on an idle stream, idle streams also poll for writes by other processes
+KEEPALIVE_INTERVAL = 15
+
+# milliseconds a client should wait before reconnecting
+RECONNECT_DELAY = 3000
+
+
+get_parser = reqparse.RequestParser()
+get_parser.add_argument('path', action='append', default=None)
+get_parser.add_argument('last_event', default=None)
+
+
+def _stream(bus, subscription):
+    """
+    Generates the server-sent event stream for a subscription.
+
+    The subscription is closed when the client disconnects.
+    """
+
+    try:
+        yield 'retry: {}\n\n'.format(RECONNECT_DELAY)
+        while not subscription.closed:
+
+            event = subscription.next(KEEPALIVE_INTERVAL)
+            if event is None:
+                if not subscription.closed:
+                    bus.poll()
+                    yield ': keep-alive\n\n'
+                continue
+
+            yield 'id: {}\nevent: {}\ndata: {}\n\n'.format(event['id'], event['operation'], json.dumps(event))
+
+        # the subscription was reset, deliver any remaining events before closing the stream
+        event = subscription.next(0)
+        while event is not None:
+            yield 'id: {}\nevent: {}\ndata: {}\n\n'.format(event['id'], event['operation'], json.dumps(event))
+            event = subscription.next(0)
+
+    finally:
+        subscription.close()
+
+
+class EventStream(Resource):
+
+    decorators = [authenticated_endpoint]
+
+    def __init__(self):
+        self.events = current_app.config['SAL']['EVENTS']
+
+    def get(self, user=None):
+        """
+        Subscription operation:
+
+            GET http://<hostpath>/events?path=<path>[&path=<path>...][&last_event=<id>]
+
+        Returns a server-sent event stream (text/event-stream) of the writes
+        made to the nodes at or below the paths, the root is used if no paths
+        are supplied. Each event carries a JSON document:
+
+            {"id": <id>, "operation": <'put'|'copy'|'delete'|'revision'|'reset'>,
+             "path": <path>, "revision": <head revision>, "timestamp": <ISO 8601>}
+
+        A client resumes a stream by supplying the id of the last event
+        received with the Last-Event-ID header or the last_event argument.
+
+        The resource is not available if events are disabled.
+        """
+
+        # todo: requests groups for user from authorisation provider and filter events by permission
+
+        if self.events is None:
+            abort(404)
+
+        args = get_parser.parse_args()
+        last_event = request.headers.get('Last-Event-ID') or args['last_event']
+
+        try:
+            subscription = self.events.subscribe(args['path'] or ['/'], last_event)
+        except ValueError as e:
+            raise InvalidRequest(str(e))
+        except OverflowError:
+            abort(503, message='The maximum number of event subscribers has been reached.')
+
+        headers = {
+            'Cache-Control': 'no-cache',
+            'X-Accel-Buffering': 'no'
+        }
+        return Response(_stream(self.events, subscription), status=200, mimetype=EVENT_STREAM_MIME_TYPE, headers=headers)
@@ -0,0 +1,25 @@
+from flask import Response
+from flask_restful import Resource, current_app, abort
+
+from sal.server.metrics import CONTENT_TYPE
+
+
+class ServerMetrics(Resource):
+    """
+    Handler for the server metrics resource.
+
+    The metrics are not authenticated so they may be collected by a
+    monitoring system. The resource is not available if metrics are
+    disabled.
+    """
+
+    def get(self):
+        """
+        Returns the server metrics in the Prometheus text exposition format.
+        """
+
+        metrics = current_app.config['SAL']['METRICS']
+        if metrics is None:
+            abort(404)
+
+        return Response(metrics.render(), status=200, content_type=CONTENT_TYPE)
@@ -1,6 +1,8 @@
 from flask_restful import Resource, request, current_app
 from sal.core.version import VERSION
 from sal.core.object import dataclass
+from sal.core.serialise import BINARY_MIME_TYPE, ENCODINGS
+from sal.core import compression
 from sal.server.auth import auth_required
 
 
@@ -20,9 +22,15 @@ class ServerInfo(Resource):
         requires_auth = auth_required()
 
         # build list of resources
-        resources = ['data']
+        resources = ['data', 'batch']
         if requires_auth:
             resources.append('auth')
+        if current_app.config['SAL']['METRICS'] is not None:
+            resources.append('metrics')
+        if current_app.config['SAL']['INDEX'] is not None:
+            resources.append('search')
+        if current_app.config['SAL']['EVENTS'] is not None:
+            resources.append('events')
 
         return {
             'host': request.base_url,
@@ -30,6 +38,9 @@ class ServerInfo(Resource):
                 'version': api_version,
                 'requires_auth': requires_auth,
                 'resources': resources,
+                'content_types': ['application/json', BINARY_MIME_TYPE],
+                'compression': compression.available(),
+                'encodings': list(ENCODINGS),
                 'classes': dataclass.list()
             },
             'service': {
@@ -0,0 +1,78 @@
+from flask_restful import Resource, request, current_app, abort
+
+from sal.core.serialise import serialise
+from sal.core.exception import InvalidRequest
+from sal.server.auth import authenticated_endpoint
+from sal.server.index import DEFAULT_LIMIT
+from sal.server.metrics import phase
+
+# maximum number of results returned by a single search request
+MAX_SEARCH_RESULTS = 10000
+
+# search request attributes and the corresponding index search arguments
+_CRITERIA = {
+    'path': 'path',
+    'class': 'cls',
+    'group': 'group',
+    'version': 'version',
+    'metadata': 'metadata',
+    'modified_after': 'modified_after',
+    'modified_before': 'modified_before'
+}
+
+
+class DataSearch(Resource):
+
+    decorators = [authenticated_endpoint]
+
+    def __init__(self):
+        self.index = current_app.config['SAL']['INDEX']
+
+    def post(self, user=None):
+        """
+        Search operation:
+
+            POST http://<hostpath>/search
+
+            {"path": <path>, "class": <class>, "group": <group>, "version": <version>,
+             "metadata": {<key>: <value>, ...}, "modified_after": <ISO 8601>,
+             "modified_before": <ISO 8601>, "limit": <limit>}
+
+        Returns the head revision leaves under the path that match all the
+        supplied criteria, all attributes are optional. The leaves are found
+        using the server's metadata index, see sal.server.index.
+
+        The resource is not available if the index is disabled.
+        """
+
+        # todo: requests groups for user from authorisation provider and pass to persistence layer
+
+        if self.index is None:
+            abort(404)
+
+        content = request.get_json(silent=True)
+        if not isinstance(content, dict):
+            raise InvalidRequest('The search request must be a JSON object.')
+
+        unknown = set(content) - set(_CRITERIA) - {'limit'}
+        if unknown:
+            raise InvalidRequest('Unknown search attributes: {}.'.format(', '.join(sorted(unknown))))
+
+        limit = content.get('limit', DEFAULT_LIMIT)
+        if not isinstance(limit, int) or isinstance(limit, bool) or not 1 <= limit <= MAX_SEARCH_RESULTS:
+            raise InvalidRequest('The limit must be an integer between 1 and {}.'.format(MAX_SEARCH_RESULTS))
+
+        # request one extra result to detect truncation
+        criteria = {_CRITERIA[key]: value for key, value in content.items() if key in _CRITERIA}
+        with phase('index'):
+            results = self.index.search(limit=limit + 1, **criteria)
+
+        truncated = len(results) > limit
+        with phase('serialise'):
+            response = {
+                'results': [{'path': path, 'report': serialise(report)} for path, report in results[:limit]],
+                'truncated': truncated,
+                'revision': self.index.revision,
+                'request': {'url': request.url}
+            }
+        return response
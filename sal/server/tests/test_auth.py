@@ -0,0 +1,96 @@
+import json
+import time
+import unittest
+from sal.server.auth import TokenCache
+from sal.server.providers.memory import MemoryStore
+
+
+class TestTokenCache(unittest.TestCase):
+
+    def test_get_put(self):
+
+        cache = TokenCache(size=10, ttl=60)
+        self.assertIsNone(cache.get('token'))
+
+        cache.put('token', 'user', '127.0.0.1', time.time() + 60)
+        self.assertEqual(cache.get('token'), ('user', '127.0.0.1'))
+
+        cache.clear()
+        self.assertIsNone(cache.get('token'))
+
+    def test_expiry(self):
+
+        # expired tokens are never returned, regardless of the ttl
+        cache = TokenCache(size=10, ttl=60)
+        cache.put('token', 'user', '127.0.0.1', time.time() - 1)
+        self.assertIsNone(cache.get('token'))
+
+        # entries are discarded at the ttl, before the token expires
+        cache = TokenCache(size=10, ttl=0.05)
+        cache.put('token', 'user', '127.0.0.1', time.time() + 60)
+        self.assertIsNotNone(cache.get('token'))
+        time.sleep(0.1)
+        self.assertIsNone(cache.get('token'))
+
+    def test_eviction(self):
+
+        cache = TokenCache(size=2, ttl=60)
+        expires = time.time() + 60
+        cache.put('a', 'user_a', '127.0.0.1', expires)
+        cache.put('b', 'user_b', '127.0.0.1', expires)
+
+        # a becomes the most recently used token, b is evicted
+        cache.get('a')
+        cache.put('c', 'user_c', '127.0.0.1', expires)
+        self.assertIsNotNone(cache.get('a'))
+        self.assertIsNone(cache.get('b'))
+        self.assertIsNotNone(cache.get('c'))
+
+    def test_disabled(self):
+
+        cache = TokenCache(size=0)
+        cache.put('token', 'user', '127.0.0.1', time.time() + 60)
+        self.assertIsNone(cache.get('token'))
+
+        with self.assertRaises(ValueError):
+            TokenCache(size=-1)
+
+    def test_shared(self):
+
+        # a token verified by one process is accepted by another sharing the store
+        store = MemoryStore()
+        first = TokenCache(size=10, ttl=60, shared=store, secret='secret')
+        second = TokenCache(size=10, ttl=60, shared=store, secret='secret')
+
+        first.put('token', 'user', '127.0.0.1', time.time() + 60)
+        self.assertEqual(second.get('token'), ('user', '127.0.0.1'))
+        self.assertNotIn('token', store._items)
+
+        # expired shared entries are ignored
+        first.put('expired', 'user', '127.0.0.1', time.time() - 1)
+        self.assertIsNone(second.get('expired'))
+
+        # a secret is required to share tokens
+        with self.assertRaises(ValueError):
+            TokenCache(size=10, ttl=60, shared=store)
+
+    def test_shared_forgery(self):
+
+        store = MemoryStore()
+        cache = TokenCache(size=10, ttl=60, shared=store, secret='secret')
+        key = TokenCache._shared_key('forged')
+        entry = json.dumps(['admin', '127.0.0.1', time.time() + 60])
+
+        # unauthenticated entries are rejected
+        store.set(key, entry.encode('utf-8'), 60)
+        self.assertIsNone(cache.get('forged'))
+
+        # entries authenticated with another secret are rejected
+        other = TokenCache(size=10, ttl=60, shared=store, secret='other')
+        store.set(key, '{}:{}'.format(other._mac('forged', entry), entry).encode('utf-8'), 60)
+        self.assertIsNone(cache.get('forged'))
+
+        # an entry copied from another token is rejected
+        cache.put('token', 'user', '127.0.0.1', time.time() + 60)
+        store.set(key, store.get(TokenCache._shared_key('token')), 60)
+        self.assertIsNone(cache.get('forged'))
@@ -0,0 +1,120 @@
+import unittest
+from unittest import mock
+from sal.core.object import Branch
+from sal.dataclass import *
+from sal.server.events import EventBus
+from sal.server.proxy import ObservedPersistence
+from sal.server.providers.memory import MemoryPersistence
+
+
+class TestEventBus(unittest.TestCase):
+
+    def setUp(self):
+
+        self.store = MemoryPersistence()
+        self.bus = EventBus(self.store, history=8, backlog=8, poll_interval=0)
+        self.provider = ObservedPersistence(self.store, [self.bus])
+
+        self.provider.put('/pulse', Branch('Pulse.'))
+        self.provider.put('/pulsed', Branch('Not below /pulse.'))
+
+    def _drain(self, subscription):
+
+        events = []
+        event = subscription.next(0)
+        while event is not None:
+            events.append((event['operation'], event['path'], event['revision']))
+            event = subscription.next(0)
+        return events
+
+    def test_publish(self):
+
+        subscription = self.bus.subscribe(['/pulse'])
+        self.provider.put('/pulse/gain', Scalar(2.0))
+        self.provider.put('/pulsed/gain', Scalar(1.0))
+        self.provider.copy('/pulse/copy', '/pulsed')
+        self.provider.put_many([('/pulse/a', Scalar(1.0)), ('/pulse/b', Scalar(2.0))])
+        self.provider.delete('/pulse')
+
+        head = self.provider.list('/').revision_latest
+        self.assertEqual(self._drain(subscription), [
+            ('put', '/pulse/gain', head - 4),
+            ('copy', '/pulse/copy', head - 2),
+            ('put', '/pulse/a', head - 1),
+            ('put', '/pulse/b', head - 1),
+            ('delete', '/pulse', head)
+        ])
+
+        subscription.close()
+        self.provider.put('/pulse', Branch('Pulse.'))
+        self.assertEqual(self._drain(subscription), [])
+
+    def test_proxy(self):
+
+        # the provider is not modified, the revision is read from the written node rather than the root
+        self.assertNotIn('put', vars(self.store))
+        subscription = self.bus.subscribe(['/'])
+        with mock.patch.object(self.store, 'list', wraps=self.store.list) as listed:
+            self.provider.put('/pulse/gain', Scalar(2.0))
+        self.assertEqual(listed.call_args_list, [mock.call('/pulse/gain')])
+        self.assertEqual(self._drain(subscription), [('put', '/pulse/gain', self.store.list('/').revision_latest)])
+
+    def test_resume(self):
+
+        subscription = self.bus.subscribe(['/'])
+        self.provider.put('/pulse/a', Scalar(1.0))
+        last = subscription.next(0)['id']
+        subscription.close()
+
+        # retained events following the last event are delivered
+        self.provider.put('/pulse/b', Scalar(1.0))
+        subscription = self.bus.subscribe(['/'], last)
+        self.assertEqual([path for _, path, _ in self._drain(subscription)], ['/pulse/b'])
+        subscription.close()
+
+        # missed events that are no longer retained or unknown ids cause a reset
+        for index in range(10):
+            self.provider.put('/pulse/c', Scalar(float(index)))
+
+        for last_id in [last, 'unknown-1']:
+            subscription = self.bus.subscribe(['/'], last_id)
+            self.assertEqual([operation for operation, _, _ in self._drain(subscription)], ['reset'])
+            subscription.close()
+
+    def test_backlog(self):
+
+        # a subscriber that does not keep up is reset and unsubscribed
+        subscription = self.bus.subscribe(['/'])
+        for index in range(9):
+            self.provider.put('/pulse/a', Scalar(float(index)))
+
+        self.assertTrue(subscription.closed)
+        self.assertEqual([operation for operation, _, _ in self._drain(subscription)], ['reset'])
+
+    def test_poll(self):
+
+        subscription = self.bus.subscribe(['/pulse'])
+        self.bus.poll()
+        self.assertEqual(self._drain(subscription), [])
+
+        # writes not made through the bus are reported as a revision change
+        self.store.put('/untracked', Scalar(1.0))
+        self.bus.poll()
+        self.assertEqual(self._drain(subscription), [('revision', None, self.store.list('/').revision_latest)])
+
+        # the tree is listed at most once per poll interval
+        self.bus.poll_interval = 60
+        self.store.put('/untracked', Scalar(2.0))
+        self.bus.poll()
+        self.assertEqual(self._drain(subscription), [])
+
+    def test_subscribe(self):
+
+        for paths in [['pulse'], ['/pulse:1']]:
+            with self.assertRaises(ValueError):
+                self.bus.subscribe(paths)
+
+        self.bus.max_subscribers = 1
+        self.bus.subscribe(['/'])
+        with self.assertRaises(OverflowError):
+            self.bus.subscribe(['/'])
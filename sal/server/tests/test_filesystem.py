@@ -0,0 +1,300 @@
+import io
+import os
+import shutil
+import tempfile
+import unittest
+import numpy as np
+from sal.core.exception import NodeNotFound, InvalidPath, InvalidRequest
+from sal.core.object import Branch, BranchReport, LeafReport, TreeReport
+from sal.core.serialise import serialise, encode_binary, EnvelopeReader
+from sal.dataclass import *
+from sal.server.providers.filesystem import FilesystemPersistence
+
+
+class TestFilesystemPersistence(unittest.TestCase):
+
+    def setUp(self):
+
+        self.path = tempfile.mkdtemp()
+        self.provider = FilesystemPersistence(self.path)
+
+        self.array = Array(
+            shape=(100, 3),
+            data=np.arange(300, dtype=np.float64).reshape(100, 3),
+            dtype=np.float64,
+            description='A test array.'
+        )
+
+    def tearDown(self):
+        shutil.rmtree(self.path)
+
+    def test_put_get(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/array', self.array)
+
+        report = self.provider.list('/')
+        self.assertIsInstance(report, BranchReport)
+        self.assertEqual(report.branches, ('a',))
+
+        report = self.provider.list('/a')
+        self.assertEqual([name for name, _ in report.leaves], ['array'])
+        self.assertEqual(report.leaves[0][1].cls, 'array')
+
+        report = self.provider.list('/a/array')
+        self.assertIsInstance(report, LeafReport)
+        self.assertEqual(report.revision_latest, 3)
+
+        b = self.provider.get('/a')
+        self.assertEqual(b.description, 'Branch a.')
+
+        a = self.provider.get('/a/array')
+        self.assertEqual(a.description, 'A test array.')
+        np.testing.assert_array_equal(a.data, self.array.data)
+
+        s = self.provider.get('/a/array', summary=True)
+        self.assertIsInstance(s, ArraySummary)
+
+        # missing parent
+        with self.assertRaises(NodeNotFound):
+            self.provider.put('/b/array', self.array)
+
+        # writes to an explicit revision
+        with self.assertRaises(InvalidPath):
+            self.provider.put('/a/array:2', self.array)
+
+    def test_revisions(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/a/scalar', Scalar(2.0))
+
+        self.assertEqual(self.provider.get('/a/scalar').value, 2.0)
+        self.assertEqual(self.provider.get('/a/scalar:3').value, 1.0)
+        self.assertEqual(self.provider.list('/a/scalar').revision_modified, [3, 4])
+
+        # node did not exist
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar:2')
+
+        # revision does not exist
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar:5')
+
+        # the object is returned with its revision and the revision in which it was last modified
+        self.provider.put('/a/other', Scalar(3.0))
+        obj, revision, modified = self.provider.get_versioned('/a/scalar')
+        self.assertEqual((obj.value, revision, modified), (2.0, 5, 4))
+        obj, revision, modified = self.provider.get_versioned('/a/scalar:3')
+        self.assertEqual((obj.value, revision, modified), (1.0, 3, 3))
+        self.assertIsInstance(self.provider.get_versioned('/a/scalar', summary=True)[0], ScalarSummary)
+
+        # deleted subtree remains in history
+        self.provider.delete('/a')
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar')
+        self.assertEqual(self.provider.list('/').branches, ())
+        self.assertEqual(self.provider.get('/a/scalar:4').value, 2.0)
+
+        # recreated branches do not resurrect deleted children
+        self.provider.put('/a', Branch('New branch a.'))
+        self.assertEqual(self.provider.list('/a').leaves, ())
+
+        with self.assertRaises(InvalidRequest):
+            self.provider.delete('/')
+
+    def test_copy(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/array', self.array)
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/b', Branch('Branch b.'))
+
+        self.provider.copy('/b/c', '/a')
+        report = self.provider.list('/b/c')
+        self.assertEqual(report.description, 'Branch a.')
+        self.assertEqual([name for name, _ in report.leaves], ['array', 'scalar'])
+        np.testing.assert_array_equal(self.provider.get('/b/c/array').data, self.array.data)
+
+        # restore an earlier revision of a node
+        self.provider.put('/a/scalar', Scalar(2.0))
+        self.provider.copy('/a/scalar', '/a/scalar:5')
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+
+        # copy into the source subtree
+        self.provider.copy('/a/copy', '/a')
+        self.assertEqual(self.provider.list('/a/copy').branches, ())
+        self.assertEqual(self.provider.get('/a/copy/scalar').value, 1.0)
+
+    def test_put_many(self):
+
+        self.provider.put_many([
+            ('/a', Branch('Branch a.')),
+            ('/a/array', self.array),
+            ('/a/b', Branch('Branch b.')),
+            ('/a/b/scalar', Scalar(1.0))
+        ])
+
+        # all the nodes are written in a single revision
+        self.assertEqual(self.provider.list('/').revision_latest, 2)
+        self.assertEqual(self.provider.list('/a/b/scalar').revision_modified, [2])
+        np.testing.assert_array_equal(self.provider.get('/a/array').data, self.array.data)
+
+        # a failed item discards the whole batch
+        with self.assertRaises(NodeNotFound):
+            self.provider.put_many([
+                ('/a/b/scalar', Scalar(2.0)),
+                ('/c', Branch('Branch c.')),
+                ('/missing/scalar', Scalar(3.0))
+            ])
+
+        self.assertEqual(self.provider.list('/').revision_latest, 2)
+        self.assertEqual(self.provider.get('/a/b/scalar').value, 1.0)
+
+        self.provider.put('/d', Branch('Branch d.'))
+        self.assertEqual(self.provider.list('/').branches, ('a', 'd'))
+        self.assertEqual(self.provider.list('/a/b/scalar').revision_modified, [2])
+
+    def test_deduplication(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/array', self.array)
+        stored = self._blob_count()
+
+        # identical objects and copies do not store any data
+        self.provider.put('/a/array', self.array)
+        self.provider.put('/a/duplicate', self.array)
+        self.provider.copy('/b', '/a')
+        self.assertEqual(self._blob_count(), stored)
+
+        # a changed description only stores a new manifest and summary
+        self.array.description = 'A modified array.'
+        self.provider.put('/a/array', self.array)
+        self.assertEqual(self._blob_count(), stored + 2)
+        self.assertEqual(self.provider.get('/b/array').description, 'A test array.')
+
+    def test_stored_summary(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/array', self.array)
+
+        # summaries must be served without loading the object
+        def load(manifest):
+            raise AssertionError('The object was loaded for a summary request.')
+        self.provider._load = load
+
+        summary = self.provider.get('/a/array', summary=True)
+        self.assertIsInstance(summary, ArraySummary)
+        self.assertEqual(summary.description, 'A test array.')
+        self.assertEqual(summary.shape, self.array.data.shape)
+
+    def test_interrupted_write(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+
+        # a writer that dies before writing the head leaves entries for the next revision
+        with open(os.path.join(self.path, 'journal'), 'w') as journal:
+            self.provider._append(self.provider._node_dir(['a']), self.provider._branch_entry(3, Branch('Stale a.')), journal)
+            self.provider._append(self.provider._node_dir(['b']), self.provider._branch_entry(3, Branch('Stale b.')), journal)
+
+        # readers ignore the uncommitted entries
+        self.assertEqual(self.provider.list('/').branches, ('a',))
+        self.assertEqual(self.provider.list('/a').revision_modified, [2])
+
+        # the next writer removes them before reusing the revision
+        self.provider.put('/c', Branch('Branch c.'))
+        self.assertEqual(self.provider.list('/').revision_latest, 3)
+        self.assertEqual(self.provider.list('/').branches, ('a', 'c'))
+        self.assertEqual(self.provider.get('/a').description, 'Branch a.')
+        self.assertEqual(self.provider.list('/a').revision_modified, [2])
+        self.assertFalse(os.path.exists(os.path.join(self.path, 'journal')))
+
+    def test_list_tree(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/a/b', Branch('Branch b.'))
+        self.provider.put('/a/b/c', Branch('Branch c.'))
+        self.provider.put('/a/b/c/scalar', Scalar(2.0))
+
+        # a depth of 1 describes the branch only
+        tree = self.provider.list_tree('/', depth=1)
+        self.assertIsInstance(tree, TreeReport)
+        self.assertEqual(tree.report.branches, ('a',))
+        self.assertEqual(tree.children, {})
+
+        tree = self.provider.list_tree('/a', depth=2)
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'b'])
+        self.assertEqual([name for name, _ in tree.report.leaves], ['scalar'])
+        self.assertEqual(tree.children['b'].children, {})
+
+        # the full subtree, described at the requested revision
+        tree = self.provider.list_tree('/')
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'a', 'a/b', 'a/b/c'])
+        self.assertEqual([name for name, _ in tree.children['a'].children['b'].children['c'].report.leaves], ['scalar'])
+
+        tree = self.provider.list_tree('/:4')
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'a', 'a/b'])
+        self.assertTrue(all(report.revision_current == 4 for _, report in tree.walk()))
+
+        self.assertIsInstance(self.provider.list_tree('/a/scalar'), LeafReport)
+
+        with self.assertRaises(NodeNotFound):
+            self.provider.list_tree('/missing')
+
+    def test_failed_delete_copy(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/b', Branch('Branch b.'))
+
+        # fail the second node entry written by each operation
+        append = self.provider._append
+        calls = []
+
+        def failing(directory, entry, journal=None):
+            calls.append(directory)
+            if len(calls) % 2 == 0:
+                raise OSError('Disk full.')
+            append(directory, entry, journal)
+
+        self.provider._append = failing
+
+        with self.assertRaises(OSError):
+            self.provider.delete('/a')
+
+        with self.assertRaises(OSError):
+            self.provider.copy('/b', '/a')
+
+        del self.provider._append
+
+        # the failed operations leave no entries behind
+        self.assertEqual(self.provider.list('/').revision_latest, 4)
+        self.provider.put('/c', Branch('Branch c.'))
+        self.assertEqual(self.provider.list('/').branches, ('a', 'b', 'c'))
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+        self.assertEqual(self.provider.list('/b').leaves, ())
+        self.assertEqual(self.provider.list('/b').revision_modified, [4])
+
+    def _blob_count(self):
+        return sum(len(files) for _, _, files in os.walk(os.path.join(self.path, 'blobs')))
+
+    def test_put_stream(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+
+        buffers = []
+        document = serialise(self.array, buffers)
+        self.provider.put_stream('/a/array', EnvelopeReader(io.BytesIO(encode_binary(document, buffers))))
+        np.testing.assert_array_equal(self.provider.get('/a/array').data, self.array.data)
+
+        document = serialise(Branch('Branch b.'))
+        self.provider.put_stream('/b', EnvelopeReader(io.BytesIO(encode_binary(document, []))))
+        self.assertEqual(self.provider.get('/b').description, 'Branch b.')
+
+    def test_reopen(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        provider = FilesystemPersistence(self.path)
+        self.assertEqual(provider.list('/').revision_latest, 2)
+        self.assertEqual(provider.get('/a').description, 'Branch a.')
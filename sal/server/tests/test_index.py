@@ -0,0 +1,95 @@
+import time
+import unittest
+from unittest import mock
+import numpy as np
+from sal.core.exception import InvalidRequest
+from sal.core.object import Branch, LeafReport
+from sal.dataclass import *
+from sal.server.index import MetadataIndex, DEFAULT_REFRESH_INTERVAL
+from sal.server.proxy import ObservedPersistence
+from sal.server.providers.memory import MemoryPersistence
+
+
+class TestMetadataIndex(unittest.TestCase):
+
+    def setUp(self):
+
+        self.store = MemoryPersistence()
+        self.index = MetadataIndex(self.store)
+        self.provider = ObservedPersistence(self.store, [self.index])
+
+        self.provider.put('/pulse', Branch('Pulse.'))
+        self.provider.put('/pulse/voltage', self._signal('V', temporal=True))
+        self.provider.put('/pulse/current', self._signal('A', temporal=True))
+        self.provider.put('/pulse/profile', self._signal('V', temporal=False))
+        self.provider.put('/pulse/gain', Scalar(2.0))
+        self.provider.put('/pulsed', Branch('Not below /pulse.'))
+        self.provider.put('/pulsed/voltage', self._signal('V', temporal=True))
+
+    @staticmethod
+    def _signal(units, temporal):
+        return Signal(
+            dimensions=[CalculatedDimension(length=5, start=0.0, step=0.1, units='s', temporal=temporal)],
+            data=np.arange(5, dtype=np.float64),
+            dtype=np.float64,
+            units=units
+        )
+
+    def _search(self, *args, **kwargs):
+        return [path for path, _ in self.index.search(*args, **kwargs)]
+
+    def test_search(self):
+
+        self.assertEqual(self._search('/pulse', cls='signal'), ['/pulse/current', '/pulse/profile', '/pulse/voltage'])
+        self.assertEqual(self._search('/', metadata={'units': 'V'}), ['/pulse/profile', '/pulse/voltage', '/pulsed/voltage'])
+        self.assertEqual(self._search('/pulse', metadata={'units': 'V', 'dimensions/*/temporal': True}), ['/pulse/voltage'])
+        self.assertEqual(self._search('/', cls='scalar', group='core'), ['/pulse/gain'])
+        self.assertEqual(self._search('/', cls='signal', limit=1), ['/pulse/current'])
+        self.assertEqual(self._search('/pulse/gain'), ['/pulse/gain'])
+
+        _, report = self.index.search('/pulse/gain')[0]
+        self.assertIsInstance(report, LeafReport)
+        self.assertEqual(report.cls, 'scalar')
+        self.assertEqual(report.revision_current, self.provider.list('/').revision_latest)
+
+        for criteria in [{'path': 'pulse'}, {'path': '/pulse:2'}, {'metadata': {'units': ['V']}}, {'limit': 0}]:
+            with self.assertRaises(InvalidRequest):
+                self.index.search(**criteria)
+
+    def test_update(self):
+
+        self.index.search()
+        revision = self.index.revision
+
+        # writes through the provider update the index in place
+        self.provider.put('/pulse/voltage', self._signal('mV', temporal=True))
+        self.assertEqual(self.index.revision, revision + 1)
+        self.assertEqual(self._search('/pulse', metadata={'units': 'mV'}), ['/pulse/voltage'])
+
+        self.provider.copy('/copy', '/pulse')
+        self.assertEqual(self._search('/copy', cls='signal'), ['/copy/current', '/copy/profile', '/copy/voltage'])
+
+        self.provider.delete('/pulse')
+        self.assertEqual(self._search('/pulse'), [])
+        self.assertEqual(self.index.revision, revision + 3)
+
+        # writes not seen by the index cause a rebuild once the refresh interval has elapsed
+        self.store.put('/untracked', Scalar(1.0))
+        self.assertEqual(self._search('/', cls='scalar'), ['/copy/gain'])
+        with mock.patch('sal.server.index.time.monotonic', return_value=time.monotonic() + DEFAULT_REFRESH_INTERVAL):
+            self.assertEqual(self._search('/', cls='scalar'), ['/copy/gain', '/untracked'])
+        self.assertEqual(self.index.revision, self.provider.list('/').revision_latest)
+
+    def test_head(self):
+
+        self.index.search()
+        revision = self.index.revision
+
+        # the head revision is tracked from the writes, searches and writes do not list the root node
+        self.assertNotIn('put', vars(self.store))
+        with mock.patch.object(self.store, 'list', wraps=self.store.list) as listed:
+            self.provider.put('/pulse/gain', Scalar(3.0))
+            self.assertEqual(self._search('/', cls='scalar'), ['/pulse/gain'])
+            self.assertEqual(self.index.revision, revision + 1)
+            self.assertNotIn(mock.call('/'), listed.call_args_list)
+
@@ -0,0 +1,244 @@
+import unittest
+import numpy as np
+from sal.core.exception import NodeNotFound, InvalidPath, InvalidRequest
+from sal.core.object import Branch, BranchReport, LeafReport, TreeReport
+from sal.dataclass import *
+from sal.server.providers.memory import MemoryPersistence, CachedPersistence, MemoryStore
+
+
+class TestMemoryPersistence(unittest.TestCase):
+
+    def setUp(self):
+        self.provider = MemoryPersistence()
+
+    def test_put_get(self):
+
+        array = Array(shape=(10,), data=np.arange(10, dtype=np.float64), dtype=np.float64)
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/array', array)
+
+        report = self.provider.list('/a')
+        self.assertIsInstance(report, BranchReport)
+        self.assertEqual([name for name, _ in report.leaves], ['array'])
+        self.assertIsInstance(self.provider.list('/a/array'), LeafReport)
+
+        # the stored object is a copy
+        array.data[0] = 100
+        self.assertEqual(self.provider.get('/a/array').data[0], 0)
+        self.assertIsInstance(self.provider.get('/a/array', summary=True), ArraySummary)
+
+        with self.assertRaises(NodeNotFound):
+            self.provider.put('/b/array', array)
+
+        with self.assertRaises(InvalidPath):
+            self.provider.put('/a/array:2', array)
+
+    def test_revisions(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/a/scalar', Scalar(2.0))
+
+        self.assertEqual(self.provider.get('/a/scalar').value, 2.0)
+        self.assertEqual(self.provider.get('/a/scalar:3').value, 1.0)
+        self.assertEqual(self.provider.list('/a/scalar').revision_modified, [3, 4])
+
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar:5')
+
+        # the object is returned with its revision and the revision in which it was last modified
+        self.provider.put('/a/other', Scalar(3.0))
+        obj, revision, modified = self.provider.get_versioned('/a/scalar')
+        self.assertEqual((obj.value, revision, modified), (2.0, 5, 4))
+        obj, revision, modified = self.provider.get_versioned('/a/scalar:3')
+        self.assertEqual((obj.value, revision, modified), (1.0, 3, 3))
+        self.assertIsInstance(self.provider.get_versioned('/a/scalar', summary=True)[0], ScalarSummary)
+
+        self.provider.delete('/a')
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar')
+        self.assertEqual(self.provider.get('/a/scalar:4').value, 2.0)
+
+        with self.assertRaises(InvalidRequest):
+            self.provider.delete('/')
+
+    def test_copy(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.copy('/b', '/a')
+        self.assertEqual(self.provider.get('/b/scalar').value, 1.0)
+
+        # copy into the source subtree
+        self.provider.copy('/a/copy', '/a')
+        self.assertEqual(self.provider.list('/a/copy').branches, ())
+        self.assertEqual(self.provider.get('/a/copy/scalar').value, 1.0)
+
+    def test_put_many(self):
+
+        self.provider.put_many([
+            ('/a', Branch('Branch a.')),
+            ('/a/scalar', Scalar(1.0))
+        ])
+        self.assertEqual(self.provider.list('/').revision_latest, 2)
+
+        # a failed item discards the whole batch
+        with self.assertRaises(NodeNotFound):
+            self.provider.put_many([
+                ('/a/scalar', Scalar(2.0)),
+                ('/missing/scalar', Scalar(3.0))
+            ])
+
+        self.assertEqual(self.provider.list('/').revision_latest, 2)
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+
+    def test_list_tree(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/a/b', Branch('Branch b.'))
+        self.provider.put('/a/b/c', Branch('Branch c.'))
+        self.provider.put('/a/b/c/scalar', Scalar(2.0))
+
+        # a depth of 1 describes the branch only
+        tree = self.provider.list_tree('/', depth=1)
+        self.assertIsInstance(tree, TreeReport)
+        self.assertEqual(tree.report.branches, ('a',))
+        self.assertEqual(tree.children, {})
+
+        tree = self.provider.list_tree('/a', depth=2)
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'b'])
+        self.assertEqual([name for name, _ in tree.report.leaves], ['scalar'])
+        self.assertEqual(tree.children['b'].children, {})
+
+        # the full subtree, described at the requested revision
+        tree = self.provider.list_tree('/')
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'a', 'a/b', 'a/b/c'])
+        self.assertEqual([name for name, _ in tree.children['a'].children['b'].children['c'].report.leaves], ['scalar'])
+
+        tree = self.provider.list_tree('/:4')
+        self.assertEqual([path for path, _ in tree.walk()], ['', 'a', 'a/b'])
+        self.assertTrue(all(report.revision_current == 4 for _, report in tree.walk()))
+
+        self.assertIsInstance(self.provider.list_tree('/a/scalar'), LeafReport)
+
+        with self.assertRaises(NodeNotFound):
+            self.provider.list_tree('/missing')
+
+    def test_failed_delete_copy(self):
+
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+        self.provider.put('/b', Branch('Branch b.'))
+
+        # fail the second node entry written by each operation
+        append = self.provider._append
+        calls = []
+
+        def failing(node, entry, journal=None):
+            calls.append(node)
+            if len(calls) % 2 == 0:
+                raise RuntimeError
+            append(node, entry, journal)
+
+        self.provider._append = failing
+
+        with self.assertRaises(RuntimeError):
+            self.provider.delete('/a')
+
+        with self.assertRaises(RuntimeError):
+            self.provider.copy('/b', '/a')
+
+        del self.provider._append
+
+        # the failed operations leave no entries behind
+        self.assertEqual(self.provider.list('/').revision_latest, 4)
+        self.provider.put('/c', Branch('Branch c.'))
+        self.assertEqual(self.provider.list('/').branches, ('a', 'b', 'c'))
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+        self.assertEqual(self.provider.list('/b').leaves, ())
+        self.assertEqual(self.provider.list('/b').revision_modified, [4])
+
+
+class _CountingProvider(MemoryPersistence):
+
+    def __init__(self):
+        super().__init__()
+        self.gets = 0
+
+    def get(self, path, summary=False, group=None):
+        self.gets += 1
+        return super().get(path, summary, group)
+
+
+class TestCachedPersistence(unittest.TestCase):
+
+    def setUp(self):
+        self.backend = _CountingProvider()
+        self.provider = CachedPersistence(self.backend, size=100 * 1024)
+        self.provider.put('/a', Branch('Branch a.'))
+        self.provider.put('/a/scalar', Scalar(1.0))
+
+    def test_hit(self):
+
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+        self.assertEqual(self.provider.get('/a/scalar').value, 1.0)
+        self.assertEqual(self.provider.get_many(['/a/scalar', '/a/missing'])[0].value, 1.0)
+        self.assertEqual(self.backend.gets, 2)
+        self.assertEqual(self.provider.hits, 2)
+
+    def test_invalidation(self):
+
+        self.provider.get('/a/scalar')
+        self.provider.get('/a/scalar:3')
+
+        # head objects are discarded when the node or an ancestor is written
+        self.provider.put('/a/scalar', Scalar(2.0))
+        self.assertEqual(self.provider.get('/a/scalar').value, 2.0)
+
+        self.provider.put('/b', Branch('Branch b.'))
+        self.provider.put('/b/scalar', Scalar(3.0))
+        self.provider.copy('/a', '/b')
+        self.assertEqual(self.provider.get('/a/scalar').value, 3.0)
+
+        self.provider.delete('/a')
+        with self.assertRaises(NodeNotFound):
+            self.provider.get('/a/scalar')
+
+        # explicit revisions never change
+        gets = self.backend.gets
+        self.assertEqual(self.provider.get('/a/scalar:3').value, 1.0)
+        self.assertEqual(self.backend.gets, gets)
+
+    def test_eviction(self):
+
+        # each array is 40KB, only two fit in the cache
+        for index in range(3):
+            self.provider.put('/a/array_{}'.format(index), Array(shape=(5000,), data=np.zeros(5000)))
+            self.provider.get('/a/array_{}'.format(index))
+
+        gets = self.backend.gets
+        self.provider.get('/a/array_2')
+        self.assertEqual(self.backend.gets, gets)
+        self.provider.get('/a/array_0')
+        self.assertEqual(self.backend.gets, gets + 1)
+
+    def test_shared(self):
+
+        # explicit revision objects read by one process are served to the others by the shared store
+        store = MemoryStore()
+        first = CachedPersistence(self.backend, size=100 * 1024, shared=store)
+        second = CachedPersistence(self.backend, size=100 * 1024, shared=store)
+
+        path = '/a/scalar:{}'.format(self.backend.list('/').revision_latest)
+        self.assertEqual(first.get(path).value, 1.0)
+
+        gets = self.backend.gets
+        self.assertEqual(second.get(path).value, 1.0)
+        self.assertEqual(second.get_many([path])[0].value, 1.0)
+        self.assertEqual(self.backend.gets, gets)
+
+        # head revision objects are not shared
+        first.get('/a/scalar')
+        second.get('/a/scalar')
+        self.assertEqual(self.backend.gets, gets + 2)
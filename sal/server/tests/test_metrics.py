@@ -0,0 +1,66 @@
+import unittest
+from sal.server.metrics import Metrics, instrument
+
+
+class _Provider:
+
+    NAME = 'Test'
+
+    def __init__(self):
+        self.proxy = None
+
+    def get(self, path, summary=False):
+        if path == '/missing':
+            raise KeyError(path)
+        return path
+
+    def get_many(self, paths, summary=False):
+        # calls back into the proxy, as a provider wrapping the proxy would
+        return [self.proxy.get(path, summary) for path in paths]
+
+
+class TestMetrics(unittest.TestCase):
+
+    def test_histogram(self):
+
+        metrics = Metrics(buckets=(0.1, 1.0))
+        labels = (('endpoint', 'datatree'), ('phase', 'serialise'))
+        metrics.observe('sal_request_phase_seconds', labels, 0.05)
+        metrics.observe('sal_request_phase_seconds', labels, 0.5)
+        metrics.observe('sal_request_phase_seconds', labels, 5.0)
+
+        report = metrics.render()
+        self.assertIn('# TYPE sal_request_phase_seconds histogram', report)
+        self.assertIn('sal_request_phase_seconds_bucket{endpoint="datatree",phase="serialise",le="0.1"} 1', report)
+        self.assertIn('sal_request_phase_seconds_bucket{endpoint="datatree",phase="serialise",le="1.0"} 2', report)
+        self.assertIn('sal_request_phase_seconds_bucket{endpoint="datatree",phase="serialise",le="+Inf"} 3', report)
+        self.assertIn('sal_request_phase_seconds_sum{endpoint="datatree",phase="serialise"} 5.55', report)
+        self.assertIn('sal_request_phase_seconds_count{endpoint="datatree",phase="serialise"} 3', report)
+
+    def test_counter(self):
+
+        metrics = Metrics()
+        metrics.increment('sal_response_bytes_total', (('endpoint', 'datatree'),), 100)
+        metrics.increment('sal_response_bytes_total', (('endpoint', 'datatree'),), 50)
+        self.assertIn('sal_response_bytes_total{endpoint="datatree"} 150', metrics.render())
+
+    def test_instrument(self):
+
+        metrics = Metrics()
+        provider = _Provider()
+        proxy = provider.proxy = instrument(provider, metrics)
+        self.assertEqual(proxy.get('/a'), '/a')
+        with self.assertRaises(KeyError):
+            proxy.get('/missing')
+
+        # the provider is not modified, other attributes are forwarded
+        self.assertNotIn('get', vars(provider))
+        self.assertEqual(proxy.NAME, 'Test')
+
+        # nested operations are not timed
+        self.assertEqual(proxy.get_many(['/a', '/b']), ['/a', '/b'])
+
+        report = metrics.render()
+        self.assertIn('sal_provider_seconds_count{operation="get"} 2', report)
+        self.assertIn('sal_provider_seconds_count{operation="get_many"} 1', report)
+        self.assertIn('sal_provider_errors_total{operation="get",exception="KeyError"} 1', report)